@@ -2,21 +2,60 @@
 #define ASTAR_PLANNER_ASTAR_H
 
 #include <astar_planner/costmap.h>
+#include <astar_planner/heuristic_table.h>
+#include <astar_planner/landmarks.h>
+#include <astar_planner/motion_primitives.h>
 #include <astar_planner/node.h>
+#include <astar_planner/node_arena.h>
+#include <astar_planner/parallel.h>
 #include <navigation_interface/path_planner.h>
 #include <ros/console.h>
 
 #include <algorithm>
+#include <chrono>
 #include <functional>
 #include <map>
+#include <memory>
 #include <queue>
 #include <set>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
 namespace astar_planner
 {
 
+enum class HeuristicMode
+{
+    // grow the 2D search on demand from the 3D search
+    LAZY,
+    // compute the 2D cost-to-go of the whole map before the 3D search
+    WAVEFRONT
+};
+
+// Direct moves from expanded nodes to the goal which end the search early if they are collision free
+// Tried every interval iterations and from every node whose cost-to-go is below heuristic_threshold, and only taken if
+// the path cost stays within cost_tolerance of the cost the search estimates through the node
+// An interval of 0 disables them
+struct AnalyticExpansionSettings
+{
+    std::size_t interval = 0;
+    double heuristic_threshold = 0.0;
+    double cost_tolerance = 1.1;
+};
+
+// Anytime Repairing A* (Likhachev, Gordon & Thrun)
+// The first search inflates the heuristic by initial_weight to find a path after few expansions, every following search
+// lowers the weight by weight_step and reuses the nodes of the searches before it, until the weight reaches 1 or the
+// deadline passes
+// The deadline applies to the first search as well, which also ends without a path after first_max_iterations
+struct AnytimeSettings
+{
+    double initial_weight = 2.0;
+    double weight_step = 0.5;
+    std::size_t first_max_iterations = 300000;
+};
+
 struct ShortestPath2D
 {
     bool success;
@@ -24,20 +63,242 @@ struct ShortestPath2D
     size_t iterations;
 };
 
-struct Explore2DCache
+// Dense storage for the nodes of the 2D search, indexed by Costmap::to2DGridIndex
+// A node is only valid while its stamp matches the current generation so reset() does not need to touch the nodes
+class Explore2DCache
 {
-    std::unordered_map<std::size_t, Node2D> explore_2d;
-    PriorityQueue2D* open_set;
+  public:
+    Explore2DCache()
+        : started(false), complete(false), goal{0, 0}, track_changes(false), all_changed(false), width_(0),
+          height_(0), generation_(0), uniform_generation_(0)
+    {
+    }
+
+    Explore2DCache(const Explore2DCache&) = delete;
+    Explore2DCache& operator=(const Explore2DCache&) = delete;
+
+    Explore2DCache(Explore2DCache&&) = default;
+    Explore2DCache& operator=(Explore2DCache&&) = default;
+
+    // Invalidates all nodes, only reallocating if the dimensions changed
+    void reset(const int width, const int height)
+    {
+        open_set.clear();
+        started = false;
+        complete = false;
+        cell_costs.clear();
+        searched_cells.clear();
+        changed_regions.clear();
+        all_changed = false;
+
+        const std::size_t size = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+        if (width != width_ || height != height_)
+        {
+            width_ = width;
+            height_ = height;
+            nodes_.reset(new Storage[size]);
+            stamps_.assign(size, 0);
+            generation_ = 0;
+
+            uniform_.assign((size + 63) / 64, 0);
+            uniform_stamps_.assign(static_cast<std::size_t>(uniformBlocksX() * uniformBlocksY()), 0);
+            uniform_generation_ = 0;
+        }
+
+        if (++generation_ == 0)
+        {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            generation_ = 1;
+        }
+
+        visited_.assign((size + 63) / 64, 0);
+
+        resetUniform();
+    }
+
+    int width() const
+    {
+        return width_;
+    }
+
+    int height() const
+    {
+        return height_;
+    }
+
+    std::size_t size() const
+    {
+        return stamps_.size();
+    }
 
-    Explore2DCache() : open_set(nullptr)
+    // bytes allocated for the nodes, the open set and the per cell state, without the landmarks
+    std::size_t memoryUsage() const
     {
+        return size() * sizeof(Storage) + open_set.memoryUsage() + stamps_.capacity() * sizeof(uint32_t) +
+               visited_.capacity() * sizeof(uint64_t) + uniform_.capacity() * sizeof(uint64_t) +
+               uniform_stamps_.capacity() * sizeof(uint32_t) + cell_costs.capacity() * sizeof(float) +
+               searched_cells.capacity() * sizeof(std::size_t) + changed_regions.capacity() * sizeof(cv::Rect);
     }
 
-    ~Explore2DCache()
+    std::size_t indexOf(const Node2D* node_2d) const
     {
-        if (open_set)
-            delete open_set;
+        return static_cast<std::size_t>(node_2d->state.y) * static_cast<std::size_t>(width_) +
+               static_cast<std::size_t>(node_2d->state.x);
     }
+
+    // Returns nullptr if the search has not reached the cell
+    Node2D* find(const std::size_t index) const
+    {
+        return stamps_[index] == generation_ ? node(index) : nullptr;
+    }
+
+    Node2D* insert(const std::size_t index, const Node2D& node_2d)
+    {
+        stamps_[index] = generation_;
+        return new (&nodes_[index]) Node2D(node_2d);
+    }
+
+    // The node must not be queued in the open set
+    void erase(const std::size_t index)
+    {
+        stamps_[index] = 0;
+        clearVisited(index);
+    }
+
+    bool visited(const std::size_t index) const
+    {
+        return (visited_[index >> 6] >> (index & 63)) & 1;
+    }
+
+    void setVisited(const std::size_t index)
+    {
+        visited_[index >> 6] |= uint64_t(1) << (index & 63);
+    }
+
+    void clearVisited(const std::size_t index)
+    {
+        visited_[index >> 6] &= ~(uint64_t(1) << (index & 63));
+    }
+
+    void setAllVisited()
+    {
+        std::fill(visited_.begin(), visited_.end(), ~uint64_t(0));
+    }
+
+    // A cell is uniform if it is free and has the same collision and traversal cost as every cell within reach of
+    // directions_2d. shortestPath2D classifies the cells a block at a time when it first reaches the block
+    static const int UNIFORM_BLOCK = 32;
+
+    bool uniformClassified(const State2D& cell) const
+    {
+        return uniform_stamps_[uniformBlock(cell)] == uniform_generation_;
+    }
+
+    void setUniformClassified(const State2D& cell)
+    {
+        uniform_stamps_[uniformBlock(cell)] = uniform_generation_;
+    }
+
+    bool uniform(const std::size_t index) const
+    {
+        return (uniform_[index >> 6] >> (index & 63)) & 1;
+    }
+
+    void setUniform(const std::size_t index, const bool uniform)
+    {
+        if (uniform)
+            uniform_[index >> 6] |= uint64_t(1) << (index & 63);
+        else
+            uniform_[index >> 6] &= ~(uint64_t(1) << (index & 63));
+    }
+
+    // Forgets the classification of every cell, for when the cell costs changed
+    void resetUniform()
+    {
+        if (++uniform_generation_ == 0)
+        {
+            std::fill(uniform_stamps_.begin(), uniform_stamps_.end(), 0);
+            uniform_generation_ = 1;
+        }
+    }
+
+    // Same for the blocks overlapping region only
+    void resetUniform(const cv::Rect& region)
+    {
+        if (region.area() <= 0)
+            return;
+
+        for (int y = region.y / UNIFORM_BLOCK; y <= (region.y + region.height - 1) / UNIFORM_BLOCK; ++y)
+            for (int x = region.x / UNIFORM_BLOCK; x <= (region.x + region.width - 1) / UNIFORM_BLOCK; ++x)
+                uniform_stamps_[static_cast<std::size_t>(y * uniformBlocksX() + x)] = 0;
+    }
+
+    // frontier of the search, kept between calls so the search can be resumed
+    PriorityQueue2D open_set;
+    bool started;
+
+    // set when wavefront2D filled in every cell, cells without a node were discarded since and are filled in again by
+    // the next wavefront2D call
+    bool complete;
+
+    // cell the search is rooted at
+    State2D goal;
+
+    // cost of entering each cell when the search was last updated, used to find the nodes invalidated by map changes
+    // empty unless the cache is reused between plans
+    std::vector<float> cell_costs;
+
+    // cells given a node by shortestPath2D, so updateExplore2DCache finds the nodes of a lazy search without scanning
+    // the map. Cells whose node was discarded since are left in and a cell can appear more than once
+    std::vector<std::size_t> searched_cells;
+
+    // set by an owner which keeps its costmap between plans and reports every change to it below, updateExplore2DCache
+    // then only compares the cells of the changed regions instead of the whole map
+    bool track_changes;
+
+    // regions of the costmap changed since the last updateExplore2DCache
+    // all_changed stands for changes without a region, such as a rebuilt costmap or new traversal costs
+    std::vector<cv::Rect> changed_regions;
+    bool all_changed;
+
+    // raise the heuristic of the search to the ALT bound when set, kept by reset()
+    std::shared_ptr<const Landmarks> landmarks;
+
+  private:
+    typedef std::aligned_storage<sizeof(Node2D), alignof(Node2D)>::type Storage;
+
+    Node2D* node(const std::size_t index) const
+    {
+        return reinterpret_cast<Node2D*>(&nodes_[index]);
+    }
+
+    int uniformBlocksX() const
+    {
+        return (width_ + UNIFORM_BLOCK - 1) / UNIFORM_BLOCK;
+    }
+
+    int uniformBlocksY() const
+    {
+        return (height_ + UNIFORM_BLOCK - 1) / UNIFORM_BLOCK;
+    }
+
+    std::size_t uniformBlock(const State2D& cell) const
+    {
+        return static_cast<std::size_t>((cell.y / UNIFORM_BLOCK) * uniformBlocksX() + cell.x / UNIFORM_BLOCK);
+    }
+
+    int width_;
+    int height_;
+
+    uint32_t generation_;
+    std::unique_ptr<Storage[]> nodes_;
+    std::vector<uint32_t> stamps_;
+    std::vector<uint64_t> visited_;
+
+    // the classification of the cells of a block is only valid while its stamp matches
+    uint32_t uniform_generation_;
+    std::vector<uint64_t> uniform_;
+    std::vector<uint32_t> uniform_stamps_;
 };
 
 double collisionCost(const int map_x, const int map_y, const CollisionChecker& collision_checker);
@@ -47,20 +308,19 @@ double rotationCollisionCost(const double distance_to_collision_m);
 double traversalCost(const int map_x, const int map_y, const Costmap& costmap);
 
 ShortestPath2D shortestPath2D(const State2D& start, const State2D& goal, Explore2DCache& explore_cache,
-                              const Costmap& costmap, const double conservative_radius);
+                              const CollisionChecker& collision_checker);
+
+// Same rooted at all of goals, the cost of a cell is that of reaching the cheapest of them
+ShortestPath2D shortestPath2D(const State2D& start, const std::vector<State2D>& goals, Explore2DCache& explore_cache,
+                              const CollisionChecker& collision_checker);
 
 struct PathResult
 {
-    PathResult() : success(false), iterations(0), start_in_collision(false), goal_in_collision(false)
-    {
-    }
-
-    ~PathResult()
+    PathResult()
+        : success(false), iterations(0), start_in_collision(false), goal_in_collision(false), analytic_expansions(0),
+          analytic_success(false), searches(0), weight(1.0), out_of_time(false), collision_checks(0),
+          collision_checks_saved(0)
     {
-        for (auto it = explore_3d.begin(); it != explore_3d.end(); ++it)
-        {
-            delete (it->second);
-        }
     }
 
     Eigen::Isometry2d start;
@@ -74,19 +334,116 @@ struct PathResult
 
     std::vector<Node3D*> path;
 
-    Explore2DCache explore_cache;
+    // may be shared with later plans to the same goal
+    std::shared_ptr<Explore2DCache> explore_cache;
 
-    std::unordered_map<uint64_t, Node3D*> explore_3d;
+    // nodes live in an arena owned by the map and are all released with the result
+    NodeIndexMap<Node3D> explore_3d;
+
+    // attempted analytic expansions, and whether one of them reached the goal
+    std::size_t analytic_expansions;
+    bool analytic_success;
+
+    // the samples along the successful analytic expansion, off the lattice so they are not part of explore_3d
+    NodeArena<Node3D, 256> analytic_nodes;
+
+    // searches run by an anytime search, and the heuristic weight of the one which found the path
+    std::size_t searches;
+    double weight;
+
+    // an anytime search whose deadline passed before it found a path
+    bool out_of_time;
+
+    // the path of an anytime search, copied out of explore_3d as the searches after it change the nodes
+    NodeArena<Node3D, 256> path_nodes;
+
+    // footprint collision checks of successors, and with lazy evaluation the successors which were never checked: those
+    // which were not cheaper than the state of their node, were replaced by a cheaper one or were known to be in
+    // collision before they reached the top of the open set, and those still queued at the end
+    std::size_t collision_checks;
+    std::size_t collision_checks_saved;
 };
 
-double updateH(const State2D& state, const State2D& goal, Explore2DCache& explore_cache, const Costmap& costmap,
-               const double conservative_radius);
+double updateH(const State2D& state, const State2D& goal, Explore2DCache& explore_cache,
+               const CollisionChecker& collision_checker);
+
+double updateH(const State2D& state, const std::vector<State2D>& goals, Explore2DCache& explore_cache,
+               const CollisionChecker& collision_checker);
+
+// Cost of entering each cell in the 2D search, infinite for cells the robot cannot be in
+void cellCosts2D(const CollisionChecker& collision_checker, std::vector<float>& cell_costs);
+
+// Same as above for the cells in region only, cell_costs must already hold the whole map
+void cellCosts2D(const CollisionChecker& collision_checker, const cv::Rect& region, std::vector<float>& cell_costs);
+
+// Prepares explore_cache for a search rooted at goal
+// If the cache already holds a search for the same goal, the nodes whose cost may have changed with the costmap are
+// discarded and the search frontier is re-seeded around them, otherwise the cache is reset
+// Only the changed regions of a cache tracking its changes are compared, otherwise the whole map is
+// Returns the number of discarded nodes
+std::size_t updateExplore2DCache(Explore2DCache& explore_cache, const State2D& goal,
+                                 const CollisionChecker& collision_checker);
+
+// Cost of following path, max if any node is in collision
+double pathCost(const navigation_interface::Path& path, const CollisionChecker& collision_checker,
+                const double backwards_mult, const double strafe_mult, const double rotation_mult);
+
+// Optional inputs of a search, the defaults leave all of them out
+struct SearchOptions
+{
+    // the 2D search of earlier plans to the same goal, reused and updated by the search if given
+    std::shared_ptr<Explore2DCache> explore_cache;
+
+    HeuristicMode heuristic_mode = HeuristicMode::LAZY;
+
+    // built from the resolutions and the offsets of the collision checker if not given
+    std::shared_ptr<const MotionPrimitives> motion_primitives;
+
+    // With a pool of more than one thread the successors of the nodes at the top of the open set are evaluated in
+    // parallel ahead of their expansion. The pool is kept by the caller across searches
+    // The result does not depend on the number of threads
+    std::shared_ptr<ThreadPool> thread_pool;
+
+    AnalyticExpansionSettings analytic_expansion;
+
+    // Lazy Weighted A* (Cohen, Phillips & Likhachev): successors are queued with the cost of the move without
+    // obstacles and a lower bound of their heuristic, the straight line over cells of costmap.min_traversal_cost.
+    // Their footprint is only checked and their costs only computed once they reach the top of the open set
+    bool lazy_evaluation = false;
+
+    // raises the heuristic near the goal to the obstacle free cost of reaching the goal heading
+    std::shared_ptr<const HeuristicTable> heuristic_table;
+};
 
 PathResult hybridAStar(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal, const size_t max_iterations,
                        const CollisionChecker& collision_checker, const double linear_resolution,
                        const double angular_resolution,
                        const navigation_interface::PathPlanner::GoalSampleSettings& goal_sample_settings,
                        const double backwards_mult, const double strafe_mult, const double rotation_mult);
+
+// Same for several goals, searched for at once and ending at the cheapest of them to reach, which is result.goal
+// Goals without a valid sample are left out, goal_in_collision is only set if that leaves none
+PathResult hybridAStar(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                       const size_t max_iterations, const CollisionChecker& collision_checker,
+                       const double linear_resolution, const double angular_resolution,
+                       const navigation_interface::PathPlanner::GoalSampleSettings& goal_sample_settings,
+                       const double backwards_mult, const double strafe_mult, const double rotation_mult,
+                       const SearchOptions& options = SearchOptions());
+
+// ARA* version of hybridAStar, returns the cheapest path found by the deadline, none if the first search did not find
+// one by then. The searches after the first share what is left of max_iterations
+PathResult anytimeHybridAStar(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                              const std::chrono::steady_clock::time_point& deadline, const AnytimeSettings& anytime,
+                              const size_t max_iterations, const CollisionChecker& collision_checker,
+                              const double linear_resolution, const double angular_resolution,
+                              const navigation_interface::PathPlanner::GoalSampleSettings& goal_sample_settings,
+                              const double backwards_mult, const double strafe_mult, const double rotation_mult,
+                              const SearchOptions& options = SearchOptions());
+
+// True if the nodes reached by the search, the nodes of its path and the cells reached by its 2D search lie within
+// region of the costmap it searched, the result is then that of a search of any larger costmap with the same cells
+// Nodes outside of the costmap are never valid and are left out
+bool searchedWithin(const PathResult& result, const Costmap& costmap, const cv::Rect& region);
 }  // namespace astar_planner
 
 #endif
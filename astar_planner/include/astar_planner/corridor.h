@@ -0,0 +1,70 @@
+#ifndef ASTAR_PLANNER_CORRIDOR_H
+#define ASTAR_PLANNER_CORRIDOR_H
+
+#include <astar_planner/costmap.h>
+#include <astar_planner/node.h>
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+namespace astar_planner
+{
+
+// Max pooled pyramid of the cells the 2D search cannot enter
+// Level 0 is the costmap, every level above it halves the resolution and a cell is blocked if any cell it covers is
+// The cell costs include the collision cost so paths on the coarse levels keep away from obstacles like the search does
+class OccupancyPyramid
+{
+  public:
+    OccupancyPyramid(const CollisionChecker& collision_checker, const int levels);
+
+    int levels() const
+    {
+        return static_cast<int>(blocked_.size());
+    }
+
+    // CV_8U, non zero where blocked
+    const cv::Mat& blocked(const int level) const
+    {
+        return blocked_[static_cast<std::size_t>(level)];
+    }
+
+    // CV_32F, mean cost of entering the cells covered which are not blocked, as in the 2D search
+    const cv::Mat& cellCost(const int level) const
+    {
+        return cell_cost_[static_cast<std::size_t>(level)];
+    }
+
+  private:
+    std::vector<cv::Mat> blocked_;
+    std::vector<cv::Mat> cell_cost_;
+};
+
+struct Corridor
+{
+    bool success;
+
+    // level of the pyramid the corridor was found on
+    int level;
+
+    // cells of that level from start to goal
+    std::vector<State2D> path;
+
+    // CV_8U with the size of the costmap, non zero within the corridor
+    cv::Mat mask;
+
+    std::size_t iterations;
+};
+
+// Searches the pyramid for a path between two costmap cells, starting at level and moving down a level whenever the
+// pooling closed every way through
+// The corridor is the coarse cells along the path grown by margin_px costmap cells
+Corridor findCorridor(const OccupancyPyramid& pyramid, const State2D& start, const State2D& goal, const int level,
+                      const int margin_px);
+
+// Copy of costmap where every cell outside mask is in collision, the distances within it are not changed so the search
+// within the corridor costs the same as on the whole map
+Costmap restrictToCorridor(const Costmap& costmap, const cv::Mat& mask);
+}  // namespace astar_planner
+
+#endif
@@ -3,17 +3,29 @@
 
 #include <Eigen/Geometry>
 
+#include <astar_planner/cspace.h>
 #include <astar_planner/node.h>
 #include <gridmap/map_data.h>
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace astar_planner
 {
 
+// The values of a cell the searches read together
+struct CostmapCell
+{
+    float distance_to_collision;
+    float traversal_cost;
+};
+
 struct Costmap
 {
     // uint8 map of obstacles
@@ -22,6 +34,10 @@ struct Costmap
     // float map of traversal cost scale (1.f default)
     std::shared_ptr<cv::Mat> traversal_cost;
 
+    // lower bound of traversal_cost, set along with it so the searches need not look through the map for it
+    // The heuristic table is scaled by it, so the default of 0 leaves the table out
+    double min_traversal_cost = 0.0;
+
     // float map of distance to nearest obstacle (in pixels)
     cv::Mat distance_to_collision;
 
@@ -34,46 +50,97 @@ struct Costmap
 
     double inflation_radius;
 
+    // distances to collision are clamped to this (in pixels) so obstacles only affect the cells around them
+    // the collision costs saturate closer than this (60 pixels for the lookup table, 1m for rotations)
+    float max_distance;
+
+    // version of map_data.grid the obstacle map was copied at
+    uint64_t grid_version;
+
+    // Optional copy of distance_to_collision and traversal_cost as one CostmapCell per cell, empty unless built
+    // The cells are stored in 8x8 tiles (one row of the mat each) in Morton order within the tile, so most of the
+    // neighbours of a cell share its cache lines
+    // Kept up to date by processObstacleMap, the traversal costs are those at the time of buildCells()
+    // A search picks the layout once and reads through PlanarCells or PackedCells, not per cell
+    cv::Mat cells;
+
     Costmap(const gridmap::MapData& map_data, const double robot_radius)
+        : Costmap(map_data, robot_radius,
+                  cv::Rect(0, 0, map_data.grid.dimensions().size().x(), map_data.grid.dimensions().size().y()))
+    {
+    }
+
+    // Costmap of the cells of the grid within region only, its origin is that of the first cell of region
+    // Cells outside of the region are out of bounds, so the distances near its edges ignore the obstacles beyond them
+    Costmap(const gridmap::MapData& map_data, const double robot_radius, const cv::Rect& region)
+        : Costmap(gridCells(map_data)(region), map_data.grid.dimensions().resolution(),
+                  map_data.grid.dimensions().origin().x() + region.x * map_data.grid.dimensions().resolution(),
+                  map_data.grid.dimensions().origin().y() + region.y * map_data.grid.dimensions().resolution(),
+                  robot_radius)
+    {
+        grid_version = map_data.grid.version();
+    }
+
+    // Costmap of an obstacle map which is not part of a grid, e.g. one recorded earlier, its grid_version is 0
+    Costmap(const cv::Mat& obstacles, const double map_resolution, const double map_origin_x,
+            const double map_origin_y, const double robot_radius)
     {
+        ROS_ASSERT(obstacles.type() == CV_8U && !obstacles.empty());
+
         inflation_radius = robot_radius;
 
-        width = map_data.grid.dimensions().size().x();
-        height = map_data.grid.dimensions().size().y();
+        width = obstacles.cols;
+        height = obstacles.rows;
+
+        resolution = map_resolution;
 
-        resolution = map_data.grid.dimensions().resolution();
+        origin_x = map_origin_x;
+        origin_y = map_origin_y;
 
-        origin_x = map_data.grid.dimensions().origin().x();
-        origin_y = map_data.grid.dimensions().origin().y();
+        max_distance = maxDistance(resolution);
 
-        obstacle_map = obstacle_map;
+        grid_version = 0;
 
-        const int size_x = map_data.grid.dimensions().size().x();
-        const int size_y = map_data.grid.dimensions().size().y();
-        const cv::Mat raw(size_y, size_x, CV_8U,
-                          reinterpret_cast<void*>(const_cast<uint8_t*>(map_data.grid.cells().data())));
-        obstacle_map = raw.clone();
+        obstacle_map = obstacles.clone();
     }
 
-    void processObstacleMap()
+    // the cells of the grid, not copied
+    static cv::Mat gridCells(const gridmap::MapData& map_data)
     {
-        cv::Mat dilated;
-        {
-            // dilate robot radius
-            const int cell_inflation_radius = static_cast<int>(2.0 * inflation_radius / resolution);
-            auto ellipse =
-                cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(cell_inflation_radius, cell_inflation_radius));
-            cv::dilate(obstacle_map, dilated, ellipse);
-        }
+        return cv::Mat(map_data.grid.dimensions().size().y(), map_data.grid.dimensions().size().x(), CV_8U,
+                       reinterpret_cast<void*>(const_cast<uint8_t*>(map_data.grid.cells().data())));
+    }
+
+    // Dilates the obstacle map by the inflation radius and finds the distance to collision of every cell
+    void processObstacleMap();
+
+    // Same as processObstacleMap() after the obstacle map changed within regions
+    // Distances are clamped to max_distance so the changes only reach a margin around each region and only that margin
+    // is dilated and distance transformed again
+    // Returns the regions of distance_to_collision which were recomputed
+    std::vector<cv::Rect> processObstacleMap(const std::vector<cv::Rect>& regions);
 
-        // flip
-        cv::bitwise_not(dilated, dilated);
+    // Copies the tiles of the grid which changed since grid_version back into the obstacle map, as well as the cells
+    // in refresh (cells the user drew over)
+    // Returns the regions of the obstacle map which were copied
+    std::vector<cv::Rect> updateObstacleMap(const gridmap::MapData& map_data, const cv::Rect& refresh);
 
-        // allocate
-        distance_to_collision = cv::Mat(dilated.size(), CV_32F);
+    // Clears the obstacles under the robot footprint at pose, returns the region drawn over
+    cv::Rect clearFootprint(const Eigen::Isometry2d& pose, const std::vector<Eigen::Vector2d>& offsets);
 
-        // find obstacle distances
-        cv::distanceTransform(dilated, distance_to_collision, cv::DIST_L2, cv::DIST_MASK_PRECISE, CV_32F);
+    // Builds cells from distance_to_collision and traversal_cost
+    void buildCells();
+
+    // Copies region of distance_to_collision and traversal_cost into cells
+    void updateCells(const cv::Rect& region);
+
+    // column (Morton code of the low 3 bits of x and y) and row (tile) of cells holding the cell at x, y
+    inline cv::Point cellsIndex(const int x, const int y) const
+    {
+        const int u = x & 7;
+        const int v = y & 7;
+        return {(u & 1) | ((v & 1) << 1) | ((u & 2) << 1) | ((v & 2) << 2) | ((u & 4) << 2) | ((v & 4) << 3),
+                (y >> 3) * ((width + 7) >> 3) + (x >> 3)};
     }
 
     inline Eigen::Array2i getCellIndex(const Eigen::Vector2d& point) const
@@ -82,19 +149,146 @@ struct Costmap
                               std::round((point.y() - origin_y) / resolution));
     }
 
+    static float maxDistance(const double resolution)
+    {
+        return static_cast<float>(std::max(60.0, std::ceil(1.0 / resolution)) + 1.0);
+    }
+
+    // Cells around a pose whose obstacles the clearance of a footprint with offsets at the pose depends on, through the
+    // inflation and the clamped distance transform
+    static int reach(const double resolution, const double inflation_radius,
+                     const std::vector<Eigen::Vector2d>& offsets)
+    {
+        double footprint_reach = 0.0;
+        for (const Eigen::Vector2d& offset : offsets)
+            footprint_reach = std::max(footprint_reach, offset.norm());
+        return static_cast<int>(std::ceil((footprint_reach + inflation_radius) / resolution +
+                                          static_cast<double>(maxDistance(resolution)))) +
+               2;
+    }
+
+    inline int reach(const std::vector<Eigen::Vector2d>& offsets) const
+    {
+        return reach(resolution, inflation_radius, offsets);
+    }
+
     inline std::size_t to2DGridIndex(const State2D& state) const
     {
         return static_cast<std::size_t>(width * state.y + state.x);
     }
 };
 
+// Reads the cells of a costmap from distance_to_collision and traversal_cost
+class PlanarCells
+{
+  public:
+    explicit PlanarCells(const Costmap& costmap)
+        : distance_to_collision_(costmap.distance_to_collision), traversal_cost_(*costmap.traversal_cost)
+    {
+    }
+
+    inline CostmapCell operator()(const int x, const int y) const
+    {
+        return {distance_to_collision_.at<float>(y, x), traversal_cost_.at<float>(y, x)};
+    }
+
+  private:
+    const cv::Mat& distance_to_collision_;
+    const cv::Mat& traversal_cost_;
+};
+
+// Reads the cells of a costmap from its packed cells, which have to be built
+class PackedCells
+{
+  public:
+    explicit PackedCells(const Costmap& costmap) : costmap_(costmap)
+    {
+        ROS_ASSERT(!costmap.cells.empty());
+    }
+
+    inline CostmapCell operator()(const int x, const int y) const
+    {
+        const cv::Point index = costmap_.cellsIndex(x, y);
+        return costmap_.cells.ptr<CostmapCell>(index.y)[index.x];
+    }
+
+  private:
+    const Costmap& costmap_;
+};
+
+// Traversal cost scale of every cell: avoid_zone_cost inside avoid zones and path_cost along the paths of the hd map
+std::shared_ptr<cv::Mat> traversalCostMap(const gridmap::MapData& map_data, const double avoid_zone_cost,
+                                          const double path_cost);
+
+// The same, read from a file in cache_directory if it was written for the same costs, dimensions and modification time
+// of the map, otherwise computed and written to it for the next time. An empty cache_directory disables the file
+std::shared_ptr<cv::Mat> traversalCostMap(const gridmap::MapData& map_data, const double avoid_zone_cost,
+                                          const double path_cost, const std::string& cache_directory);
+
+// States to collision check together, stored as separate arrays so several states can be processed at once
+struct ClearanceBatch
+{
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> sin_theta;
+    std::vector<double> cos_theta;
+
+    // output of CollisionChecker::clearance(batch)
+    std::vector<double> clearance;
+
+    std::size_t size() const
+    {
+        return x.size();
+    }
+
+    void clear()
+    {
+        x.clear();
+        y.clear();
+        sin_theta.clear();
+        cos_theta.clear();
+        clearance.clear();
+    }
+
+    void add(const State3D& state)
+    {
+        add(state, std::sin(state.theta), std::cos(state.theta));
+    }
+
+    // when the sin and cos of the heading are already known
+    void add(const State3D& state, const double st, const double ct)
+    {
+        x.push_back(state.x);
+        y.push_back(state.y);
+        sin_theta.push_back(st);
+        cos_theta.push_back(ct);
+    }
+};
+
 class CollisionChecker
 {
   public:
     CollisionChecker(const Costmap& costmap, const std::vector<Eigen::Vector2d>& offsets,
-                     const double conservative_radius)
-        : costmap_(costmap), offsets_(offsets), conservative_radius_(conservative_radius)
+                     const double conservative_radius, const std::shared_ptr<const CSpace>& cspace = nullptr)
+        : costmap_(costmap), offsets_(offsets), conservative_radius_(conservative_radius), cspace_(cspace)
     {
+        if (cspace_)
+        {
+            ROS_ASSERT(cspace_->built());
+            ROS_ASSERT(cspace_->width() == costmap.width && cspace_->height() == costmap.height &&
+                       cspace_->resolution() == costmap.resolution);
+            ROS_ASSERT(cspace_->offsets().size() == offsets.size() &&
+                       std::equal(offsets.begin(), offsets.end(), cspace_->offsets().begin()));
+        }
+
+        offsets_x_.reserve(offsets_.size());
+        offsets_y_.reserve(offsets_.size());
+        for (const auto& offset : offsets_)
+        {
+            offsets_x_.push_back(offset.x());
+            offsets_y_.push_back(offset.y());
+        }
+
         ROS_ASSERT(conservative_radius >= costmap.inflation_radius);
         // check that the conservative radius is larger than the width of the robot
         for (const auto& offset : offsets_)
@@ -132,16 +326,28 @@ class CollisionChecker
 
     bool isValid(const State3D& state) const
     {
-        return clearance(state) > 0.0;
+        return !inCSpaceCollision(state) && clearance(state) > 0.0;
+    }
+
+    // true if the configuration space layers show the footprint of state is in collision
+    // false is not conclusive, it only means the footprint has to be checked
+    bool inCSpaceCollision(const State3D& state) const
+    {
+        int theta_index;
+        if (!cspace_ || !cspace_->onBin(state.theta, theta_index))
+            return false;
+
+        const Eigen::Array2i map_cell = costmap_.getCellIndex({state.x, state.y});
+        return cspace_->blocked(map_cell.x(), map_cell.y(), theta_index);
     }
 
     double clearance(const State3D& state) const
     {
         double min_distance = std::numeric_limits<double>::max();
+        const double st = std::sin(state.theta);
+        const double ct = std::cos(state.theta);
         for (const auto& offset : offsets_)
         {
-            const double st = std::sin(state.theta);
-            const double ct = std::cos(state.theta);
             const double offset_x = state.x + (offset.x() * ct - offset.y() * st);
             const double offset_y = state.y + (offset.x() * st + offset.y() * ct);
 
@@ -158,6 +364,29 @@ class CollisionChecker
         return min_distance;
     }
 
+    // Same as clearance(state) with the offsets already rotated to the heading of state
+    double clearance(const State3D& state, const std::vector<Eigen::Vector2d>& footprint) const
+    {
+        double min_distance = std::numeric_limits<double>::max();
+        for (const auto& offset : footprint)
+        {
+            const Eigen::Array2i map_cell = costmap_.getCellIndex({state.x + offset.x(), state.y + offset.y()});
+
+            double d = 0;
+            if (map_cell.x() >= 0 && map_cell.x() < costmap_.distance_to_collision.cols && map_cell.y() >= 0 &&
+                map_cell.y() < costmap_.distance_to_collision.rows)
+            {
+                d = static_cast<double>(costmap_.distance_to_collision.at<float>(map_cell.y(), map_cell.x()));
+            }
+            min_distance = std::min(min_distance, d);
+        }
+        return min_distance;
+    }
+
+    // Clearance of every state in the batch, the same as clearance(state) for each of them
+    // Uses AVX2 gathers into the distance field when the cpu supports them
+    void clearance(ClearanceBatch& batch) const;
+
     bool isWithinBounds(const State2D& state) const
     {
         return (state.x >= 0 && state.x < costmap_.width && state.y >= 0 && state.y < costmap_.height);
@@ -194,6 +423,12 @@ class CollisionChecker
     const std::vector<Eigen::Vector2d>& offsets_;
     const double conservative_radius_;
 
+    const std::shared_ptr<const CSpace> cspace_;
+
+    // offsets as separate arrays for the batched clearance
+    std::vector<double> offsets_x_;
+    std::vector<double> offsets_y_;
+
     const double lut_max_dist_ = 1.2;
     const double lut_step_size_ = 0.02;
     const int lut_size_ = lut_max_dist_ / lut_step_size_;
@@ -0,0 +1,113 @@
+#ifndef ASTAR_PLANNER_CSPACE_H
+#define ASTAR_PLANNER_CSPACE_H
+
+#include <Eigen/Geometry>
+#include <opencv2/core.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace astar_planner
+{
+
+struct Costmap;
+
+// Configuration space obstacle layers, one bit per map cell for every heading bin of the search
+//
+// A set bit means the footprint is in collision anywhere within the cell with the heading of the bin. Moving a state
+// within its cell moves the cell each offset lands in by at most one, so a layer is the blocked cells eroded by one
+// cell and then swept by the footprint rotated to the heading
+// A clear bit is not conclusive and the footprint still has to be checked
+class CSpace
+{
+  public:
+    CSpace(const double angular_resolution, const std::vector<Eigen::Vector2d>& offsets);
+
+    // Builds every layer from the distance field of the costmap, the headings are built in parallel
+    void build(const Costmap& costmap);
+
+    // Rebuilds the layers around regions where the distance field of the costmap changed
+    void update(const Costmap& costmap, const std::vector<cv::Rect>& regions);
+
+    bool blocked(const int x, const int y, const int theta_index) const
+    {
+        if (x < 0 || x >= width_ || y < 0 || y >= height_ || theta_index < -max_theta_index_ ||
+            theta_index > max_theta_index_)
+            return false;
+
+        const std::vector<uint64_t>& layer = layers_[static_cast<std::size_t>(theta_index + max_theta_index_)];
+        return (layer[static_cast<std::size_t>(y * layer_words_ + (x >> 6))] >> (x & 63)) & 1u;
+    }
+
+    // true if theta lies exactly on a heading bin
+    bool onBin(const double theta, int& theta_index) const
+    {
+        theta_index = static_cast<int>(std::round(theta / angular_resolution_));
+        return std::abs(theta_index) <= max_theta_index_ && theta_index * angular_resolution_ == theta;
+    }
+
+    bool built() const
+    {
+        return built_;
+    }
+
+    int width() const
+    {
+        return width_;
+    }
+
+    int height() const
+    {
+        return height_;
+    }
+
+    double resolution() const
+    {
+        return resolution_;
+    }
+
+    double angularResolution() const
+    {
+        return angular_resolution_;
+    }
+
+    const std::vector<Eigen::Vector2d>& offsets() const
+    {
+        return offsets_;
+    }
+
+  private:
+    void resize(const Costmap& costmap);
+
+    // recomputes the words covering the cells of rect (in map cells, clipped to the grid)
+    void updateBlocked(const Costmap& costmap, const cv::Rect& rect);
+    void updateSure(const cv::Rect& rect);
+    void updateLayer(const std::size_t bin, const cv::Rect& rect);
+
+    double angular_resolution_;
+    std::vector<Eigen::Vector2d> offsets_;
+    int max_theta_index_;
+
+    bool built_;
+    int width_;
+    int height_;
+    double resolution_;
+
+    // blocked cells, and cells whose 3x3 neighbourhood is blocked, with a one cell border outside the map
+    int padded_width_;
+    int padded_height_;
+    int padded_words_;
+    std::vector<uint64_t> blocked_;
+    std::vector<uint64_t> sure_;
+
+    // per heading bin the distinct cell shifts of the rotated offsets
+    std::vector<std::vector<Eigen::Array2i>> shifts_;
+    int reach_;
+
+    int layer_words_;
+    std::vector<std::vector<uint64_t>> layers_;
+};
+}  // namespace astar_planner
+
+#endif
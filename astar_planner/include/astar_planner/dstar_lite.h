@@ -0,0 +1,131 @@
+#ifndef ASTAR_PLANNER_DSTAR_LITE_H
+#define ASTAR_PLANNER_DSTAR_LITE_H
+
+#include <astar_planner/costmap.h>
+#include <astar_planner/indexed_heap.h>
+#include <astar_planner/node.h>
+#include <astar_planner/node_arena.h>
+
+#include <limits>
+#include <vector>
+
+namespace astar_planner
+{
+
+struct DStarNode
+{
+    State2D state;
+    double g;
+    double rhs;
+    double key_1;
+    double key_2;
+    std::size_t heap_index = HEAP_NPOS;
+};
+
+struct CompareDStarNodes
+{
+    bool operator()(const DStarNode* n1, const DStarNode* n2) const
+    {
+        return n1->key_1 > n2->key_1 || (n1->key_1 == n2->key_1 && n1->key_2 > n2->key_2);
+    }
+};
+
+// D* Lite (Koenig & Likhachev) over the 16-connected cell graph used by the 2D heuristic search
+// Moving between cells is charged the cost of the cell further from the goal, like the goal rooted shortestPath2D, so
+// a changed cell only changes the edges leaving it
+// The search is rooted at the goal so it survives the start moving, and when cell costs change only the nodes whose
+// cost-to-go is affected are expanded again
+class DStarLite
+{
+  public:
+    DStarLite();
+
+    // Starts a new search for goal over the cell costs of the costmap
+    void reset(const State2D& goal, const CollisionChecker& collision_checker);
+
+    // Takes the new cell costs within regions from the costmap
+    // Returns the number of cells whose cost changed
+    std::size_t updateCellCosts(const CollisionChecker& collision_checker, const std::vector<cv::Rect>& regions);
+
+    // Repairs the search for start, returns false if the goal cannot be reached
+    bool computeShortestPath(const State2D& start);
+
+    // Follows the cheapest successors from start to the goal
+    // Only valid after computeShortestPath(start) succeeded
+    std::vector<State2D> path(const State2D& start) const;
+
+    // Cost-to-go of a cell (in cells), max if it has not been reached
+    // Only exact for the start of the last computeShortestPath and the cells along its path
+    double costToGo(const State2D& state) const;
+
+    bool started() const
+    {
+        return started_;
+    }
+
+    const State2D& goal() const
+    {
+        return goal_;
+    }
+
+    int width() const
+    {
+        return width_;
+    }
+
+    int height() const
+    {
+        return height_;
+    }
+
+    // nodes expanded by the last computeShortestPath
+    std::size_t expansions() const
+    {
+        return expansions_;
+    }
+
+  private:
+    typedef IndexedHeap<DStarNode, CompareDStarNodes> OpenSet;
+
+    std::size_t index(const State2D& state) const
+    {
+        return static_cast<std::size_t>(width_ * state.y + state.x);
+    }
+
+    bool contains(const State2D& state) const
+    {
+        return state.x >= 0 && state.x < width_ && state.y >= 0 && state.y < height_;
+    }
+
+    double heuristic(const State2D& s1, const State2D& s2) const;
+
+    DStarNode* node(const State2D& state);
+    const DStarNode* findNode(const State2D& state) const;
+
+    void calculateKey(DStarNode* node) const;
+    void updateVertex(DStarNode* node);
+
+    // min over the successors of the cost of moving there plus their cost-to-go
+    double bestSuccessor(const State2D& state) const;
+
+    bool started_;
+    State2D goal_;
+    State2D last_start_;
+    int width_;
+    int height_;
+
+    // lower bound of the cell costs, scales the euclidean heuristic so it stays consistent
+    double heuristic_scale_;
+    double key_modifier_;
+
+    std::vector<float> cell_costs_;
+    std::vector<float> next_cell_costs_;
+
+    NodeIndexMap<DStarNode> nodes_;
+    OpenSet open_set_;
+
+    std::size_t expansions_;
+};
+}  // namespace astar_planner
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef ASTAR_PLANNER_DSTAR_LITE_PLUGIN_H
+#define ASTAR_PLANNER_DSTAR_LITE_PLUGIN_H
+
+#include <astar_planner/costmap.h>
+#include <astar_planner/dstar_lite.h>
+#include <gridmap/map_data.h>
+#include <navigation_interface/path_planner.h>
+#include <opencv2/core.hpp>
+#include <ros/ros.h>
+
+namespace astar_planner
+{
+
+// Plans over the 2D cell graph with D* Lite, repairing the previous search as the start moves and the map changes
+// Cells are only entered if the conservative radius is clear so the path is valid for any heading, the heading is
+// interpolated from the start to the goal orientation
+class DStarLitePlanner : public navigation_interface::PathPlanner
+{
+  public:
+    DStarLitePlanner();
+    ~DStarLitePlanner();
+
+    virtual Result plan(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal,
+                        const GoalSampleSettings& sample) override;
+
+    virtual bool valid(const navigation_interface::Path& path) const override;
+    virtual double cost(const navigation_interface::Path& path) const override;
+
+    virtual void onInitialize(const YAML::Node& parameters) override;
+    virtual void onMapDataChanged() override;
+
+  private:
+    double robot_radius_ = 0.230;
+    double conservative_robot_radius_ = 0.416;
+    double avoid_zone_cost_ = 4.0;
+    double path_cost_ = 0.2;
+
+    double backwards_mult_ = 1.5;
+    double strafe_mult_ = 1.5;
+    double rotation_mult_ = 0.3 / M_PI;
+
+    // distance between the nodes of the returned path
+    double path_spacing_ = 0.1;
+
+    std::vector<Eigen::Vector2d> offsets_;
+
+    std::shared_ptr<Costmap> costmap_;
+    std::shared_ptr<cv::Mat> traversal_cost_;
+
+    // map the costmap was built from and the cells cleared under the robot in the last plan
+    std::shared_ptr<const gridmap::MapData> costmap_map_data_;
+    cv::Rect footprint_region_;
+
+    DStarLite dstar_;
+};
+}  // namespace astar_planner
+
+#endif
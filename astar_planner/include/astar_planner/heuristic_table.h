@@ -0,0 +1,92 @@
+#ifndef ASTAR_PLANNER_HEURISTIC_TABLE_H
+#define ASTAR_PLANNER_HEURISTIC_TABLE_H
+
+#include <astar_planner/node.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace astar_planner
+{
+
+// Obstacle free cost-to-go of the motion model of the 3D search, for states within size of the goal
+//
+// The cost of a state is the cheapest sequence of moves from it to a state the search accepts as the goal, costed as
+// the search costs them away from obstacles and on the cheapest traversal cost. Unlike the 2D heuristic it includes
+// the cost of turning to the goal heading and of reversing and strafing
+// The moves are those of every resolution level of MotionPrimitives, snapped to the lattice of the level from every
+// position on it, and the goal is taken anywhere in its cell. This keeps the table a lower bound of the search, which
+// works in the map frame, so the table is too: one layer per goal heading, relative to the cell of the goal
+// Generated offline with generate_heuristic_table and loaded when the planner starts
+class HeuristicTable
+{
+  public:
+    struct Settings
+    {
+        double linear_resolution;
+        double angular_resolution;
+        double backwards_mult;
+        double strafe_mult;
+        double rotation_mult;
+
+        // half width of the table (m)
+        double size;
+    };
+
+    // Dijkstra backwards from the goal over the moves of the search
+    explicit HeuristicTable(const Settings& settings);
+
+    // nullptr if path is not a table file
+    static std::shared_ptr<HeuristicTable> load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // the distance to the goal outside the table, which leaves the 2D heuristic to bound the cost
+    double costToGo(const State3D& state, const State3D& goal) const;
+
+    // true if the table was generated for the motion model of the search
+    bool matches(const double linear_resolution, const double angular_resolution, const double backwards_mult,
+                 const double strafe_mult, const double rotation_mult) const;
+
+    const Settings& settings() const
+    {
+        return settings_;
+    }
+
+    int halfCells() const
+    {
+        return half_cells_;
+    }
+
+    int headings() const
+    {
+        return headings_;
+    }
+
+  private:
+    HeuristicTable() = default;
+
+    std::size_t index(const int goal_heading, const int x, const int y, const int heading) const
+    {
+        const int width = 2 * half_cells_ + 1;
+        return ((static_cast<std::size_t>(goal_heading) * static_cast<std::size_t>(headings_) +
+                 static_cast<std::size_t>(heading)) *
+                    static_cast<std::size_t>(width) +
+                static_cast<std::size_t>(y + half_cells_)) *
+                   static_cast<std::size_t>(width) +
+               static_cast<std::size_t>(x + half_cells_);
+    }
+
+    Settings settings_;
+    int half_cells_;
+    int headings_;
+
+    // the moves are the same turned by a quarter, so only the goal headings of the first quarter are stored
+    int goal_headings_;
+
+    // goal heading major, then heading, then y, then x
+    std::vector<float> costs_;
+};
+}  // namespace astar_planner
+
+#endif
@@ -0,0 +1,205 @@
+#ifndef ASTAR_PLANNER_INDEXED_HEAP_H
+#define ASTAR_PLANNER_INDEXED_HEAP_H
+
+#include <ros/assert.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace astar_planner
+{
+
+static constexpr std::size_t HEAP_NPOS = std::numeric_limits<std::size_t>::max();
+
+// 4-ary heap of node pointers
+// The position of each node in the heap is stored in NodeType::heap_index (HEAP_NPOS when not queued) so decrease()
+// can find the node without a handle lookup
+// Compare follows the std/boost convention: compare(a, b) is true when a has a lower priority than b
+template <typename NodeType, typename Compare> class IndexedHeap
+{
+  public:
+    typedef typename std::vector<NodeType*>::const_iterator const_iterator;
+
+    IndexedHeap() = default;
+
+    // the nodes point back into the heap so copies would alias
+    IndexedHeap(const IndexedHeap&) = delete;
+    IndexedHeap& operator=(const IndexedHeap&) = delete;
+
+    IndexedHeap(IndexedHeap&&) = default;
+    IndexedHeap& operator=(IndexedHeap&&) = default;
+
+    bool empty() const
+    {
+        return heap_.empty();
+    }
+
+    std::size_t size() const
+    {
+        return heap_.size();
+    }
+
+    // bytes allocated for the heap array
+    std::size_t memoryUsage() const
+    {
+        return heap_.capacity() * sizeof(NodeType*);
+    }
+
+    void reserve(const std::size_t size)
+    {
+        heap_.reserve(size);
+    }
+
+    NodeType* top() const
+    {
+        return heap_.front();
+    }
+
+    // Node at position i of the heap, the first positions hold the cheapest nodes
+    NodeType* at(const std::size_t i) const
+    {
+        return heap_[i];
+    }
+
+    bool contains(const NodeType* node) const
+    {
+        return node->heap_index != HEAP_NPOS;
+    }
+
+    void push(NodeType* node)
+    {
+        ROS_ASSERT(node->heap_index == HEAP_NPOS);
+        node->heap_index = heap_.size();
+        heap_.push_back(node);
+        siftUp(node->heap_index);
+    }
+
+    void pop()
+    {
+        NodeType* last = heap_.back();
+        heap_.front()->heap_index = HEAP_NPOS;
+        heap_.pop_back();
+        if (!heap_.empty())
+        {
+            heap_[0] = last;
+            last->heap_index = 0;
+            siftDown(0);
+        }
+    }
+
+    // Restore the heap after the cost of a queued node was lowered
+    void decrease(NodeType* node)
+    {
+        ROS_ASSERT(contains(node));
+        ROS_ASSERT(heap_[node->heap_index] == node);
+        siftUp(node->heap_index);
+    }
+
+    // Restore the heap after the cost of a queued node changed in either direction
+    void update(NodeType* node)
+    {
+        ROS_ASSERT(contains(node));
+        ROS_ASSERT(heap_[node->heap_index] == node);
+        siftUp(node->heap_index);
+        siftDown(node->heap_index);
+    }
+
+    void erase(NodeType* node)
+    {
+        ROS_ASSERT(contains(node));
+        ROS_ASSERT(heap_[node->heap_index] == node);
+        const std::size_t index = node->heap_index;
+        NodeType* last = heap_.back();
+        node->heap_index = HEAP_NPOS;
+        heap_.pop_back();
+        if (last != node)
+        {
+            heap_[index] = last;
+            last->heap_index = index;
+            siftUp(index);
+            siftDown(last->heap_index);
+        }
+    }
+
+    // Restore the heap after the costs of many queued nodes changed
+    void rebuild()
+    {
+        if (heap_.size() < 2)
+            return;
+        for (std::size_t i = (heap_.size() - 2) / ARITY + 1; i-- > 0;)
+            siftDown(i);
+    }
+
+    void clear()
+    {
+        for (NodeType* node : heap_)
+            node->heap_index = HEAP_NPOS;
+        heap_.clear();
+    }
+
+    const_iterator begin() const
+    {
+        return heap_.begin();
+    }
+
+    const_iterator end() const
+    {
+        return heap_.end();
+    }
+
+  private:
+    static constexpr std::size_t ARITY = 4;
+
+    void siftUp(std::size_t index)
+    {
+        NodeType* node = heap_[index];
+        while (index > 0)
+        {
+            const std::size_t parent = (index - 1) / ARITY;
+            if (!compare_(heap_[parent], node))
+                break;
+            heap_[index] = heap_[parent];
+            heap_[index]->heap_index = index;
+            index = parent;
+        }
+        heap_[index] = node;
+        node->heap_index = index;
+    }
+
+    void siftDown(std::size_t index)
+    {
+        const std::size_t size = heap_.size();
+        NodeType* node = heap_[index];
+        while (true)
+        {
+            const std::size_t first_child = index * ARITY + 1;
+            if (first_child >= size)
+                break;
+
+            const std::size_t last_child = std::min(first_child + ARITY, size);
+            std::size_t best = first_child;
+            for (std::size_t child = first_child + 1; child < last_child; ++child)
+            {
+                if (compare_(heap_[best], heap_[child]))
+                    best = child;
+            }
+
+            if (!compare_(node, heap_[best]))
+                break;
+
+            heap_[index] = heap_[best];
+            heap_[index]->heap_index = index;
+            index = best;
+        }
+        heap_[index] = node;
+        node->heap_index = index;
+    }
+
+    Compare compare_;
+    std::vector<NodeType*> heap_;
+};
+}  // namespace astar_planner
+
+#endif
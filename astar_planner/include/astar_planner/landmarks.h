@@ -0,0 +1,87 @@
+#ifndef ASTAR_PLANNER_LANDMARKS_H
+#define ASTAR_PLANNER_LANDMARKS_H
+
+#include <astar_planner/node.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace astar_planner
+{
+
+class CollisionChecker;
+
+// Costs of the 2D search from a few landmark cells to every cell of the map, for the ALT (A*, landmarks and triangle
+// inequality, Goldberg & Harrelson) bound on the cost between two cells
+//
+// For a landmark L the cost from n to t is at least d(L, t) - d(L, n). The costs are those of the map the landmarks
+// were computed on, so the bound only holds on maps whose cells cost at least as much, e.g. the same traversal costs
+// with more obstacles. Removed obstacles break it, AStarPlanner computes its landmarks without any obstacles
+// The costs are quantised to 16 bits, the distances of all landmarks to a cell are stored together
+class Landmarks
+{
+  public:
+    // Farthest point sampling of count landmarks, picked from candidates (e.g. the nodes of the hd map) while any are
+    // left and then from every cell, starting from the first candidate or the centre of the map
+    Landmarks(const CollisionChecker& collision_checker, const std::vector<State2D>& candidates,
+              const std::size_t count);
+
+    std::size_t size() const
+    {
+        return cells_.size();
+    }
+
+    const std::vector<State2D>& cells() const
+    {
+        return cells_;
+    }
+
+    int width() const
+    {
+        return width_;
+    }
+
+    int height() const
+    {
+        return height_;
+    }
+
+    // quantised costs from every landmark to cell
+    const uint16_t* distances(const State2D& cell) const
+    {
+        return &distances_[(static_cast<std::size_t>(cell.y) * static_cast<std::size_t>(width_) +
+                            static_cast<std::size_t>(cell.x)) *
+                           cells_.size()];
+    }
+
+    // Lower bound of the cost of the 2D search from cell to the cell of target_distances
+    double lowerBound(const State2D& cell, const uint16_t* target_distances) const
+    {
+        const uint16_t* cell_distances = distances(cell);
+        double bound = 0;
+        for (std::size_t i = 0; i < cells_.size(); ++i)
+        {
+            // one step less for the rounding of both distances
+            const int steps = target_distances[i] - cell_distances[i] - 1;
+            if (steps > 0 && target_distances[i] != UNREACHABLE && cell_distances[i] != UNREACHABLE)
+                bound = std::max(bound, steps * steps_[i]);
+        }
+        return bound;
+    }
+
+  private:
+    static const uint16_t UNREACHABLE = 65535;
+
+    std::vector<State2D> cells_;
+    int width_;
+    int height_;
+
+    // cost of one quantisation step of each landmark
+    std::vector<double> steps_;
+
+    std::vector<uint16_t> distances_;
+};
+}  // namespace astar_planner
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef ASTAR_PLANNER_MOTION_PRIMITIVES_H
+#define ASTAR_PLANNER_MOTION_PRIMITIVES_H
+
+#include <Eigen/Geometry>
+
+#include <astar_planner/node.h>
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace astar_planner
+{
+
+// motion in the robot frame
+struct ExploreDirection
+{
+    double x;
+    double y;
+    double rotation;
+};
+
+// forwards, forwards + rotate left, forwards + rotate right, backwards, left, right, rotate left, rotate right
+// the first three are used away from obstacles, the start and the goal
+static constexpr std::size_t NUM_DIRECTIONS = 8;
+static constexpr std::size_t NUM_OPEN_DIRECTIONS = 3;
+
+// the search steps 1, 2 or 4 times linear_resolution depending on the clearance
+static constexpr std::size_t NUM_RESOLUTION_LEVELS = 3;
+
+struct MotionPrimitive
+{
+    // translation in the map frame
+    double dx;
+    double dy;
+
+    // heading after the move, and its bin
+    double theta;
+    int theta_index;
+};
+
+// Successors of a state with a given heading
+struct HeadingPrimitives
+{
+    // indexed by resolution level and direction
+    std::array<std::array<MotionPrimitive, NUM_DIRECTIONS>, NUM_RESOLUTION_LEVELS> primitives;
+};
+
+// Motion primitives and rotated robot footprints for every heading bin of the search
+// Built once per planner configuration so expanding a node on the lattice does not need any trigonometry
+// The values are computed with the same expressions the search used before so the results are bit identical
+class MotionPrimitives
+{
+  public:
+    MotionPrimitives(const double linear_resolution, const double angular_resolution, const double map_resolution,
+                     const std::vector<Eigen::Vector2d>& offsets);
+
+    // Successors of a state with heading theta
+    // States away from the heading bins (the start) are computed into scratch
+    const HeadingPrimitives& successors(const double theta, HeadingPrimitives& scratch) const;
+
+    // Robot offsets rotated to the heading of a bin
+    const std::vector<Eigen::Vector2d>& footprint(const int theta_index) const
+    {
+        return footprints_[static_cast<std::size_t>(theta_index + max_theta_index_)];
+    }
+
+    double sinTheta(const int theta_index) const
+    {
+        return sin_theta_[static_cast<std::size_t>(theta_index + max_theta_index_)];
+    }
+
+    double cosTheta(const int theta_index) const
+    {
+        return cos_theta_[static_cast<std::size_t>(theta_index + max_theta_index_)];
+    }
+
+    // true if theta lies exactly on a heading bin, as all states created by the search do
+    bool onBin(const double theta, int& theta_index) const
+    {
+        theta_index = static_cast<int>(std::round(theta / angular_resolution_));
+        return std::abs(theta_index) <= max_theta_index_ && theta_index * angular_resolution_ == theta;
+    }
+
+    static std::size_t resolutionLevel(const double res_mult)
+    {
+        return res_mult < 1.5 ? 0 : (res_mult < 3 ? 1 : 2);
+    }
+
+    static double resolutionMult(const std::size_t level)
+    {
+        return static_cast<double>(1 << level);
+    }
+
+    double linearResolution() const
+    {
+        return linear_resolution_;
+    }
+
+    double angularResolution() const
+    {
+        return angular_resolution_;
+    }
+
+    double mapResolution() const
+    {
+        return map_resolution_;
+    }
+
+    const std::vector<Eigen::Vector2d>& offsets() const
+    {
+        return offsets_;
+    }
+
+  private:
+    void compute(const double theta, HeadingPrimitives& heading) const;
+
+    double linear_resolution_;
+    double angular_resolution_;
+    double map_resolution_;
+    std::vector<Eigen::Vector2d> offsets_;
+
+    std::array<ExploreDirection, NUM_DIRECTIONS> directions_;
+
+    int max_theta_index_;
+    std::vector<HeadingPrimitives> headings_;
+    std::vector<std::vector<Eigen::Vector2d>> footprints_;
+    std::vector<double> sin_theta_;
+    std::vector<double> cos_theta_;
+};
+}  // namespace astar_planner
+
+#endif
@@ -1,11 +1,13 @@
 #ifndef ASTAR_PLANNER_NODE_H
 #define ASTAR_PLANNER_NODE_H
 
-#include <boost/heap/binomial_heap.hpp>
+#include <astar_planner/indexed_heap.h>
 #include <ros/assert.h>
 
 #include <array>
 #include <cmath>
+#include <cstdint>
+#include <limits>
 
 namespace astar_planner
 {
@@ -102,11 +104,12 @@ struct Node2D
     State2D state;
     Node2D* parent;
 
-    bool visited;
-
     double cost_so_far;
     double cost_to_go;
 
+    // position in the open set
+    std::size_t heap_index = HEAP_NPOS;
+
     double cost() const
     {
         return cost_so_far + cost_to_go;
@@ -123,6 +126,15 @@ struct Node3D
     double cost_so_far;
     double cost_to_go;
 
+    // position in the open set
+    std::size_t heap_index = HEAP_NPOS;
+
+    // with lazy evaluation, set while the costs are only optimistic and the state has not been collision checked
+    bool lazy = false;
+
+    // with lazy evaluation, set if the state failed its collision check, the same state is not queued again
+    bool in_collision = false;
+
     double cost() const
     {
         return cost_so_far + cost_to_go;
@@ -186,8 +198,8 @@ inline Node3dIndex KeyToIndex(const uint64_t& key)
                        static_cast<int32_t>(key & 0xFFFFFFFF)};
 }
 
-typedef boost::heap::binomial_heap<Node3D*, boost::heap::compare<CompareNodes>> PriorityQueue3D;
-typedef boost::heap::binomial_heap<Node2D*, boost::heap::compare<CompareNodes>> PriorityQueue2D;
+typedef IndexedHeap<Node3D, CompareNodes> PriorityQueue3D;
+typedef IndexedHeap<Node2D, CompareNodes> PriorityQueue2D;
 }  // namespace astar_planner
 
 #endif
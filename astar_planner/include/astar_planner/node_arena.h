@@ -0,0 +1,232 @@
+#ifndef ASTAR_PLANNER_NODE_ARENA_H
+#define ASTAR_PLANNER_NODE_ARENA_H
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace astar_planner
+{
+
+// Bump allocator handing out nodes from fixed size blocks
+// Pointers stay valid until the arena is destroyed, nodes are never freed individually
+template <typename NodeType, std::size_t BlockSize = 4096> class NodeArena
+{
+    static_assert(std::is_trivially_destructible<NodeType>::value, "arena nodes are released without destruction");
+
+  public:
+    NodeArena() : size_(0), block_used_(BlockSize)
+    {
+    }
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    NodeArena(NodeArena&&) = default;
+    NodeArena& operator=(NodeArena&&) = default;
+
+    NodeType* allocate(const NodeType& node)
+    {
+        if (block_used_ == BlockSize)
+        {
+            blocks_.emplace_back(new Storage[BlockSize]);
+            block_used_ = 0;
+        }
+        NodeType* ptr = new (&blocks_.back()[block_used_++]) NodeType(node);
+        ++size_;
+        return ptr;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    // bytes allocated for the blocks
+    std::size_t memoryUsage() const
+    {
+        return blocks_.size() * BlockSize * sizeof(Storage) + blocks_.capacity() * sizeof(blocks_.front());
+    }
+
+    void clear()
+    {
+        blocks_.clear();
+        size_ = 0;
+        block_used_ = BlockSize;
+    }
+
+  private:
+    typedef typename std::aligned_storage<sizeof(NodeType), alignof(NodeType)>::type Storage;
+
+    std::vector<std::unique_ptr<Storage[]>> blocks_;
+    std::size_t size_;
+    std::size_t block_used_;
+};
+
+// Open addressing (linear probing) index from a lattice key to an arena allocated node
+template <typename NodeType> class NodeIndexMap
+{
+  public:
+    typedef std::pair<uint64_t, NodeType*> value_type;
+
+    class const_iterator
+    {
+      public:
+        const_iterator(const value_type* it, const value_type* end) : it_(it), end_(end)
+        {
+            skip();
+        }
+
+        const value_type& operator*() const
+        {
+            return *it_;
+        }
+
+        const value_type* operator->() const
+        {
+            return it_;
+        }
+
+        const_iterator& operator++()
+        {
+            ++it_;
+            skip();
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const
+        {
+            return it_ == other.it_;
+        }
+
+        bool operator!=(const const_iterator& other) const
+        {
+            return it_ != other.it_;
+        }
+
+      private:
+        void skip()
+        {
+            while (it_ != end_ && !it_->second)
+                ++it_;
+        }
+
+        const value_type* it_;
+        const value_type* end_;
+    };
+
+    explicit NodeIndexMap(const std::size_t initial_capacity = 1 << 12) : size_(0)
+    {
+        std::size_t capacity = 16;
+        while (capacity < initial_capacity)
+            capacity <<= 1;
+        slots_.assign(capacity, value_type(0, nullptr));
+        mask_ = capacity - 1;
+    }
+
+    NodeIndexMap(const NodeIndexMap&) = delete;
+    NodeIndexMap& operator=(const NodeIndexMap&) = delete;
+
+    NodeIndexMap(NodeIndexMap&&) = default;
+    NodeIndexMap& operator=(NodeIndexMap&&) = default;
+
+    NodeType* find(const uint64_t key) const
+    {
+        for (std::size_t i = hash(key) & mask_;; i = (i + 1) & mask_)
+        {
+            const value_type& slot = slots_[i];
+            if (!slot.second || slot.first == key)
+                return slot.second;
+        }
+    }
+
+    // Returns the node stored under key, allocating a copy of node if there is none
+    // The bool is true if the node was allocated
+    std::pair<NodeType*, bool> emplace(const uint64_t key, const NodeType& node)
+    {
+        if (2 * (size_ + 1) > slots_.size())
+            grow();
+
+        for (std::size_t i = hash(key) & mask_;; i = (i + 1) & mask_)
+        {
+            value_type& slot = slots_[i];
+            if (!slot.second)
+            {
+                slot.first = key;
+                slot.second = arena_.allocate(node);
+                ++size_;
+                return {slot.second, true};
+            }
+            else if (slot.first == key)
+            {
+                return {slot.second, false};
+            }
+        }
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    // bytes allocated for the slots and the nodes
+    std::size_t memoryUsage() const
+    {
+        return slots_.capacity() * sizeof(value_type) + arena_.memoryUsage();
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(slots_.data(), slots_.data() + slots_.size());
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size());
+    }
+
+  private:
+    static std::size_t hash(uint64_t key)
+    {
+        // splitmix64 finaliser, the raw keys are heavily clustered in the low bits
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return static_cast<std::size_t>(key);
+    }
+
+    void grow()
+    {
+        std::vector<value_type> old(slots_.size() * 2, value_type(0, nullptr));
+        old.swap(slots_);
+        mask_ = slots_.size() - 1;
+        for (const value_type& slot : old)
+        {
+            if (!slot.second)
+                continue;
+            std::size_t i = hash(slot.first) & mask_;
+            while (slots_[i].second)
+                i = (i + 1) & mask_;
+            slots_[i] = slot;
+        }
+    }
+
+    std::vector<value_type> slots_;
+    std::size_t mask_;
+    std::size_t size_;
+
+    NodeArena<NodeType> arena_;
+};
+}  // namespace astar_planner
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef ASTAR_PLANNER_PARALLEL_H
+#define ASTAR_PLANNER_PARALLEL_H
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace astar_planner
+{
+
+template <typename Function> class ParallelLoop : public cv::ParallelLoopBody
+{
+  public:
+    explicit ParallelLoop(const Function& function) : function_(function)
+    {
+    }
+
+    virtual void operator()(const cv::Range& range) const override
+    {
+        for (int i = range.start; i < range.end; ++i)
+            function_(i);
+    }
+
+  private:
+    const Function& function_;
+};
+
+// Calls function(i) for i in [0, size) on the OpenCV thread pool, split in about stripes parts if given
+template <typename Function> void parallelFor(const int size, const Function& function, const double stripes = -1.0)
+{
+    cv::parallel_for_(cv::Range(0, size), ParallelLoop<Function>(function), stripes);
+}
+
+// A fixed number of threads for loops too short to leave the sizing to the OpenCV pool, and whose number of threads
+// must not depend on other users of it
+// The calling thread takes part in the loops, so threads - 1 are started once and kept until the pool is destroyed
+// Loops called from several threads run one after the other
+class ThreadPool
+{
+  public:
+    explicit ThreadPool(const int threads) : threads_(std::max(1, threads))
+    {
+        for (int i = 1; i < threads_; ++i)
+            workers_.emplace_back(&ThreadPool::work, this);
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (std::thread& worker : workers_)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int threads() const
+    {
+        return threads_;
+    }
+
+    // Calls function(i) for i in [0, size) and returns once every call has finished
+    template <typename Function> void parallelFor(const int size, const Function& function)
+    {
+        std::lock_guard<std::mutex> loop_lock(loop_mutex_);
+
+        const std::function<void(int)> call = [&function](const int i) { function(i); };
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            function_ = &call;
+            size_ = size;
+            next_ = 0;
+            active_ = static_cast<int>(workers_.size());
+            ++generation_;
+        }
+        start_.notify_all();
+
+        run();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return active_ == 0; });
+        function_ = nullptr;
+    }
+
+  private:
+    void run()
+    {
+        for (int i = next_++; i < size_; i = next_++)
+            (*function_)(i);
+    }
+
+    void work()
+    {
+        std::size_t generation = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_.wait(lock, [this, generation] { return stop_ || generation_ != generation; });
+                if (stop_)
+                    return;
+                generation = generation_;
+            }
+
+            run();
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_ == 0)
+                done_.notify_one();
+        }
+    }
+
+    const int threads_;
+    std::vector<std::thread> workers_;
+
+    // held by the thread running a loop
+    std::mutex loop_mutex_;
+
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    bool stop_ = false;
+    std::size_t generation_ = 0;
+    int active_ = 0;
+
+    // the loop being run, set under the mutex before the workers are woken
+    const std::function<void(int)>* function_ = nullptr;
+    int size_ = 0;
+    std::atomic<int> next_{0};
+};
+}  // namespace astar_planner
+
+#endif
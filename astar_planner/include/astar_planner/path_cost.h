@@ -0,0 +1,74 @@
+#ifndef ASTAR_PLANNER_PATH_COST_H
+#define ASTAR_PLANNER_PATH_COST_H
+
+#include <astar_planner/costmap.h>
+#include <gridmap/map_data.h>
+#include <navigation_interface/types/path.h>
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace astar_planner
+{
+
+// Cost of the given segments (node i to node i + 1) of path, max for a segment starting in collision
+// The headings are taken from the rotation matrices of the nodes and the nodes are collision checked as one batch
+void segmentCosts(const navigation_interface::Path& path, const std::vector<std::size_t>& segments,
+                  const CollisionChecker& collision_checker, const double backwards_mult, const double strafe_mult,
+                  const double rotation_mult, std::vector<double>& costs);
+
+// pathCost of a path which is evaluated again and again while the map changes around it
+//
+// The cost of a segment only depends on the cells of the grid within reach of the footprint, the inflation and the
+// collision cost falloff around its first node. Each segment is kept with the version of the grid the costmap was at
+// when it was costed and is only costed again once a tile within reach got a newer version
+// Changes to the costmap which do not come from the grid (e.g. clearing the footprint) are passed to invalidate()
+class PathCostCache
+{
+  public:
+    PathCostCache() : costed_(0)
+    {
+    }
+
+    // Same as pathCost, the costmap of collision_checker must have been updated from the grid of map_data
+    // The multipliers must be the same for every call
+    double cost(const navigation_interface::Path& path, const CollisionChecker& collision_checker,
+                const gridmap::MapData& map_data, const double backwards_mult, const double strafe_mult,
+                const double rotation_mult);
+
+    // Forgets the segments which depend on cells in region
+    void invalidate(const cv::Rect& region);
+
+    void clear()
+    {
+        segments_.clear();
+    }
+
+    // segments costed by the last call to cost()
+    std::size_t costed() const
+    {
+        return costed_;
+    }
+
+  private:
+    struct Segment
+    {
+        Eigen::Isometry2d from;
+        Eigen::Isometry2d to;
+
+        // cells the cost depends on
+        cv::Rect region;
+
+        uint64_t grid_version;
+        double cost;
+    };
+
+    // by a hash of the poses, only the segments of the last path are kept
+    std::unordered_multimap<std::size_t, Segment> segments_;
+    std::size_t costed_;
+};
+}  // namespace astar_planner
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef ASTAR_PLANNER_PLAN_RECORD_H
+#define ASTAR_PLANNER_PLAN_RECORD_H
+
+#include <Eigen/Geometry>
+
+#include <astar_planner/astar.h>
+#include <astar_planner/costmap.h>
+#include <astar_planner/cspace.h>
+#include <astar_planner/heuristic_table.h>
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace astar_planner
+{
+
+// What a plan of AStarPlanner searched with, written when a plan is slow so replay_plans can search it again offline
+//
+// Only the region of the costmap the search read is kept, with the footprint of the robot already cleared. The replay
+// starts the 2D search from scratch and goes without the ALT landmarks and the corridor of the planner
+struct PlanRecord
+{
+    struct Settings
+    {
+        double linear_resolution;
+        double angular_resolution;
+        double robot_radius;
+        double conservative_robot_radius;
+        double backwards_mult;
+        double strafe_mult;
+        double rotation_mult;
+        double analytic_expansion_threshold;
+        double analytic_expansion_cost_tolerance;
+
+        // the weights of an anytime search and the time it had until its deadline (s)
+        double anytime_initial_weight;
+        double anytime_weight_step;
+        double anytime_budget;
+
+        // lower bound of the traversal costs of the whole map, which scales the heuristic table
+        double min_traversal_cost;
+
+        double sample_std_x;
+        double sample_std_y;
+        double sample_std_w;
+        uint64_t sample_max_samples;
+
+        uint64_t max_iterations;
+        uint64_t anytime_first_max_iterations;
+        uint64_t analytic_expansion_interval;
+
+        int32_t heuristic_mode;
+        int32_t threads;
+        int32_t lazy_evaluation;
+        int32_t packed_cells;
+        int32_t anytime;
+
+        // keeps the settings free of padding, they are written to the file as they are
+        int32_t reserved;
+    };
+
+    Settings settings;
+    std::vector<Eigen::Vector2d> offsets;
+
+    // the table file of the planner, loaded by the replay if it exists, empty without a table
+    std::string heuristic_table;
+
+    Eigen::Isometry2d start;
+    std::vector<Eigen::Isometry2d> goals;
+
+    // the region of the costmap, its origin is that of its first cell
+    double resolution;
+    double origin_x;
+    double origin_y;
+    cv::Mat obstacle_map;
+    cv::Mat traversal_cost;
+
+    // the plan when it was recorded
+    double duration;
+    uint64_t iterations;
+    int32_t success;
+
+    // nullptr if path is not a record file
+    static std::shared_ptr<PlanRecord> load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // Copies region of the obstacle map and the traversal costs of costmap
+    void setRegion(const Costmap& costmap, const cv::Rect& region);
+
+    // Costmap of the region, processed as the planner processes its costmap
+    std::shared_ptr<Costmap> costmap() const;
+
+    // The search of the recorded plan on costmap, with the configuration space layers and table if given
+    // Successors are evaluated on thread_pool if given, which the planner sized by settings.threads
+    PathResult replay(const Costmap& costmap, const std::shared_ptr<const CSpace>& cspace = nullptr,
+                      const std::shared_ptr<const HeuristicTable>& table = nullptr,
+                      const std::shared_ptr<ThreadPool>& thread_pool = nullptr) const;
+};
+
+// The cells of costmap a search read: the cells within reach of the nodes it reached and of its path, and the cells its
+// 2D search reached
+cv::Rect searchedRegion(const PathResult& result, const Costmap& costmap,
+                        const std::vector<Eigen::Vector2d>& offsets);
+}  // namespace astar_planner
+
+#endif
@@ -1,12 +1,20 @@
 #ifndef ASTAR_PLANNER_PLUGIN_H
 #define ASTAR_PLANNER_PLUGIN_H
 
+#include <astar_planner/astar.h>
 #include <astar_planner/costmap.h>
+#include <astar_planner/path_cost.h>
 #include <gridmap/map_data.h>
 #include <navigation_interface/path_planner.h>
 #include <opencv2/core.hpp>
 #include <ros/ros.h>
 
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 namespace astar_planner
 {
 
@@ -18,7 +26,33 @@ class AStarPlanner : public navigation_interface::PathPlanner
 
     virtual Result plan(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal,
                         const GoalSampleSettings& sample) override;
+    virtual Result plan(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal, const GoalSampleSettings& sample,
+                        const std::chrono::steady_clock::time_point& deadline) override;
+
+    // a single search which ends at the first goal it reaches
+    virtual Result plan(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                        const GoalSampleSettings& sample) override;
+    virtual Result plan(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                        const GoalSampleSettings& sample,
+                        const std::chrono::steady_clock::time_point& deadline) override;
+
+    struct BatchResult
+    {
+        Result result;
 
+        // time taken by the search of the request
+        std::chrono::duration<double> duration;
+    };
+
+    // Plans the route from the start to the goal of every request, results[i] belongs to requests[i]
+    // Safe to call from several threads, also while plan(), cost() or valid() run as it does not use their costmap.
+    // The requests share one snapshot of the map and the settings, which is kept until either changes and does not
+    // clear the footprint of the robot, and are searched in parallel on the OpenCV thread pool
+    std::vector<BatchResult> planBatch(const std::vector<std::pair<Eigen::Isometry2d, Eigen::Isometry2d>>& requests,
+                                       const GoalSampleSettings& sample);
+
+    // Bring the costmap of the last plan up to date with the map before evaluating the path, building it if there was
+    // no plan yet. Safe to call while plan() runs, they wait for its search to finish
     virtual bool valid(const navigation_interface::Path& path) const override;
     virtual double cost(const navigation_interface::Path& path) const override;
 
@@ -26,6 +60,14 @@ class AStarPlanner : public navigation_interface::PathPlanner
     virtual void onMapDataChanged() override;
 
   private:
+    // an ARA* search until deadline if there is one, otherwise a single search
+    Result plan(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                const GoalSampleSettings& sample, const std::chrono::steady_clock::time_point* deadline);
+
+    // brings costmap_ and cspace_ up to date with the map and clears the robot footprint at start
+    // costmap_mutex_ must be held
+    void updateCostmap(const Eigen::Isometry2d& start) const;
+
     bool debug_viz_ = false;
     double robot_radius_ = 0.230;
     // width of default offset = 0.185
@@ -38,12 +80,103 @@ class AStarPlanner : public navigation_interface::PathPlanner
     double strafe_mult_ = 1.5;
     double rotation_mult_ = 0.3 / M_PI;
 
+    HeuristicMode heuristic_mode_ = HeuristicMode::LAZY;
+    int threads_ = 1;
+
+    // threads_ threads evaluating successors for plan(), started once as the searches are too short to start their own
+    std::shared_ptr<ThreadPool> thread_pool_;
+
+    bool lazy_evaluation_ = false;
+    bool packed_cells_ = false;
+    AnalyticExpansionSettings analytic_expansion_;
+    AnytimeSettings anytime_;
+
+    int corridor_level_ = 0;
+    double corridor_margin_ = 1.0;
+    double corridor_min_distance_ = 5.0;
+
+    double roi_max_distance_ = 0.0;
+    double roi_margin_ = 1.0;
+
+    std::size_t landmarks_ = 0;
+
+    std::string traversal_cost_cache_;
+
+    // plans taking longer than record_threshold (s) are written to the record_plans directory for replay_plans
+    std::string record_plans_;
+    double record_threshold_ = 1.0;
+
     std::vector<Eigen::Vector2d> offsets_;
 
     ros::Publisher explore_pub_;
 
-    std::shared_ptr<Costmap> costmap_;
+    // guards costmap_, costmap_map_data_, footprint_region_, path_cost_cache_, cspace_ and the changes reported to
+    // explore_cache_, plan() holds it while it searches costmap_
+    mutable std::mutex costmap_mutex_;
+
+    // also updated by cost() and valid() when the map changed since the last plan
+    mutable std::shared_ptr<Costmap> costmap_;
     std::shared_ptr<cv::Mat> traversal_cost_;
+    double min_traversal_cost_ = 0.0;
+
+    // map the costmap was built from and the cells cleared under the robot in the last update
+    mutable std::shared_ptr<const gridmap::MapData> costmap_map_data_;
+    mutable cv::Rect footprint_region_;
+
+    // segment costs of the last path passed to cost() or valid()
+    mutable PathCostCache path_cost_cache_;
+
+    // goal rooted 2D search reused by replans to the same goal
+    std::shared_ptr<Explore2DCache> explore_cache_;
+
+    // the same for the searches within a corridor, which see different cell costs
+    std::shared_ptr<Explore2DCache> corridor_explore_cache_;
+
+    // configuration space layers of costmap_, updated with it
+    mutable std::shared_ptr<CSpace> cspace_;
+
+    // successors and rotated footprints per heading bin, rebuilt when the map resolution changes
+    std::shared_ptr<const MotionPrimitives> motion_primitives_;
+
+    // obstacle free cost-to-go near the goal, loaded from the heuristic_table file if set
+    std::string heuristic_table_file_;
+    std::shared_ptr<const HeuristicTable> heuristic_table_;
+
+    // ALT landmarks of the current map, computed in the background when the map changes
+    // map_landmarks_ is accessed atomically, planBatch reads it from other threads
+    std::future<std::shared_ptr<const Landmarks>> landmarks_future_;
+    std::shared_ptr<const Landmarks> map_landmarks_;
+
+    // incremented by onInitialize, a snapshot of planBatch taken with older settings is rebuilt
+    std::size_t settings_version_ = 0;
+
+    // the settings the requests of planBatch search with, copied under mutex_ along with the map
+    struct BatchSettings
+    {
+        std::size_t version;
+        double robot_radius;
+        double conservative_robot_radius;
+        std::vector<Eigen::Vector2d> offsets;
+        double backwards_mult;
+        double strafe_mult;
+        double rotation_mult;
+        bool packed_cells;
+        bool lazy_evaluation;
+        AnalyticExpansionSettings analytic_expansion;
+        std::shared_ptr<const HeuristicTable> heuristic_table;
+    };
+
+    // the costmap and settings shared by the requests of planBatch, only read once it is built
+    struct BatchSnapshot
+    {
+        std::shared_ptr<const gridmap::MapData> map_data;
+        std::shared_ptr<const Costmap> costmap;
+        std::shared_ptr<const CSpace> cspace;
+        std::shared_ptr<const MotionPrimitives> primitives;
+        BatchSettings settings;
+    };
+    std::mutex batch_mutex_;
+    std::shared_ptr<const BatchSnapshot> batch_snapshot_;
 };
 }  // namespace astar_planner
 
@@ -0,0 +1,24 @@
+#ifndef ASTAR_PLANNER_WAVEFRONT_H
+#define ASTAR_PLANNER_WAVEFRONT_H
+
+#include <astar_planner/astar.h>
+#include <astar_planner/costmap.h>
+#include <astar_planner/node.h>
+
+namespace astar_planner
+{
+
+// Computes the 2D cost-to-go to goal of every cell in the costmap and stores it in explore_cache
+//
+// The map is split into square tiles which are solved with Dijkstra given the costs in the 2 cell halo around them
+// (the reach of directions_2d), tiles whose border changed wake up their neighbours until nothing changes
+// Tiles are coloured in a 2x2 pattern so tiles of the same colour never touch and are solved in parallel
+//
+// If explore_cache already holds a complete field for goal only the tiles with discarded cells are solved again
+// The cell costs in explore_cache must either be empty or taken from this costmap by updateExplore2DCache
+// Returns the number of tiles solved
+std::size_t wavefront2D(const State2D& goal, Explore2DCache& explore_cache, const CollisionChecker& collision_checker,
+                        const int tile_size = 64);
+}  // namespace astar_planner
+
+#endif
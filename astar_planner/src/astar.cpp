@@ -1,13 +1,18 @@
 #include <astar_planner/astar.h>
+#include <astar_planner/parallel.h>
 #include <astar_planner/visualisation.h>
+#include <astar_planner/wavefront.h>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <cinttypes>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <numeric>
 #include <random>
 #include <sstream>
 
@@ -17,6 +22,9 @@ namespace astar_planner
 namespace
 {
 
+// successors evaluated in parallel per thread, below which they are evaluated on the search thread
+const std::size_t MIN_PARALLEL_EXPANSIONS_PER_THREAD = 2;
+
 double heuristic2d(const State2D& s1, const State2D& s2)
 {
     const double dx = s2.x - s1.x;
@@ -24,13 +32,398 @@ double heuristic2d(const State2D& s1, const State2D& s2)
     return std::sqrt(dx * dx + dy * dy);
 }
 
-struct ExploreDirection
+// The successors of a state with everything about them which does not depend on the progress of the search
+struct Expansion
+{
+    // the state the successors were generated from
+    State3D state;
+
+    std::size_t size;
+    std::array<State3D, NUM_DIRECTIONS> states;
+    std::array<uint64_t, NUM_DIRECTIONS> keys;
+
+    // false if the successor is outside the map or in collision
+    std::array<bool, NUM_DIRECTIONS> valid;
+
+    // cost of moving to the successor
+    std::array<double, NUM_DIRECTIONS> costs;
+
+    // footprint collision checks done for the successors
+    std::size_t checks;
+};
+
+struct ExpansionSettings
 {
-    double x;
-    double y;
-    double rotation;
+    const CollisionChecker& collision_checker;
+    const MotionPrimitives& primitives;
+    State3D start_state;
+    const std::vector<State3D>& goal_states;
+    double linear_resolution;
+    double angular_resolution;
+    double backwards_mult;
+    double strafe_mult;
+    double rotation_mult;
+
+    // false when the search takes improvements of closed nodes, as ARA* does
+    bool skip_closed;
+
+    // leave the footprint check and the rotation cost of successors until they reach the top of the open set
+    bool lazy_evaluation;
 };
 
+// Cost the search charges for moving from one state to the next, given the clearance of the next state
+double moveCost(const ExpansionSettings& settings, const State3D& from, const State3D& to, const double to_clearance_px)
+{
+    const CollisionChecker& collision_checker = settings.collision_checker;
+    const Costmap& costmap = collision_checker.costmap();
+
+    const Eigen::Array2i map_cell = costmap.getCellIndex({from.x, from.y});
+    const double traversal_cost_first = traversalCost(map_cell.x(), map_cell.y(), costmap);
+    const double collision_cost_first = collisionCost(map_cell.x(), map_cell.y(), collision_checker);
+
+    const double trans_x = (to.x - from.x);
+    const double trans_y = (to.y - from.y);
+
+    const double st = std::sin(to.theta);
+    const double ct = std::cos(to.theta);
+    // inverse rotation matrix
+    const double dx = (trans_x * ct + trans_y * st);
+    const double dy = (-trans_x * st + trans_y * ct);
+
+    const double trans_w = wrapAngle(to.theta - from.theta);
+
+    const double x_cost = std::abs((dx > 0) ? dx : settings.backwards_mult * dx);
+    const double y_cost = std::abs(settings.strafe_mult * dy);
+
+    const Eigen::Array2i new_map_cell = costmap.getCellIndex({to.x, to.y});
+    const double collision_cost_second = collisionCost(new_map_cell.x(), new_map_cell.y(), collision_checker);
+    const double traversal_cost_second = traversalCost(new_map_cell.x(), new_map_cell.y(), costmap);
+
+    const double collision_cost = (collision_cost_first + collision_cost_second) / 2.0;
+    const double traversal_cost = (traversal_cost_first + traversal_cost_second) / 2.0;
+
+    const double rotation_collision_cost = rotationCollisionCost(to_clearance_px * costmap.resolution);
+
+    const double rotation_cost = std::abs(trans_w) * settings.rotation_mult * rotation_collision_cost;
+    const double translation_cost = (x_cost + y_cost) * collision_cost * traversal_cost;
+
+    return translation_cost + rotation_cost;
+}
+
+// Fills expansion with the successors of state, leaving out the ones already expanded in explore_3d unless the search
+// reopens them
+// Only reads explore_3d so the successors of several states can be evaluated at once while the search waits
+void expand(const ExpansionSettings& settings, const State3D& state, const NodeIndexMap<Node3D>& explore_3d,
+            Expansion& expansion, HeadingPrimitives& scratch, ClearanceBatch& batch)
+{
+    const CollisionChecker& collision_checker = settings.collision_checker;
+    const Costmap& costmap = collision_checker.costmap();
+    const MotionPrimitives& primitives = settings.primitives;
+    const double linear_resolution = settings.linear_resolution;
+    const double angular_resolution = settings.angular_resolution;
+
+    expansion.state = state;
+    expansion.size = 0;
+
+    const auto current_key = IndexToKey(StateToIndex(state, linear_resolution, angular_resolution));
+
+    double distance_to_goal_m = std::numeric_limits<double>::max();
+    for (const State3D& goal_state : settings.goal_states)
+    {
+        const double distance_to_goal_x = std::abs(state.x - goal_state.x);
+        const double distance_to_goal_y = std::abs(state.y - goal_state.y);
+        distance_to_goal_m = std::min(distance_to_goal_m, std::sqrt(distance_to_goal_x * distance_to_goal_x +
+                                                                    distance_to_goal_y * distance_to_goal_y));
+    }
+
+    const Eigen::Array2i map_cell = costmap.getCellIndex({state.x, state.y});
+    const double traversal_cost_first = traversalCost(map_cell.x(), map_cell.y(), costmap);
+    const double collision_cost_first = collisionCost(map_cell.x(), map_cell.y(), collision_checker);
+
+    int current_theta_index;
+    const double distance_to_collision_px =
+        primitives.onBin(state.theta, current_theta_index)
+            ? collision_checker.clearance(state, primitives.footprint(current_theta_index))
+            : collision_checker.clearance(state);
+    const double distance_to_collision_m = distance_to_collision_px * costmap.resolution;
+
+    const double d_to_collision_or_goal = std::min(distance_to_collision_m, distance_to_goal_m);
+
+    // discretize
+    double res_mult = 1.0;
+    if (d_to_collision_or_goal < 0.2)
+    {
+        res_mult = 1;
+    }
+    else if (d_to_collision_or_goal < 0.4)
+    {
+        res_mult = 2;
+    }
+    else
+    {
+        res_mult = 4;
+    }
+
+    const double distance_to_start_x = std::abs(state.x - settings.start_state.x);
+    const double distance_to_start_y = std::abs(state.y - settings.start_state.y);
+    const double distance_to_start =
+        std::sqrt(distance_to_start_x * distance_to_start_x + distance_to_start_y * distance_to_start_y);
+
+    const double d_to_stuff = std::min(d_to_collision_or_goal, distance_to_start);
+    const std::size_t num_directions = d_to_stuff > 0.5 ? NUM_OPEN_DIRECTIONS : NUM_DIRECTIONS;
+
+    const HeadingPrimitives& heading = primitives.successors(state.theta, scratch);
+    const std::size_t level = MotionPrimitives::resolutionLevel(res_mult);
+    const double down_resolution = linear_resolution * res_mult;
+
+    // successors which passed the cheap checks wait for the batched collision check
+    std::array<std::size_t, NUM_DIRECTIONS> checked;
+    batch.clear();
+    for (std::size_t i = 0; i < num_directions; ++i)
+    {
+        const MotionPrimitive& primitive = heading.primitives[level][i];
+
+        // snap to the lattice of the resolution level
+        const Node3dIndex down_index{static_cast<int>(std::round((state.x + primitive.dx) / down_resolution)),
+                                     static_cast<int>(std::round((state.y + primitive.dy) / down_resolution)),
+                                     primitive.theta_index};
+        const State3D new_state = IndexToState(down_index, down_resolution, angular_resolution);
+
+        auto new_index = StateToIndex(new_state, linear_resolution, angular_resolution);
+        const auto new_key = IndexToKey(new_index);
+
+        //            ROS_ASSERT(new_key != current_key);
+        if (new_key == current_key)
+            continue;
+
+        const Node3D* existing = settings.skip_closed ? explore_3d.find(new_key) : nullptr;
+        if (existing && existing->visited)
+            continue;
+
+        const std::size_t n = expansion.size++;
+        expansion.states[n] = new_state;
+        expansion.keys[n] = new_key;
+        expansion.valid[n] = false;
+
+        if (!collision_checker.isWithinBounds(new_state))
+        {
+            continue;
+        }
+
+        if (collision_checker.inCSpaceCollision(new_state))
+        {
+            continue;
+        }
+
+        // the cost of the move if the successor is far from any obstacle, which is a lower bound
+        if (settings.lazy_evaluation)
+        {
+            expansion.valid[n] = true;
+            expansion.costs[n] = moveCost(settings, state, new_state, std::numeric_limits<double>::infinity());
+            continue;
+        }
+
+        checked[batch.size()] = n;
+        batch.add(new_state, primitives.sinTheta(primitive.theta_index), primitives.cosTheta(primitive.theta_index));
+    }
+
+    // collision check all the successors together
+    collision_checker.clearance(batch);
+    expansion.checks = batch.size();
+
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        const std::size_t n = checked[i];
+        const State3D& new_state = expansion.states[n];
+
+        const double new_state_clearance = batch.clearance[i];
+        if (new_state_clearance <= 0.0)
+        {
+            continue;
+        }
+
+        const double trans_x = (new_state.x - state.x);
+        const double trans_y = (new_state.y - state.y);
+
+        const double st = batch.sin_theta[i];
+        const double ct = batch.cos_theta[i];
+        // inverse rotation matrix
+        const double dx = (trans_x * ct + trans_y * st);
+        const double dy = (-trans_x * st + trans_y * ct);
+
+        const double trans_w = wrapAngle(new_state.theta - state.theta);
+
+        const double x_cost = std::abs((dx > 0) ? dx : settings.backwards_mult * dx);
+        const double y_cost = std::abs(settings.strafe_mult * dy);
+
+        const Eigen::Array2i new_map_cell = costmap.getCellIndex({new_state.x, new_state.y});
+        const double collision_cost_second = collisionCost(new_map_cell.x(), new_map_cell.y(), collision_checker);
+        const double traversal_cost_second = traversalCost(new_map_cell.x(), new_map_cell.y(), costmap);
+
+        const double collision_cost = (collision_cost_first + collision_cost_second) / 2.0;
+        const double traversal_cost = (traversal_cost_first + traversal_cost_second) / 2.0;
+
+        const double new_state_d_to_collision_m = new_state_clearance * costmap.resolution;
+        const double rotation_collision_cost = rotationCollisionCost(new_state_d_to_collision_m);
+
+        const double rotation_cost = std::abs(trans_w) * settings.rotation_mult * rotation_collision_cost;
+        const double translation_cost = (x_cost + y_cost) * collision_cost * traversal_cost;
+
+        expansion.valid[n] = true;
+        expansion.costs[n] = translation_cost + rotation_cost;
+    }
+}
+
+bool operator==(const State3D& lhs, const State3D& rhs)
+{
+    return lhs.x == rhs.x && lhs.y == rhs.y && lhs.theta == rhs.theta;
+}
+
+// Samples the straight move from `from` to `to` which turns at a constant rate, about every linear_resolution and
+// angular_resolution, and fills costs with the cost of reaching each sample from the previous one
+// Returns false if any sample is in collision
+bool analyticExpansion(const ExpansionSettings& settings, const State3D& from, const State3D& to,
+                       std::vector<State3D>& samples, std::vector<double>& costs)
+{
+    const CollisionChecker& collision_checker = settings.collision_checker;
+
+    samples.clear();
+    costs.clear();
+
+    const double trans_x = to.x - from.x;
+    const double trans_y = to.y - from.y;
+    const double trans_w = wrapAngle(to.theta - from.theta);
+    const double distance = std::sqrt(trans_x * trans_x + trans_y * trans_y);
+
+    const int n = std::max(1, static_cast<int>(std::max(std::ceil(distance / settings.linear_resolution),
+                                                        std::ceil(std::abs(trans_w) / settings.angular_resolution))));
+
+    State3D previous = from;
+    for (int i = 1; i <= n; ++i)
+    {
+        const double t = static_cast<double>(i) / n;
+        const State3D sample = (i == n) ? to : State3D{from.x + t * trans_x, from.y + t * trans_y,
+                                                      wrapAngle(from.theta + t * trans_w)};
+
+        if (!collision_checker.isWithinBounds(sample) || collision_checker.inCSpaceCollision(sample))
+            return false;
+
+        const double clearance = collision_checker.clearance(sample);
+        if (clearance <= 0.0)
+            return false;
+
+        samples.push_back(sample);
+        costs.push_back(moveCost(settings, previous, sample, clearance));
+        previous = sample;
+    }
+
+    return true;
+}
+
+// Index of the move in directions_2d, -1 if it is not a move
+int directionIndex(const int dx, const int dy)
+{
+    for (std::size_t i = 0; i < directions_2d.size(); ++i)
+    {
+        if (directions_2d[i].x == dx && directions_2d[i].y == dy)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// For each move from the parent of a cell, the moves from the cell to neighbours which the parent also has a move to
+// In a uniform region the move from the parent is always shorter than the two moves through the cell (the triangle
+// inequality of the move lengths), so the cell does not need to expand them
+std::array<uint16_t, directions_2d.size()> parentCoveredMoves()
+{
+    std::array<uint16_t, directions_2d.size()> covered;
+    for (std::size_t d = 0; d < directions_2d.size(); ++d)
+    {
+        covered[d] = 0;
+        for (std::size_t e = 0; e < directions_2d.size(); ++e)
+        {
+            const State2D move = directions_2d[d] + directions_2d[e];
+            if ((move.x == 0 && move.y == 0) || directionIndex(move.x, move.y) >= 0)
+                covered[d] |= static_cast<uint16_t>(1 << e);
+        }
+    }
+    return covered;
+}
+
+// Classifies the cells of the block of cell in explore_cache, cells near the edge of the map are never uniform
+void classifyUniformCells(const State2D& cell, const CollisionChecker& collision_checker,
+                          const float closest_distance_px, Explore2DCache& explore_cache)
+{
+    const Costmap& costmap = collision_checker.costmap();
+    const int reach = 2;
+
+    const int x0 = (cell.x / Explore2DCache::UNIFORM_BLOCK) * Explore2DCache::UNIFORM_BLOCK;
+    const int y0 = (cell.y / Explore2DCache::UNIFORM_BLOCK) * Explore2DCache::UNIFORM_BLOCK;
+    const int x1 = std::min(x0 + Explore2DCache::UNIFORM_BLOCK, costmap.width);
+    const int y1 = std::min(y0 + Explore2DCache::UNIFORM_BLOCK, costmap.height);
+
+    // costs of the block and its halo, computed as the search computes them
+    const int hx0 = std::max(0, x0 - reach);
+    const int hy0 = std::max(0, y0 - reach);
+    const int hx1 = std::min(costmap.width, x1 + reach);
+    const int hy1 = std::min(costmap.height, y1 + reach);
+    const int halo_width = hx1 - hx0;
+    std::vector<std::pair<double, double>> costs(static_cast<std::size_t>(halo_width * (hy1 - hy0)));
+    bool all_same = true;
+    for (int y = hy0; y < hy1; ++y)
+    {
+        const float* distance_to_collision = costmap.distance_to_collision.ptr<float>(y);
+        const float* traversal_cost = costmap.traversal_cost->ptr<float>(y);
+        std::pair<double, double>* row = &costs[static_cast<std::size_t>((y - hy0) * halo_width)];
+        for (int x = hx0; x < hx1; ++x)
+        {
+            if (distance_to_collision[x] <= closest_distance_px)
+                row[x - hx0] = {std::numeric_limits<double>::infinity(), 0.0};
+            else
+                row[x - hx0] = {collision_checker.collisionCost(static_cast<int>(distance_to_collision[x])),
+                                static_cast<double>(traversal_cost[x])};
+            all_same = all_same && row[x - hx0] == costs.front();
+        }
+    }
+
+    auto cost = [&](const int x, const int y) -> const std::pair<double, double>& {
+        return costs[static_cast<std::size_t>((y - hy0) * halo_width + (x - hx0))];
+    };
+
+    // whether the cells within reach along the row cost the same, for the rows of the halo
+    const int block_width = x1 - x0;
+    std::vector<uint8_t> row_uniform(static_cast<std::size_t>(block_width * (hy1 - hy0)), all_same);
+    if (!all_same)
+    {
+        for (int y = hy0; y < hy1; ++y)
+        {
+            for (int x = std::max(x0, reach); x < std::min(x1, costmap.width - reach); ++x)
+            {
+                bool same = true;
+                for (int u = x - reach; u <= x + reach && same; ++u)
+                    same = cost(u, y) == cost(x, y);
+                row_uniform[static_cast<std::size_t>((y - hy0) * block_width + (x - x0))] = same;
+            }
+        }
+    }
+
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; ++x)
+        {
+            bool is_uniform = x >= reach && x < costmap.width - reach && y >= reach && y < costmap.height - reach &&
+                              std::isfinite(cost(x, y).first);
+            for (int v = y - reach; v <= y + reach && is_uniform && !all_same; ++v)
+                is_uniform = row_uniform[static_cast<std::size_t>((v - hy0) * block_width + (x - x0))] &&
+                             cost(x, v) == cost(x, y);
+
+            explore_cache.setUniform(costmap.to2DGridIndex({x, y}), is_uniform);
+        }
+    }
+
+    explore_cache.setUniformClassified(cell);
+}
+
 }  // namespace
 
 // This is using the costmap (which is inflated the robot offset radius)
@@ -52,8 +445,15 @@ double traversalCost(const int map_x, const int map_y, const Costmap& costmap)
     return static_cast<double>(costmap.traversal_cost->at<float>(map_y, map_x));
 }
 
-ShortestPath2D shortestPath2D(const State2D& start, const State2D& goal, Explore2DCache& explore_cache,
-                              const CollisionChecker& collision_checker)
+namespace
+{
+
+// the search of shortestPath2D rooted at all of goals at once, so the cost of a cell is that of its nearest goal
+// cells reads the distance and traversal cost of a cell in the layout of the costmap
+template <typename Cells>
+ShortestPath2D shortestPath2D(const State2D& start, const State2D* goals, const std::size_t goal_count,
+                              Explore2DCache& explore_cache, const CollisionChecker& collision_checker,
+                              const Cells& cells)
 {
     const Costmap& costmap = collision_checker.costmap();
 
@@ -63,11 +463,15 @@ ShortestPath2D shortestPath2D(const State2D& start, const State2D& goal, Explore
     ROS_ASSERT(start.y >= 0);
     ROS_ASSERT(start.y < costmap.height);
 
-    ROS_ASSERT(goal.x >= 0);
-    ROS_ASSERT(goal.x < costmap.width);
+    ROS_ASSERT(goal_count > 0);
+    for (std::size_t i = 0; i < goal_count; ++i)
+    {
+        ROS_ASSERT(goals[i].x >= 0);
+        ROS_ASSERT(goals[i].x < costmap.width);
 
-    ROS_ASSERT(goal.y >= 0);
-    ROS_ASSERT(goal.y < costmap.height);
+        ROS_ASSERT(goals[i].y >= 0);
+        ROS_ASSERT(goals[i].y < costmap.height);
+    }
 
     ROS_ASSERT(costmap.traversal_cost);
 
@@ -80,7 +484,15 @@ ShortestPath2D shortestPath2D(const State2D& start, const State2D& goal, Explore
     {
         return {false, nullptr, 0};
     }
-    if (costmap.distance_to_collision.at<float>(goal.y, goal.x) <= closest_distance_px)
+
+    // goals in collision are left out, the search fails if that leaves none
+    std::size_t free_goals = 0;
+    for (std::size_t i = 0; i < goal_count; ++i)
+    {
+        if (costmap.distance_to_collision.at<float>(goals[i].y, goals[i].x) > closest_distance_px)
+            ++free_goals;
+    }
+    if (free_goals == 0)
     {
         return {false, nullptr, 0};
     }
@@ -89,62 +501,83 @@ ShortestPath2D shortestPath2D(const State2D& start, const State2D& goal, Explore
     // reverse order so that we can reuse the explore data structure as the start state changes
 
     const std::size_t start_index = costmap.to2DGridIndex(start);
-    const std::size_t goal_index = costmap.to2DGridIndex(goal);
 
-    auto goal_it = explore_cache.explore_2d.find(goal_index);
-    if (goal_it == explore_cache.explore_2d.end())
+    ROS_ASSERT(explore_cache.width() == costmap.width);
+    ROS_ASSERT(explore_cache.height() == costmap.height);
+
+    // the landmarks only apply to the map they were computed for
+    const Landmarks* landmarks = explore_cache.landmarks.get();
+    if (landmarks && (landmarks->width() != costmap.width || landmarks->height() != costmap.height))
+        landmarks = nullptr;
+
+    const uint16_t* start_distances = landmarks ? landmarks->distances(start) : nullptr;
+    auto heuristic = [&](const State2D& state) {
+        const double h = heuristic2d(state, start);
+        return landmarks ? std::max(h, landmarks->lowerBound(state, start_distances)) : h;
+    };
+
+    for (std::size_t i = 0; i < goal_count; ++i)
     {
-        bool success;
-        std::tie(goal_it, success) =
-            explore_cache.explore_2d.insert({goal_index, Node2D{goal, nullptr, false, 0, heuristic2d(goal, start)}});
+        const std::size_t goal_index = costmap.to2DGridIndex(goals[i]);
+        if (costmap.distance_to_collision.at<float>(goals[i].y, goals[i].x) > closest_distance_px &&
+            !explore_cache.find(goal_index))
+        {
+            explore_cache.insert(goal_index, Node2D{goals[i], nullptr, 0, heuristic(goals[i])});
+            explore_cache.searched_cells.push_back(goal_index);
+        }
     }
 
-    auto start_it = explore_cache.explore_2d.find(start_index);
-    if (start_it != explore_cache.explore_2d.end())
+    Node2D* start_node = explore_cache.find(start_index);
+    if (start_node)
     {
-        return {true, &(start_it->second), 0};
+        return {true, start_node, 0};
     }
 
-    std::unordered_map<std::size_t, PriorityQueue2D::handle_type>
-        handles;  // explore_cache.explore_2d.size(), PriorityQueue2D::handle_type{nullptr});
-
-    PriorityQueue2D* open_set = new PriorityQueue2D();
+    PriorityQueue2D& open_set = explore_cache.open_set;
 
     // re-calculate the heuristic
     // the start-state is moving, so the fastest way to get their changes
     // consequently the priority queue needs to be resorted
-    // so we copy all nodes from the last priority queue into a new one but recalculate heuristics
+    // so we recalculate the heuristics of all nodes in the open set and rebuild the heap in place
     // all nodes which have already been searched remain searched and contain valid shortest paths
-    if (explore_cache.open_set)
+    if (explore_cache.started)
     {
-        handles.reserve(explore_cache.open_set->size());
-        for (const auto& item : *explore_cache.open_set)
+        for (const auto& item : open_set)
         {
-            item->cost_to_go = heuristic2d(item->state, start);
-            handles[costmap.to2DGridIndex(item->state)] = open_set->push(item);
+            item->cost_to_go = heuristic(item->state);
         }
+        open_set.rebuild();
     }
     else
     {
         // start exploring from goal state
-        open_set = new PriorityQueue2D();
-        goal_it->second.cost_to_go = heuristic2d(goal_it->second.state, start);
-        handles[goal_index] = open_set->push(&goal_it->second);
+        explore_cache.started = true;
+        for (std::size_t i = 0; i < goal_count; ++i)
+        {
+            Node2D* goal_node = explore_cache.find(costmap.to2DGridIndex(goals[i]));
+            if (goal_node && !open_set.contains(goal_node))
+            {
+                goal_node->cost_to_go = heuristic(goal_node->state);
+                open_set.push(goal_node);
+            }
+        }
     }
 
+    static const std::array<uint16_t, directions_2d.size()> parent_covered_moves = parentCoveredMoves();
+
     size_t itr = 0;
     const size_t max_iterations = costmap.width * costmap.height;
 
     bool solution_found = false;
-    while (!open_set->empty() && itr++ < max_iterations)
+    while (!open_set.empty() && itr++ < max_iterations)
     {
-        auto current_node = open_set->top();
-        open_set->pop();
+        auto current_node = open_set.top();
+        open_set.pop();
 
         const std::size_t current_index = costmap.to2DGridIndex(current_node->state);
 
-        ROS_ASSERT(!current_node->visited);
-        current_node->visited = true;
+        ROS_ASSERT(!explore_cache.visited(current_index));
+        explore_cache.setVisited(current_index);
 
         if (current_index == start_index)
         {
@@ -152,8 +585,39 @@ ShortestPath2D shortestPath2D(const State2D& start, const State2D& goal, Explore
             break;
         }
 
+        // Inside a uniform region the expanded parent already offered the neighbours it has a move to a cheaper path
+        // than the one through this cell, like the pruning of jump point search. The parent of a node re-seeded by
+        // updateExplore2DCache may not have been expanded again yet, in which case nothing is skipped
+        if (!explore_cache.uniformClassified(current_node->state))
+            classifyUniformCells(current_node->state, collision_checker, closest_distance_px, explore_cache);
+
+        const bool uniform = explore_cache.uniform(current_index);
+        uint16_t skip = 0;
+        double uniform_collision_cost = 0;
+        double uniform_traversal_cost = 0;
+        if (uniform)
+        {
+            const Node2D* parent = current_node->parent;
+            if (parent && explore_cache.visited(explore_cache.indexOf(parent)))
+            {
+                const int direction = directionIndex(current_node->state.x - parent->state.x,
+                                                     current_node->state.y - parent->state.y);
+                if (direction >= 0)
+                    skip = parent_covered_moves[static_cast<std::size_t>(direction)];
+            }
+
+            const CostmapCell cell = cells(current_node->state.x, current_node->state.y);
+            uniform_collision_cost = collision_checker.collisionCost(static_cast<int>(cell.distance_to_collision));
+            uniform_traversal_cost = static_cast<double>(cell.traversal_cost);
+        }
+
         for (std::size_t i = 0; i < directions_2d.size(); ++i)
         {
+            if ((skip >> i) & 1)
+            {
+                continue;
+            }
+
             const State2D new_state = current_node->state + directions_2d[i];
 
             if (new_state.x < 0 || new_state.x >= costmap.width || new_state.y < 0 || new_state.y >= costmap.height)
@@ -162,68 +626,91 @@ ShortestPath2D shortestPath2D(const State2D& start, const State2D& goal, Explore
             }
 
             const std::size_t new_index = costmap.to2DGridIndex(new_state);
-            auto new_node_it = explore_cache.explore_2d.find(new_index);
-
-            // Allocate if necessary
-            if (new_node_it == explore_cache.explore_2d.end())
-            {
-                bool success;
-                std::tie(new_node_it, success) = explore_cache.explore_2d.insert(
-                    {new_index, Node2D{new_state, current_node, false, std::numeric_limits<double>::max(),
-                                       std::numeric_limits<double>::max()}});
-            }
-            else if (new_node_it->second.visited)
+            if (explore_cache.visited(new_index))
             {
                 continue;
             }
 
-            if (costmap.distance_to_collision.at<float>(new_state.y, new_state.x) <= closest_distance_px)
+            // Allocate if necessary
+            Node2D* new_node = explore_cache.find(new_index);
+            if (!new_node)
             {
-                continue;
+                new_node = explore_cache.insert(new_index, Node2D{new_state, current_node,
+                                                                  std::numeric_limits<double>::max(),
+                                                                  std::numeric_limits<double>::max()});
+                explore_cache.searched_cells.push_back(new_index);
             }
 
-            // add cost to distance from collisions
-            // this keeps a nice boundary away from objects
-            const double collision_cost = collisionCost(new_state.x, new_state.y, collision_checker);
-            const double traversal_cost = traversalCost(new_state.x, new_state.y, costmap);
+            double collision_cost = uniform_collision_cost;
+            double traversal_cost = uniform_traversal_cost;
+            if (!uniform)
+            {
+                const CostmapCell cell = cells(new_state.x, new_state.y);
+                if (cell.distance_to_collision <= closest_distance_px)
+                {
+                    continue;
+                }
+
+                // add cost to distance from collisions
+                // this keeps a nice boundary away from objects
+                collision_cost = collision_checker.collisionCost(static_cast<int>(cell.distance_to_collision));
+                traversal_cost = static_cast<double>(cell.traversal_cost);
+            }
 
             const double cost_so_far =
                 current_node->cost_so_far + directions_2d_cost[i] * traversal_cost * collision_cost;
-            if (cost_so_far < new_node_it->second.cost_so_far)
+            if (cost_so_far < new_node->cost_so_far)
             {
-                new_node_it->second.cost_so_far = cost_so_far;
-                new_node_it->second.cost_to_go = heuristic2d(new_state, start);
-
-                new_node_it->second.parent = current_node;
+                new_node->cost_so_far = cost_so_far;
+                new_node->parent = current_node;
 
-                if (handles[new_index].node_)
-                    open_set->decrease(handles[new_index]);
+                // the heuristic of a queued node is already that of the current start
+                if (open_set.contains(new_node))
+                {
+                    open_set.decrease(new_node);
+                }
                 else
-                    handles[new_index] = open_set->push(&new_node_it->second);
+                {
+                    new_node->cost_to_go = heuristic(new_state);
+                    open_set.push(new_node);
+                }
             }
         }
     }
 
-    if (explore_cache.open_set)
-        delete explore_cache.open_set;
-    explore_cache.open_set = open_set;
-
-    start_it = explore_cache.explore_2d.find(start_index);
-    Node2D* node_ptr = (start_it != explore_cache.explore_2d.end()) ? &start_it->second : nullptr;
+    return {solution_found, explore_cache.find(start_index), itr};
+}
 
-    return {solution_found, node_ptr, itr};
+// the layout of the cells is picked once per search instead of for every neighbour
+ShortestPath2D shortestPath2D(const State2D& start, const State2D* goals, const std::size_t goal_count,
+                              Explore2DCache& explore_cache, const CollisionChecker& collision_checker)
+{
+    const Costmap& costmap = collision_checker.costmap();
+    ROS_ASSERT(costmap.traversal_cost);
+    if (costmap.cells.empty())
+        return shortestPath2D(start, goals, goal_count, explore_cache, collision_checker, PlanarCells(costmap));
+    return shortestPath2D(start, goals, goal_count, explore_cache, collision_checker, PackedCells(costmap));
 }
 
-double updateH(const State2D& state, const State2D& goal, Explore2DCache& explore_cache,
-               const CollisionChecker& collision_checker)
+double updateH(const State2D& state, const State2D* goals, const std::size_t goal_count,
+               Explore2DCache& explore_cache, const CollisionChecker& collision_checker)
 {
     const Costmap& costmap = collision_checker.costmap();
 
-    if (state == goal)
+    if (std::find(goals, goals + goal_count, state) != goals + goal_count)
         return 0.0;
 
+    if (explore_cache.complete)
+    {
+        const Node2D* node = explore_cache.find(costmap.to2DGridIndex(state));
+        if (node && node->cost_so_far < std::numeric_limits<double>::max())
+            return node->cost_so_far * costmap.resolution * 1.1;
+        else
+            return std::numeric_limits<double>::max();
+    }
+
     // shortest path 2d with obstacles
-    auto ret = shortestPath2D(state, goal, explore_cache, collision_checker);
+    auto ret = shortestPath2D(state, goals, goal_count, explore_cache, collision_checker);
 
     if (ret.success)
     {
@@ -237,16 +724,338 @@ double updateH(const State2D& state, const State2D& goal, Explore2DCache& explor
     }
 }
 
-PathResult hybridAStar(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal, const size_t max_iterations,
-                       const CollisionChecker& collision_checker, double linear_resolution,
-                       const double angular_resolution,
-                       const navigation_interface::PathPlanner::GoalSampleSettings& goal_sample_settings,
-                       const double backwards_mult, const double strafe_mult, const double rotation_mult)
+}  // namespace
+
+ShortestPath2D shortestPath2D(const State2D& start, const State2D& goal, Explore2DCache& explore_cache,
+                              const CollisionChecker& collision_checker)
+{
+    return shortestPath2D(start, &goal, 1, explore_cache, collision_checker);
+}
+
+ShortestPath2D shortestPath2D(const State2D& start, const std::vector<State2D>& goals, Explore2DCache& explore_cache,
+                              const CollisionChecker& collision_checker)
+{
+    return shortestPath2D(start, goals.data(), goals.size(), explore_cache, collision_checker);
+}
+
+double updateH(const State2D& state, const State2D& goal, Explore2DCache& explore_cache,
+               const CollisionChecker& collision_checker)
+{
+    return updateH(state, &goal, 1, explore_cache, collision_checker);
+}
+
+double updateH(const State2D& state, const std::vector<State2D>& goals, Explore2DCache& explore_cache,
+               const CollisionChecker& collision_checker)
+{
+    return updateH(state, goals.data(), goals.size(), explore_cache, collision_checker);
+}
+
+void cellCosts2D(const CollisionChecker& collision_checker, std::vector<float>& cell_costs)
+{
+    const Costmap& costmap = collision_checker.costmap();
+    cell_costs.resize(static_cast<std::size_t>(costmap.width) * static_cast<std::size_t>(costmap.height));
+    cellCosts2D(collision_checker, cv::Rect(0, 0, costmap.width, costmap.height), cell_costs);
+}
+
+void cellCosts2D(const CollisionChecker& collision_checker, const cv::Rect& region, std::vector<float>& cell_costs)
 {
     const Costmap& costmap = collision_checker.costmap();
+
+    ROS_ASSERT(costmap.traversal_cost);
+    ROS_ASSERT(cell_costs.size() == static_cast<std::size_t>(costmap.width) * static_cast<std::size_t>(costmap.height));
+
+    const float closest_distance_px =
+        static_cast<float>((collision_checker.conservativeRadius() - costmap.inflation_radius) / costmap.resolution);
+
+    const cv::Rect roi = region & cv::Rect(0, 0, costmap.width, costmap.height);
+    for (int y = roi.y; y < roi.y + roi.height; ++y)
+    {
+        const float* distance_to_collision = costmap.distance_to_collision.ptr<float>(y);
+        const float* traversal_cost = costmap.traversal_cost->ptr<float>(y);
+        float* cell_cost = &cell_costs[static_cast<std::size_t>(y) * static_cast<std::size_t>(costmap.width)];
+        for (int x = roi.x; x < roi.x + roi.width; ++x)
+        {
+            if (distance_to_collision[x] <= closest_distance_px)
+                cell_cost[x] = std::numeric_limits<float>::infinity();
+            else
+                cell_cost[x] = static_cast<float>(
+                    collision_checker.collisionCost(static_cast<int>(distance_to_collision[x])) * traversal_cost[x]);
+        }
+    }
+}
+
+std::size_t updateExplore2DCache(Explore2DCache& explore_cache, const State2D& goal,
+                                 const CollisionChecker& collision_checker)
+{
+    const Costmap& costmap = collision_checker.costmap();
+    const std::size_t size = static_cast<std::size_t>(costmap.width) * static_cast<std::size_t>(costmap.height);
+
+    const bool same_search = explore_cache.started && explore_cache.goal == goal &&
+                             explore_cache.width() == costmap.width && explore_cache.height() == costmap.height &&
+                             explore_cache.cell_costs.size() == size;
+
+    // cells whose cost of entering changed, with their old cost
+    std::vector<std::pair<std::size_t, float>> changed;
+
+    // a cell is entered from up to 2 cells away, so the neighbours of a changed region are affected as well
+    std::vector<cv::Rect> regions;
+    const bool regional = same_search && explore_cache.track_changes && !explore_cache.all_changed;
+    if (regional)
+    {
+        for (const cv::Rect& region : explore_cache.changed_regions)
+        {
+            const cv::Rect roi = cv::Rect(region.x - 2, region.y - 2, region.width + 4, region.height + 4) &
+                                 cv::Rect(0, 0, costmap.width, costmap.height);
+            if (roi.area() > 0)
+                regions.push_back(roi);
+        }
+
+        // the regions may overlap, a cell is only reported by the first region which changes it
+        std::vector<float> old_costs;
+        for (const cv::Rect& roi : regions)
+        {
+            old_costs.clear();
+            for (int y = roi.y; y < roi.y + roi.height; ++y)
+                for (int x = roi.x; x < roi.x + roi.width; ++x)
+                    old_costs.push_back(explore_cache.cell_costs[costmap.to2DGridIndex({x, y})]);
+
+            cellCosts2D(collision_checker, roi, explore_cache.cell_costs);
+
+            std::size_t i = 0;
+            for (int y = roi.y; y < roi.y + roi.height; ++y)
+            {
+                for (int x = roi.x; x < roi.x + roi.width; ++x, ++i)
+                {
+                    const std::size_t index = costmap.to2DGridIndex({x, y});
+                    if (explore_cache.cell_costs[index] != old_costs[i])
+                        changed.push_back({index, old_costs[i]});
+                }
+            }
+        }
+    }
+    else
+    {
+        // snapshot the cost of entering each cell, this is all the 2D search depends on
+        std::vector<float> cell_costs;
+        cellCosts2D(collision_checker, cell_costs);
+
+        if (!same_search)
+        {
+            explore_cache.reset(costmap.width, costmap.height);
+            explore_cache.goal = goal;
+            explore_cache.cell_costs.swap(cell_costs);
+            return 0;
+        }
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (explore_cache.cell_costs[i] != cell_costs[i])
+                changed.push_back({i, explore_cache.cell_costs[i]});
+        }
+        explore_cache.cell_costs.swap(cell_costs);
+    }
+
+    explore_cache.changed_regions.clear();
+    explore_cache.all_changed = false;
+
+    if (changed.empty())
+        return 0;
+
+    // nodes in cells which changed cost are discarded
+    // when a cell got cheaper all nodes costing more than the cheapest way into the cell might now have a shorter path
+    // through it, so they are discarded as well
+    std::vector<std::size_t> seeds;
+    double truncate_cost = std::numeric_limits<double>::max();
+    for (const auto& cell : changed)
+    {
+        const std::size_t index = cell.first;
+        if (explore_cache.find(index))
+            seeds.push_back(index);
+
+        const float new_cost = explore_cache.cell_costs[index];
+        if (new_cost < cell.second)
+        {
+            const State2D state{static_cast<int>(index % static_cast<std::size_t>(costmap.width)),
+                                static_cast<int>(index / static_cast<std::size_t>(costmap.width))};
+            for (std::size_t i = 0; i < directions_2d.size(); ++i)
+            {
+                const State2D neighbour = state + directions_2d[i];
+                if (!collision_checker.isWithinBounds(neighbour))
+                    continue;
+
+                const Node2D* node = explore_cache.find(costmap.to2DGridIndex(neighbour));
+                if (node && node->cost_so_far < std::numeric_limits<double>::max())
+                    truncate_cost = std::min(truncate_cost, node->cost_so_far + directions_2d_cost[i] * new_cost);
+            }
+        }
+    }
+
+    // drops the cells whose node was discarded since and the repeated cells
+    auto compact_searched_cells = [&explore_cache]() {
+        std::vector<std::size_t>& searched = explore_cache.searched_cells;
+        searched.erase(std::remove_if(searched.begin(), searched.end(),
+                                      [&](const std::size_t i) { return !explore_cache.find(i); }),
+                       searched.end());
+        std::sort(searched.begin(), searched.end());
+        searched.erase(std::unique(searched.begin(), searched.end()), searched.end());
+    };
+
+    if (truncate_cost < std::numeric_limits<double>::max())
+    {
+        auto truncated = [&](const std::size_t index) {
+            const Node2D* node = explore_cache.find(index);
+            return node && node->cost_so_far > truncate_cost && node->cost_so_far < std::numeric_limits<double>::max();
+        };
+
+        // a lazy search remembers the cells it reached, a complete one reached them all
+        if (explore_cache.complete)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+                if (truncated(i))
+                    seeds.push_back(i);
+        }
+        else
+        {
+            compact_searched_cells();
+            for (const std::size_t i : explore_cache.searched_cells)
+                if (truncated(i))
+                    seeds.push_back(i);
+        }
+    }
+
+    // everything below a discarded node in the search tree is discarded too
+    // the parent of a node is always one of its neighbours, so the children are found among them
+    // erasing leaves the storage of a node untouched, so its state and address stay usable below
+    std::vector<const Node2D*> discarded;
+    auto discard = [&](const std::size_t index) {
+        Node2D* node = explore_cache.find(index);
+        if (!node)
+            return;
+
+        if (explore_cache.open_set.contains(node))
+            explore_cache.open_set.erase(node);
+        explore_cache.erase(index);
+        discarded.push_back(node);
+    };
+
+    for (const std::size_t index : seeds)
+        discard(index);
+
+    for (std::size_t d = 0; d < discarded.size(); ++d)
+    {
+        const Node2D* parent = discarded[d];
+        for (const State2D& direction : directions_2d)
+        {
+            const State2D neighbour = parent->state + direction;
+            if (!collision_checker.isWithinBounds(neighbour))
+                continue;
+
+            const std::size_t neighbour_index = costmap.to2DGridIndex(neighbour);
+            const Node2D* node = explore_cache.find(neighbour_index);
+            if (node && node->parent == parent)
+                discard(neighbour_index);
+        }
+    }
+
+    if (!explore_cache.find(costmap.to2DGridIndex(goal)))
+    {
+        // the count includes the nodes kept so far, which are thrown away with the goal
+        std::size_t count = discarded.size();
+        if (explore_cache.complete)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+                count += explore_cache.find(i) ? 1 : 0;
+        }
+        else
+        {
+            compact_searched_cells();
+            count += explore_cache.searched_cells.size();
+        }
+
+        std::vector<float> cell_costs;
+        cell_costs.swap(explore_cache.cell_costs);
+        explore_cache.reset(costmap.width, costmap.height);
+        explore_cache.goal = goal;
+        explore_cache.cell_costs.swap(cell_costs);
+        return count;
+    }
+
+    if (regional)
+    {
+        // whether a cell is uniform depends on the cells within reach of it
+        for (const cv::Rect& roi : regions)
+            explore_cache.resetUniform(cv::Rect(roi.x - 2, roi.y - 2, roi.width + 4, roi.height + 4) &
+                                       cv::Rect(0, 0, costmap.width, costmap.height));
+    }
+    else
+    {
+        explore_cache.resetUniform();
+    }
+
+    // expanded nodes next to the discarded cells need to be expanded again for the search to reach them
+    // a complete cache is refilled by wavefront2D instead
+    if (!explore_cache.complete)
+    {
+        for (const Node2D* discarded_node : discarded)
+        {
+            for (const State2D& direction : directions_2d)
+            {
+                const State2D neighbour = discarded_node->state + direction;
+                if (!collision_checker.isWithinBounds(neighbour))
+                    continue;
+
+                const std::size_t neighbour_index = costmap.to2DGridIndex(neighbour);
+                Node2D* node = explore_cache.find(neighbour_index);
+                if (!node || !explore_cache.visited(neighbour_index))
+                    continue;
+
+                explore_cache.clearVisited(neighbour_index);
+                explore_cache.open_set.push(node);
+            }
+        }
+    }
+
+    // the cells searched again after a discard are listed twice, keep the list from outgrowing the map
+    if (explore_cache.searched_cells.size() > size)
+        compact_searched_cells();
+
+    return discarded.size();
+}
+
+namespace
+{
+
+// Without anytime settings a single search with the plain heuristic which ends at the first path
+// With several goals the search ends at whichever goal it reaches first, which is the cheapest to reach
+PathResult search(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                  const size_t max_iterations, const CollisionChecker& collision_checker, double linear_resolution,
+                  const double angular_resolution,
+                  const navigation_interface::PathPlanner::GoalSampleSettings& goal_sample_settings,
+                  const double backwards_mult, const double strafe_mult, const double rotation_mult,
+                  const SearchOptions& options, const AnytimeSettings* anytime,
+                  const std::chrono::steady_clock::time_point& deadline)
+{
+    ROS_ASSERT_MSG(!goals.empty(), "No goals to plan to");
+
+    const std::shared_ptr<Explore2DCache>& explore_cache = options.explore_cache;
+    const HeuristicMode heuristic_mode = options.heuristic_mode;
+    const std::shared_ptr<ThreadPool>& thread_pool = options.thread_pool;
+    const AnalyticExpansionSettings& analytic_expansion = options.analytic_expansion;
+    const bool lazy_evaluation = options.lazy_evaluation;
+    const std::shared_ptr<const HeuristicTable>& heuristic_table = options.heuristic_table;
+
+    const Costmap& costmap = collision_checker.costmap();
+
+    // a shared cache is rooted at a single goal, a search for several goals grows a cache of its own
+    const bool multiple_goals = goals.size() > 1;
+    const std::shared_ptr<Explore2DCache> shared_cache = multiple_goals ? nullptr : explore_cache;
+
     PathResult result;
+    result.explore_cache = shared_cache ? shared_cache : std::make_shared<Explore2DCache>();
+    if (multiple_goals && explore_cache)
+        result.explore_cache->landmarks = explore_cache->landmarks;
     result.start = start;
-    result.goal = goal;
+    result.goal = goals.front();
     result.success = false;
     result.start_in_collision = false;
     result.goal_in_collision = false;
@@ -255,8 +1064,6 @@ PathResult hybridAStar(const Eigen::Isometry2d& start, const Eigen::Isometry2d&
 
     const State3D start_state{start.translation().x(), start.translation().y(),
                               Eigen::Rotation2Dd(start.linear()).smallestAngle()};
-    const State3D nominal_goal_state{goal.translation().x(), goal.translation().y(),
-                                     Eigen::Rotation2Dd(goal.linear()).smallestAngle()};
 
     if (!collision_checker.isValid(start_state))
     {
@@ -269,282 +1076,673 @@ PathResult hybridAStar(const Eigen::Isometry2d& start, const Eigen::Isometry2d&
     ROS_ASSERT_MSG(goal_sample_settings.std_y >= 0.0, "Goal Sample Standard Deviation Y is negative");
     ROS_ASSERT_MSG(goal_sample_settings.std_w >= 0.0, "Goal Sample Standard Deviation W is negative");
 
-    State3D goal_state = nominal_goal_state;
-    result.goal_in_collision = !collision_checker.isValid(goal_state);
+    const bool sample_goals = goal_sample_settings.std_x > std::numeric_limits<double>::epsilon() ||
+                              goal_sample_settings.std_y > std::numeric_limits<double>::epsilon() ||
+                              goal_sample_settings.std_w > std::numeric_limits<double>::epsilon();
 
-    if (goal_sample_settings.std_x > std::numeric_limits<double>::epsilon() ||
-        goal_sample_settings.std_y > std::numeric_limits<double>::epsilon() ||
-        goal_sample_settings.std_w > std::numeric_limits<double>::epsilon())
+    // goals without a valid sample are left out, along with the index of the goal each state was sampled for
+    std::vector<State3D> goal_states;
+    std::vector<std::size_t> goal_sources;
+    for (std::size_t i = 0; i < goals.size(); ++i)
     {
-        std::random_device rd{};
-        std::mt19937 gen{rd()};
-        std::normal_distribution<double> dist_x{
-            0, std::max(std::numeric_limits<double>::epsilon(), goal_sample_settings.std_x)};
-        std::normal_distribution<double> dist_y{
-            0, std::max(std::numeric_limits<double>::epsilon(), goal_sample_settings.std_y)};
-        std::normal_distribution<double> dist_w{
-            0, std::max(std::numeric_limits<double>::epsilon(), goal_sample_settings.std_w)};
-        std::size_t samples = 0;
+        const Eigen::Isometry2d& goal = goals[i];
+        State3D goal_state{goal.translation().x(), goal.translation().y(),
+                           Eigen::Rotation2Dd(goal.linear()).smallestAngle()};
+        bool goal_in_collision = !collision_checker.isValid(goal_state);
 
-        while (result.goal_in_collision)
+        if (goal_in_collision && sample_goals)
         {
-            if (++samples > goal_sample_settings.max_samples)
-                return result;
-
-            const Eigen::Isometry2d sample_wrt_robot =
-                Eigen::Translation2d(dist_x(gen), dist_y(gen)) * Eigen::Rotation2Dd(dist_w(gen));
-            const Eigen::Isometry2d sample_wrt_goal = goal * sample_wrt_robot;
+            std::random_device rd{};
+            std::mt19937 gen{rd()};
+            std::normal_distribution<double> dist_x{
+                0, std::max(std::numeric_limits<double>::epsilon(), goal_sample_settings.std_x)};
+            std::normal_distribution<double> dist_y{
+                0, std::max(std::numeric_limits<double>::epsilon(), goal_sample_settings.std_y)};
+            std::normal_distribution<double> dist_w{
+                0, std::max(std::numeric_limits<double>::epsilon(), goal_sample_settings.std_w)};
+            std::size_t samples = 0;
+
+            while (goal_in_collision && ++samples <= goal_sample_settings.max_samples)
+            {
+                const Eigen::Isometry2d sample_wrt_robot =
+                    Eigen::Translation2d(dist_x(gen), dist_y(gen)) * Eigen::Rotation2Dd(dist_w(gen));
+                const Eigen::Isometry2d sample_wrt_goal = goal * sample_wrt_robot;
+
+                goal_state.x = sample_wrt_goal.translation().x();
+                goal_state.y = sample_wrt_goal.translation().y();
+                goal_state.theta = Eigen::Rotation2Dd(sample_wrt_goal.linear()).smallestAngle();
+                goal_in_collision = !collision_checker.isValid(goal_state);
+            }
+        }
 
-            goal_state.x = sample_wrt_goal.translation().x();
-            goal_state.y = sample_wrt_goal.translation().y();
-            goal_state.theta = Eigen::Rotation2Dd(sample_wrt_goal.linear()).smallestAngle();
-            result.goal_in_collision = !collision_checker.isValid(goal_state);
+        if (!goal_in_collision)
+        {
+            goal_states.push_back(goal_state);
+            goal_sources.push_back(i);
         }
     }
-    else if (result.goal_in_collision)
+
+    if (goal_states.empty())
     {
+        result.goal_in_collision = true;
         return result;
     }
 
     PriorityQueue3D open_set;
-    std::unordered_map<uint64_t, PriorityQueue3D::handle_type> handles;
 
     const auto start_index = StateToIndex(start_state, linear_resolution, angular_resolution);
     const auto start_key = IndexToKey(start_index);
 
-    const auto goal_index = StateToIndex(goal_state, linear_resolution, angular_resolution);
-    const auto goal_key = IndexToKey(goal_index);
+    std::vector<uint64_t> goal_keys;
+    std::vector<State2D> goal_states_2d;
+    for (const State3D& goal_state : goal_states)
+    {
+        goal_keys.push_back(IndexToKey(StateToIndex(goal_state, linear_resolution, angular_resolution)));
+        const Eigen::Array2i goal_cell = costmap.getCellIndex({goal_state.x, goal_state.y});
+        goal_states_2d.push_back({goal_cell.x(), goal_cell.y()});
+    }
 
-    const Eigen::Array2i goal_cell = costmap.getCellIndex({goal_state.x, goal_state.y});
-    const State2D goal_state_2d{goal_cell.x(), goal_cell.y()};
+    // the goal reached by the path of the result
+    std::size_t reached_goal = 0;
 
     const Eigen::Array2i start_cell = costmap.getCellIndex({start_state.x, start_state.y});
     const State2D start_state_2d{start_cell.x(), start_cell.y()};
 
-    auto start_node = new Node3D{start_state, nullptr, false, 0, 0};
-    start_node->cost_to_go = updateH(start_state_2d, goal_state_2d, result.explore_cache, collision_checker);
+    // a cache shared by the caller keeps the 2D search of earlier plans to the same goal
+    // a search grown lazily and a complete wavefront are not interchangeable
+    // the wavefront is rooted at a single goal, so several goals are always searched lazily
+    const bool wavefront = heuristic_mode == HeuristicMode::WAVEFRONT && !multiple_goals;
+    if (shared_cache && shared_cache->complete != wavefront)
+        shared_cache->reset(costmap.width, costmap.height);
 
-    result.explore_3d.insert(std::make_pair(start_key, start_node));
-
-    // start exploring from start state
-    handles[start_key] = open_set.push(start_node);
+    if (shared_cache)
+        updateExplore2DCache(*shared_cache, goal_states_2d.front(), collision_checker);
+    else
+        result.explore_cache->reset(costmap.width, costmap.height);
 
-    // x, y, rotation
-    const std::vector<ExploreDirection> directions = {
-        {linear_resolution, 0, 0},                    // forwards
-        {linear_resolution, 0, angular_resolution},   // forwards + rotate left
-        {linear_resolution, 0, -angular_resolution},  // forwards + rotate right
-    };
+    if (wavefront)
+        wavefront2D(goal_states_2d.front(), *result.explore_cache, collision_checker);
 
-    const std::vector<ExploreDirection> extra_directions = {
-        {linear_resolution, 0, 0},                    // forwards
-        {linear_resolution, 0, angular_resolution},   // forwards + rotate left
-        {linear_resolution, 0, -angular_resolution},  // forwards + rotate right
-        {-linear_resolution, 0, 0},                   // backwards
-        {0, linear_resolution, 0},                    // left
-        {0, -linear_resolution, 0},                   // right
-        {0, 0, angular_resolution},                   // rotate left
-        {0, 0, -angular_resolution}                   // rotate right
+    // ARA* orders the nodes by the heuristic inflated by weight
+    double weight = anytime ? anytime->initial_weight : 1.0;
+    auto weighted = [&weight](const double cost_to_go) {
+        return cost_to_go < std::numeric_limits<double>::max() ? weight * cost_to_go : cost_to_go;
     };
 
-    result.iterations = 0;
-    while (!open_set.empty() && result.iterations++ < max_iterations)
+    // the table costs moves on a traversal cost of 1, scale it down to stay below the cheapest cell of the map
+    double table_scale = 0;
+    if (heuristic_table)
     {
-        auto current_node = open_set.top();
-        open_set.pop();
-
-        ROS_ASSERT(!current_node->visited);
-        current_node->visited = true;
+        ROS_ASSERT_MSG(heuristic_table->matches(linear_resolution, angular_resolution, backwards_mult, strafe_mult,
+                                                rotation_mult),
+                       "Heuristic table was generated for a different motion model");
+        table_scale = std::min(1.0, std::max(0.0, costmap.min_traversal_cost));
+    }
 
-        const auto current_index = StateToIndex(current_node->state, linear_resolution, angular_resolution);
-        const auto current_key = IndexToKey(current_index);
+    // the 2D search already costs the cheapest goal, the table only stays admissible as the cheapest over the goals
+    auto heuristic = [&](const State3D& state, const State2D& state_2d) {
+        double cost_to_go = updateH(state_2d, goal_states_2d.data(), goal_states_2d.size(), *result.explore_cache,
+                                    collision_checker);
+        if (heuristic_table && cost_to_go < std::numeric_limits<double>::max())
+        {
+            double table_cost = std::numeric_limits<double>::max();
+            for (const State3D& goal_state : goal_states)
+                table_cost = std::min(table_cost, heuristic_table->costToGo(state, goal_state));
+            cost_to_go = std::max(cost_to_go, table_scale * table_cost);
+        }
+        return weighted(cost_to_go);
+    };
 
-        const double distance_to_goal_x = std::abs(current_node->state.x - goal_state.x);
-        const double distance_to_goal_y = std::abs(current_node->state.y - goal_state.y);
-        const double distance_to_goal_m =
-            std::sqrt(distance_to_goal_x * distance_to_goal_x + distance_to_goal_y * distance_to_goal_y);
-        const double rotation_to_goal = std::abs(wrapAngle(current_node->state.theta - goal_state.theta));
+    // a lower bound of heuristic() for the successors queued by lazy evaluation before their costs are known
+    // the 2D search costs at least the straight line to the nearest goal over cells of the cheapest traversal cost,
+    // the table only raises it
+    const double min_cell_cost = costmap.resolution * 1.1 * std::max(0.0, costmap.min_traversal_cost);
+    auto optimisticHeuristic = [&](const State3D& state) {
+        const Eigen::Array2i cell = costmap.getCellIndex({state.x, state.y});
+        const State2D state_2d{cell.x(), cell.y()};
+        double distance = std::numeric_limits<double>::max();
+        for (const State2D& goal_state_2d : goal_states_2d)
+            distance = std::min(distance, heuristic2d(state_2d, goal_state_2d));
+        return weighted(min_cell_cost * distance);
+    };
 
-        if (current_key == goal_key ||
-            (distance_to_goal_x <= linear_resolution * 2 && distance_to_goal_y <= linear_resolution * 2 &&
-             rotation_to_goal < angular_resolution * 2))
+    // the nearest goal for analytic expansions
+    auto nearestGoal = [&](const State3D& state) {
+        std::size_t nearest = 0;
+        double nearest_distance = std::numeric_limits<double>::max();
+        for (std::size_t i = 0; i < goal_states.size(); ++i)
         {
-            auto alloc = new Node3D{goal_state, current_node, false, current_node->cost_so_far, 0};
-            result.explore_3d.insert(std::make_pair(goal_key, alloc));
-            break;
+            const double distance = std::hypot(state.x - goal_states[i].x, state.y - goal_states[i].y);
+            if (distance < nearest_distance)
+            {
+                nearest = i;
+                nearest_distance = distance;
+            }
         }
+        return nearest;
+    };
 
-        const Eigen::Array2i map_cell = costmap.getCellIndex({current_node->state.x, current_node->state.y});
-        const double traversal_cost_first = traversalCost(map_cell.x(), map_cell.y(), costmap);
-        const double collision_cost_first = collisionCost(map_cell.x(), map_cell.y(), collision_checker);
+    auto start_node = result.explore_3d.emplace(start_key, Node3D{start_state, nullptr, false, 0, 0}).first;
+    start_node->cost_to_go = heuristic(start_state, start_state_2d);
 
-        const double distance_to_collision_px = collision_checker.clearance(current_node->state);
-        const double distance_to_collision_m = distance_to_collision_px * costmap.resolution;
+    // start exploring from start state
+    open_set.push(start_node);
 
-        const double d_to_collision_or_goal = std::min(distance_to_collision_m, distance_to_goal_m);
+    std::shared_ptr<const MotionPrimitives> primitives = options.motion_primitives;
+    if (primitives)
+    {
+        ROS_ASSERT(primitives->linearResolution() == linear_resolution);
+        ROS_ASSERT(primitives->angularResolution() == angular_resolution);
+        ROS_ASSERT(primitives->mapResolution() == costmap.resolution);
+    }
+    else
+    {
+        primitives = std::make_shared<MotionPrimitives>(linear_resolution, angular_resolution, costmap.resolution,
+                                                        collision_checker.offsets());
+    }
+    const ExpansionSettings settings{collision_checker, *primitives,    start_state,   goal_states,
+                                     linear_resolution, angular_resolution, backwards_mult, strafe_mult,
+                                     rotation_mult,     !anytime,           lazy_evaluation};
+
+    // with several threads the successors of the nodes at the top of the open set are evaluated together ahead of
+    // their expansion, the search itself stays serial so the result does not depend on the number of threads
+    // lazily evaluated expansions are cheap and not worth prefetching
+    const int threads = thread_pool ? thread_pool->threads() : 1;
+    const std::size_t prefetch_size =
+        threads > 1 && !lazy_evaluation ? static_cast<std::size_t>(4 * threads) : 1;
+    std::vector<const Node3D*> prefetched(prefetch_size, nullptr);
+    std::vector<Expansion> expansions(prefetch_size);
+    std::vector<HeadingPrimitives> scratch(prefetch_size);
+    std::vector<ClearanceBatch> batches(prefetch_size);
+
+    std::vector<State3D> shot_samples;
+    std::vector<double> shot_costs;
+
+    std::vector<const Node3D*> candidates;
+    std::vector<std::size_t> todo;
+    candidates.reserve(prefetch_size);
+    todo.reserve(prefetch_size);
+
+    // a prefetched expansion is only valid if the node has not moved to a better state since
+    auto findPrefetched = [&](const Node3D* node) {
+        std::size_t slot = 0;
+        while (slot < prefetch_size && !(prefetched[slot] == node && expansions[slot].state == node->state))
+            ++slot;
+        return slot;
+    };
+
+    // nodes closed by the current search, and closed nodes it improved which are queued again by the next search
+    std::vector<Node3D*> closed;
+    std::vector<Node3D*> incons;
+
+    // the searches after the first keep changing the nodes so the cheapest path so far is copied, goal first
+    std::vector<Node3D> best_path;
+    double best_cost = std::numeric_limits<double>::max();
 
-        // discretize
-        double res_mult = 1.0;
-        if (d_to_collision_or_goal < 0.2)
+    auto recordPath = [&](const State3D& state, const Node3D* parent, const double cost) {
+        best_cost = cost;
+        result.weight = weight;
+        best_path.assign(1, Node3D{state, nullptr, false, cost, 0});
+        for (const Node3D* node = parent; node; node = node->parent)
         {
-            res_mult = 1;
+            best_path.push_back(*node);
+            if (node == start_node)
+                break;
         }
-        else if (d_to_collision_or_goal < 0.4)
+    };
+
+    // starts the next ARA* search with a lower weight, returns false once the search with weight 1 ended or there is no
+    // time left
+    auto nextSearch = [&]() {
+        if (weight <= 1.0 || std::chrono::steady_clock::now() >= deadline)
+            return false;
+
+        for (Node3D* node : closed)
+            node->visited = false;
+        closed.clear();
+
+        for (Node3D* node : incons)
         {
-            res_mult = 2;
+            if (!open_set.contains(node))
+                open_set.push(node);
         }
-        else
+        incons.clear();
+
+        const double next_weight = std::max(1.0, weight - anytime->weight_step);
+        for (Node3D* node : open_set)
         {
-            res_mult = 4;
+            if (node->cost_to_go < std::numeric_limits<double>::max())
+                node->cost_to_go *= next_weight / weight;
         }
+        open_set.rebuild();
 
-        const double s1 = std::abs(costmap.resolution / std::cos(current_node->state.theta));
-        const double s2 = std::abs(costmap.resolution / std::sin(current_node->state.theta));
-        // I think this needs to be sqrt(2) = 1.4, use 1.5 to help rounding up
-        const double step_mult = 1.5 * res_mult * std::min(s1, s2) / costmap.resolution;
+        weight = next_weight;
+        ++result.searches;
+        return true;
+    };
 
-        ROS_ASSERT(step_mult >= 1.0);
+    result.searches = 1;
+    result.iterations = 0;
+    while (!open_set.empty() && result.iterations++ < max_iterations)
+    {
+        // the deadline ends the first search as well, which then returns without a path
+        if (anytime && result.iterations % 64 == 0 && std::chrono::steady_clock::now() >= deadline)
+        {
+            result.out_of_time = best_path.empty();
+            break;
+        }
 
-        const double distance_to_start_x = std::abs(current_node->state.x - start_state.x);
-        const double distance_to_start_y = std::abs(current_node->state.y - start_state.y);
-        const double distance_to_start =
-            std::sqrt(distance_to_start_x * distance_to_start_x + distance_to_start_y * distance_to_start_y);
+        // only the searches improving on the first path may use more than first_max_iterations
+        if (anytime && best_path.empty() && result.iterations > anytime->first_max_iterations)
+            break;
 
-        const double d_to_stuff = std::min(d_to_collision_or_goal, distance_to_start);
-        const std::vector<ExploreDirection>& current_directions = d_to_stuff > 0.5 ? directions : extra_directions;
+        auto current_node = open_set.top();
+        open_set.pop();
 
-        for (std::size_t i = 0; i < current_directions.size(); ++i)
+        // a lazily generated node is collision checked and costed once it reaches the top of the open set, and queued
+        // again unless it is still the cheapest
+        if (current_node->lazy)
         {
-            State3D new_state = current_node->state;
+            current_node->lazy = false;
+            ++result.collision_checks;
+
+            const State3D& state = current_node->state;
+            int theta_index;
+            const double clearance = primitives->onBin(state.theta, theta_index)
+                                         ? collision_checker.clearance(state, primitives->footprint(theta_index))
+                                         : collision_checker.clearance(state);
+            if (clearance <= 0.0)
+            {
+                // another parent may still reach the node in a valid state, the state itself is not queued again
+                current_node->cost_so_far = std::numeric_limits<double>::max();
+                current_node->cost_to_go = std::numeric_limits<double>::max();
+                current_node->in_collision = true;
+                continue;
+            }
 
-            if (std::abs(current_directions[i].rotation) > 0)
-                new_state.theta = wrapAngle(current_node->state.theta + current_directions[i].rotation);
+            const Eigen::Array2i cell = costmap.getCellIndex({state.x, state.y});
+            current_node->cost_so_far =
+                current_node->parent->cost_so_far + moveCost(settings, current_node->parent->state, state, clearance);
+            current_node->cost_to_go = heuristic(state, {cell.x(), cell.y()});
 
-            if (std::abs(current_directions[i].x) > 0 || std::abs(current_directions[i].y) > 0)
+            if (!open_set.empty() && CompareNodes()(current_node, open_set.top()))
             {
-                const double st = std::sin(new_state.theta);
-                const double ct = std::cos(new_state.theta);
-                const double dx = step_mult * (current_directions[i].x * ct - current_directions[i].y * st);
-                const double dy = step_mult * (current_directions[i].x * st + current_directions[i].y * ct);
-                new_state.x += dx;
-                new_state.y += dy;
+                open_set.push(current_node);
+                continue;
             }
+        }
 
-            const auto down_index = StateToIndex(new_state, linear_resolution * res_mult, angular_resolution);
-            new_state = IndexToState(down_index, linear_resolution * res_mult, angular_resolution);
-
-            auto new_index = StateToIndex(new_state, linear_resolution, angular_resolution);
-            const auto new_key = IndexToKey(new_index);
+        ROS_ASSERT(!current_node->visited);
+        current_node->visited = true;
+        if (anytime)
+            closed.push_back(current_node);
 
-            //            ROS_ASSERT(new_key != current_key);
-            if (new_key == current_key)
-                continue;
+        const auto current_index = StateToIndex(current_node->state, linear_resolution, angular_resolution);
+        const auto current_key = IndexToKey(current_index);
 
-            auto new_node = result.explore_3d.find(new_key);
+        std::size_t goal = 0;
+        for (; goal < goal_states.size(); ++goal)
+        {
+            const State3D& goal_state = goal_states[goal];
+            const double distance_to_goal_x = std::abs(current_node->state.x - goal_state.x);
+            const double distance_to_goal_y = std::abs(current_node->state.y - goal_state.y);
+            const double rotation_to_goal = std::abs(wrapAngle(current_node->state.theta - goal_state.theta));
+
+            if (current_key == goal_keys[goal] ||
+                (distance_to_goal_x <= linear_resolution * 2 && distance_to_goal_y <= linear_resolution * 2 &&
+                 rotation_to_goal < angular_resolution * 2))
+                break;
+        }
 
-            // Allocate if necessary
-            if (new_node == result.explore_3d.end())
-            {
-                auto alloc = new Node3D{new_state, current_node, false, std::numeric_limits<double>::max(),
-                                        std::numeric_limits<double>::max()};
-                new_node = result.explore_3d.insert(std::make_pair(new_key, alloc)).first;
-            }
-            else if (new_node->second->visited)
+        if (goal < goal_states.size())
+        {
+            const State3D& goal_state = goal_states[goal];
+            const auto goal_key = goal_keys[goal];
+            if (!anytime)
             {
-                continue;
+                reached_goal = goal;
+                result.explore_3d.emplace(goal_key,
+                                          Node3D{goal_state, current_node, false, current_node->cost_so_far, 0});
+                break;
             }
 
-            if (!collision_checker.isWithinBounds(new_state))
+            if (current_node->cost_so_far < best_cost)
             {
-                continue;
+                reached_goal = goal;
+                recordPath(goal_state, current_key == goal_key ? current_node->parent : current_node,
+                           current_node->cost_so_far);
             }
 
-            if (!collision_checker.isValid(new_state))
+            // the node is left for the next search to expand
+            current_node->visited = false;
+            open_set.push(current_node);
+            if (!nextSearch())
+                break;
+            continue;
+        }
+
+        // try to reach the goal directly, which saves expanding the last stretch cell by cell
+        if (analytic_expansion.interval > 0 && (result.iterations % analytic_expansion.interval == 0 ||
+                                                current_node->cost_to_go < analytic_expansion.heuristic_threshold))
+        {
+            ++result.analytic_expansions;
+            // only take moves which keep the path cost close to what the search expects through this node
+            const std::size_t goal = nearestGoal(current_node->state);
+            const State3D& goal_state = goal_states[goal];
+            if (analyticExpansion(settings, current_node->state, goal_state, shot_samples, shot_costs))
             {
-                continue;
-            }
+                const double shot_cost =
+                    current_node->cost_so_far + std::accumulate(shot_costs.begin(), shot_costs.end(), 0.0);
+                if (shot_cost <= analytic_expansion.cost_tolerance * current_node->cost() && shot_cost < best_cost)
+                {
+                    Node3D* parent = current_node;
+                    double cost_so_far = current_node->cost_so_far;
+                    for (std::size_t i = 0; i + 1 < shot_samples.size(); ++i)
+                    {
+                        cost_so_far += shot_costs[i];
+                        parent =
+                            result.analytic_nodes.allocate(Node3D{shot_samples[i], parent, false, cost_so_far, 0});
+                    }
 
-            const double trans_x = (new_state.x - current_node->state.x);
-            const double trans_y = (new_state.y - current_node->state.y);
+                    result.analytic_success = true;
+                    reached_goal = goal;
+                    if (!anytime)
+                    {
+                        Node3D* goal_node =
+                            result.explore_3d.emplace(goal_keys[goal], Node3D{goal_state, parent, false, 0, 0}).first;
+                        goal_node->state = goal_state;
+                        goal_node->parent = parent;
+                        goal_node->cost_so_far = cost_so_far + shot_costs.back();
+                        goal_node->cost_to_go = 0;
+                        break;
+                    }
 
-            const double st = std::sin(new_state.theta);
-            const double ct = std::cos(new_state.theta);
-            // inverse rotation matrix
-            const double dx = (trans_x * ct + trans_y * st);
-            const double dy = (-trans_x * st + trans_y * ct);
+                    recordPath(goal_state, parent, cost_so_far + shot_costs.back());
 
-            const double trans_w = wrapAngle(new_state.theta - current_node->state.theta);
+                    current_node->visited = false;
+                    open_set.push(current_node);
+                    if (!nextSearch())
+                        break;
+                    continue;
+                }
+            }
+        }
 
-            const double x_cost = std::abs((dx > 0) ? dx : backwards_mult * dx);
-            const double y_cost = std::abs(strafe_mult * dy);
+        std::size_t slot = findPrefetched(current_node);
+        if (slot == prefetch_size)
+        {
+            slot = 0;
+            expand(settings, current_node->state, result.explore_3d, expansions[0], scratch[0], batches[0]);
+        }
 
-            const Eigen::Array2i new_map_cell = costmap.getCellIndex({new_state.x, new_state.y});
-            const double collision_cost_second = collisionCost(new_map_cell.x(), new_map_cell.y(), collision_checker);
-            const double traversal_cost_second = traversalCost(new_map_cell.x(), new_map_cell.y(), costmap);
+        prefetched[slot] = nullptr;
+        const Expansion& expansion = expansions[slot];
+        result.collision_checks += expansion.checks;
 
-            const double collision_cost = (collision_cost_first + collision_cost_second) / 2.0;
-            const double traversal_cost = (traversal_cost_first + traversal_cost_second) / 2.0;
+        for (std::size_t i = 0; i < expansion.size; ++i)
+        {
+            const State3D& new_state = expansion.states[i];
 
-            const double new_state_d_to_collision_m = collision_checker.clearance(new_state) * costmap.resolution;
-            const double rotation_collision_cost = rotationCollisionCost(new_state_d_to_collision_m);
+            // Allocate if necessary
+            const auto emplaced = result.explore_3d.emplace(
+                expansion.keys[i], Node3D{new_state, current_node, false, std::numeric_limits<double>::max(),
+                                          std::numeric_limits<double>::max()});
+            Node3D* new_node = emplaced.first;
+            if (!emplaced.second && new_node->visited && !anytime)
+            {
+                continue;
+            }
 
-            const double rotation_cost = std::abs(trans_w) * rotation_mult * rotation_collision_cost;
-            const double translation_cost = (x_cost + y_cost) * collision_cost * traversal_cost;
+            if (!expansion.valid[i])
+            {
+                continue;
+            }
 
-            const double cost = translation_cost + rotation_cost;
-            const double cost_so_far = current_node->cost_so_far + cost;
+            const double cost_so_far = current_node->cost_so_far + expansion.costs[i];
 
-            if (cost_so_far < new_node->second->cost_so_far)
+            if (lazy_evaluation)
+            {
+                // the successors which are passed over, or replaced before they reach the top of the open set, are
+                // never checked
+                if ((new_node->in_collision && new_node->state == new_state) || cost_so_far >= new_node->cost_so_far)
+                {
+                    ++result.collision_checks_saved;
+                    continue;
+                }
+
+                if (new_node->lazy)
+                    ++result.collision_checks_saved;
+
+                // queued with a lower bound of its key, the real one is computed once it reaches the top
+                new_node->state = new_state;
+                new_node->cost_so_far = cost_so_far;
+                new_node->cost_to_go = optimisticHeuristic(new_state);
+                new_node->parent = current_node;
+                new_node->lazy = true;
+                new_node->in_collision = false;
+
+                if (new_node->visited)
+                    incons.push_back(new_node);
+                else if (open_set.contains(new_node))
+                    open_set.update(new_node);
+                else
+                    open_set.push(new_node);
+                continue;
+            }
+
+            if (cost_so_far < new_node->cost_so_far)
             {
                 // Calculate start and end map coordinates
                 const Eigen::Array2i cell =
-                    costmap.getCellIndex({new_node->second->state.x, new_node->second->state.y});
+                    costmap.getCellIndex({new_node->state.x, new_node->state.y});
                 const State2D state_2d{cell.x(), cell.y()};
 
-                const double old_cost = new_node->second->cost();
-                const double cost_to_go = updateH(state_2d, goal_state_2d, result.explore_cache, collision_checker);
+                const double old_cost = new_node->cost();
+                const double cost_to_go = heuristic(new_state, state_2d);
 
                 if (cost_to_go + cost_so_far < old_cost)
                 {
-                    new_node->second->state = new_state;
-                    new_node->second->cost_so_far = cost_so_far;
-                    new_node->second->cost_to_go = cost_to_go;
-                    new_node->second->parent = current_node;
+                    new_node->state = new_state;
+                    new_node->cost_so_far = cost_so_far;
+                    new_node->cost_to_go = cost_to_go;
+                    new_node->parent = current_node;
 
-                    ROS_ASSERT(std::isfinite(new_node->second->cost_to_go));
+                    ROS_ASSERT(std::isfinite(new_node->cost_to_go));
 
-                    auto it = handles.find(new_key);
-                    if (it != handles.end())
+                    if (new_node->visited)
+                    {
+                        incons.push_back(new_node);
+                    }
+                    else if (open_set.contains(new_node))
                     {
-                        ROS_ASSERT(it->second.node_->value == new_node->second);
-                        open_set.decrease(it->second);
+                        open_set.decrease(new_node);
                     }
                     else
                     {
-                        handles[new_key] = open_set.push(new_node->second);
+                        open_set.push(new_node);
                     }
                 }
             }
 
-            ROS_ASSERT(new_node->second->parent != new_node->second);
+            ROS_ASSERT(new_node->parent != new_node);
+        }
+
+        // the next expansions are most likely among the first levels of the heap, evaluate them together
+        // the heap array is not sorted by cost, only its first slot is known to be the cheapest open node
+        if (prefetch_size > 1 && !open_set.empty() && findPrefetched(open_set.top()) == prefetch_size)
+        {
+            candidates.clear();
+            for (std::size_t i = 0; i < open_set.size() && candidates.size() < prefetch_size; ++i)
+                candidates.push_back(open_set.at(i));
+
+            // keep the expansions of candidates which are still valid
+            for (std::size_t i = 0; i < prefetch_size; ++i)
+            {
+                if (!prefetched[i])
+                    continue;
+                if (std::find(candidates.begin(), candidates.end(), prefetched[i]) == candidates.end() ||
+                    !(expansions[i].state == prefetched[i]->state))
+                    prefetched[i] = nullptr;
+            }
+
+            todo.clear();
+            std::size_t free_slot = 0;
+            for (const Node3D* candidate : candidates)
+            {
+                if (findPrefetched(candidate) != prefetch_size)
+                    continue;
+                while (prefetched[free_slot])
+                    ++free_slot;
+                prefetched[free_slot] = candidate;
+                todo.push_back(free_slot);
+            }
+
+            auto expandTodo = [&](const int i) {
+                const std::size_t slot = todo[static_cast<std::size_t>(i)];
+                expand(settings, prefetched[slot]->state, result.explore_3d, expansions[slot], scratch[slot],
+                       batches[slot]);
+            };
+
+            // waking the threads costs more than a few expansions
+            if (todo.size() >= MIN_PARALLEL_EXPANSIONS_PER_THREAD * static_cast<std::size_t>(threads))
+                thread_pool->parallelFor(static_cast<int>(todo.size()), expandTodo);
+            else
+                for (std::size_t i = 0; i < todo.size(); ++i)
+                    expandTodo(static_cast<int>(i));
         }
     }
 
-    auto goal_node = result.explore_3d.find(goal_key);
-    if (goal_node != result.explore_3d.end())
+    // the successors still queued at the end were never checked either
+    if (lazy_evaluation)
+    {
+        for (const auto& node : result.explore_3d)
+        {
+            if (node.second->lazy)
+                ++result.collision_checks_saved;
+        }
+    }
+
+    result.goal = goals[goal_sources[reached_goal]];
+
+    if (anytime)
+    {
+        if (!best_path.empty())
+        {
+            result.success = true;
+            result.path.resize(best_path.size());
+            Node3D* parent = nullptr;
+            for (std::size_t i = best_path.size(); i-- > 0;)
+            {
+                Node3D node = best_path[i];
+                node.parent = parent;
+                node.heap_index = HEAP_NPOS;
+                parent = result.path_nodes.allocate(node);
+                result.path[i] = parent;
+            }
+        }
+        return result;
+    }
+
+    auto goal_node = result.explore_3d.find(goal_keys[reached_goal]);
+    if (goal_node)
     {
         result.success = true;
-        auto node = goal_node->second;
-        uint64_t node_key = 0;
+        // the samples of an analytic expansion are off the lattice, so stop at the start node itself
+        auto node = goal_node;
         do
         {
-            const auto node_index = StateToIndex(node->state, linear_resolution, angular_resolution);
-            node_key = IndexToKey(node_index);
             result.path.push_back(node);
             node = node->parent;
-        } while (node && node_key != start_key);
+        } while (node && result.path.back() != start_node);
     }
 
     return result;
 }
+
+}  // namespace
+
+PathResult hybridAStar(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal, const size_t max_iterations,
+                       const CollisionChecker& collision_checker, const double linear_resolution,
+                       const double angular_resolution,
+                       const navigation_interface::PathPlanner::GoalSampleSettings& goal_sample_settings,
+                       const double backwards_mult, const double strafe_mult, const double rotation_mult)
+{
+    return search(start, {goal}, max_iterations, collision_checker, linear_resolution, angular_resolution,
+                  goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, SearchOptions(), nullptr,
+                  std::chrono::steady_clock::time_point::max());
+}
+
+PathResult hybridAStar(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                       const size_t max_iterations, const CollisionChecker& collision_checker,
+                       const double linear_resolution, const double angular_resolution,
+                       const navigation_interface::PathPlanner::GoalSampleSettings& goal_sample_settings,
+                       const double backwards_mult, const double strafe_mult, const double rotation_mult,
+                       const SearchOptions& options)
+{
+    return search(start, goals, max_iterations, collision_checker, linear_resolution, angular_resolution,
+                  goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options, nullptr,
+                  std::chrono::steady_clock::time_point::max());
+}
+
+PathResult anytimeHybridAStar(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                              const std::chrono::steady_clock::time_point& deadline, const AnytimeSettings& anytime,
+                              const size_t max_iterations, const CollisionChecker& collision_checker,
+                              const double linear_resolution, const double angular_resolution,
+                              const navigation_interface::PathPlanner::GoalSampleSettings& goal_sample_settings,
+                              const double backwards_mult, const double strafe_mult, const double rotation_mult,
+                              const SearchOptions& options)
+{
+    ROS_ASSERT_MSG(anytime.initial_weight >= 1.0, "initial_weight must be at least 1: %f", anytime.initial_weight);
+    ROS_ASSERT_MSG(anytime.weight_step > 0.0, "weight_step must be positive: %f", anytime.weight_step);
+    return search(start, goals, max_iterations, collision_checker, linear_resolution, angular_resolution,
+                  goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options, &anytime, deadline);
+}
+
+bool searchedWithin(const PathResult& result, const Costmap& costmap, const cv::Rect& region)
+{
+    const cv::Rect bounds(0, 0, costmap.width, costmap.height);
+    auto within = [&](const State3D& state) {
+        const Eigen::Array2i cell = costmap.getCellIndex({state.x, state.y});
+        const cv::Point point(cell.x(), cell.y());
+        return !bounds.contains(point) || region.contains(point);
+    };
+
+    for (const auto& node : result.explore_3d)
+    {
+        if (node.second->cost_so_far < std::numeric_limits<double>::max() && !within(node.second->state))
+            return false;
+    }
+    for (const Node3D* node : result.path)
+    {
+        if (!within(node->state))
+            return false;
+    }
+
+    // the heuristic of a cell reached beyond the region could be lower on a larger costmap
+    const Explore2DCache* explore_cache = result.explore_cache.get();
+    if (!explore_cache || explore_cache->width() != costmap.width || explore_cache->height() != costmap.height)
+        return true;
+
+    auto reachedOutside = [&](const std::size_t index) {
+        const Node2D* node = explore_cache->find(index);
+        const cv::Point point(static_cast<int>(index % static_cast<std::size_t>(costmap.width)),
+                              static_cast<int>(index / static_cast<std::size_t>(costmap.width)));
+        return node && node->cost_so_far < std::numeric_limits<double>::max() && !region.contains(point);
+    };
+
+    // a lazy search remembers the cells it reached, a complete one has a node for every cell
+    if (explore_cache->complete)
+    {
+        for (std::size_t i = 0; i < explore_cache->size(); ++i)
+            if (reachedOutside(i))
+                return false;
+    }
+    else
+    {
+        for (const std::size_t i : explore_cache->searched_cells)
+            if (reachedOutside(i))
+                return false;
+    }
+    return true;
+}
 }  // namespace astar_planner
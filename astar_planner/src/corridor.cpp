@@ -0,0 +1,236 @@
+#include <astar_planner/astar.h>
+#include <astar_planner/corridor.h>
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace astar_planner
+{
+
+namespace
+{
+
+bool findPath(const OccupancyPyramid& pyramid, const int level, const State2D& start, const State2D& goal,
+              std::vector<State2D>& path, std::size_t& iterations)
+{
+    const cv::Mat& blocked = pyramid.blocked(level);
+    const cv::Mat& cell_cost = pyramid.cellCost(level);
+    const int width = blocked.cols;
+    const int height = blocked.rows;
+
+    auto isBlocked = [&](const State2D& state) {
+        // the robot is already at the start and the goal was checked by the caller, pooling may still block their cells
+        return blocked.at<uint8_t>(state.y, state.x) != 0 && !(state == start) && !(state == goal);
+    };
+
+    // the cheapest cell scales the heuristic so it stays admissible
+    float min_cost = std::numeric_limits<float>::max();
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* b = blocked.ptr<uint8_t>(y);
+        const float* cost = cell_cost.ptr<float>(y);
+        for (int x = 0; x < width; ++x)
+        {
+            if (!b[x])
+                min_cost = std::min(min_cost, cost[x]);
+        }
+    }
+
+    auto heuristic = [&](const State2D& state) {
+        const double dx = goal.x - state.x;
+        const double dy = goal.y - state.y;
+        return std::sqrt(dx * dx + dy * dy) * min_cost;
+    };
+
+    std::vector<Node2D> nodes(static_cast<std::size_t>(width * height));
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+            nodes[static_cast<std::size_t>(y * width + x)] =
+                Node2D{{x, y}, nullptr, std::numeric_limits<double>::max(), 0};
+    }
+
+    PriorityQueue2D open_set;
+    Node2D* start_node = &nodes[static_cast<std::size_t>(start.y * width + start.x)];
+    start_node->cost_so_far = 0;
+    start_node->cost_to_go = heuristic(start);
+    open_set.push(start_node);
+
+    while (!open_set.empty())
+    {
+        Node2D* current = open_set.top();
+        open_set.pop();
+        ++iterations;
+
+        if (current->state == goal)
+        {
+            path.clear();
+            for (const Node2D* node = current; node; node = node->parent)
+                path.push_back(node->state);
+            std::reverse(path.begin(), path.end());
+            return true;
+        }
+
+        // 8-connected, diagonals may not cut between two blocked cells
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            const State2D next = current->state + directions_2d[i];
+            if (next.x < 0 || next.x >= width || next.y < 0 || next.y >= height || isBlocked(next))
+                continue;
+
+            if (directions_2d[i].x != 0 && directions_2d[i].y != 0 &&
+                isBlocked({current->state.x + directions_2d[i].x, current->state.y}) &&
+                isBlocked({current->state.x, current->state.y + directions_2d[i].y}))
+                continue;
+
+            Node2D* next_node = &nodes[static_cast<std::size_t>(next.y * width + next.x)];
+            const double cost_so_far =
+                current->cost_so_far + directions_2d_cost[i] * cell_cost.at<float>(next.y, next.x);
+            if (cost_so_far < next_node->cost_so_far)
+            {
+                next_node->cost_so_far = cost_so_far;
+                next_node->cost_to_go = heuristic(next);
+                next_node->parent = current;
+                if (open_set.contains(next_node))
+                    open_set.decrease(next_node);
+                else
+                    open_set.push(next_node);
+            }
+        }
+    }
+
+    return false;
+}
+
+}  // namespace
+
+OccupancyPyramid::OccupancyPyramid(const CollisionChecker& collision_checker, const int levels)
+{
+    ROS_ASSERT(levels >= 1);
+
+    const Costmap& costmap = collision_checker.costmap();
+
+    std::vector<float> cell_costs;
+    cellCosts2D(collision_checker, cell_costs);
+
+    cv::Mat blocked(costmap.height, costmap.width, CV_8U);
+    cv::Mat cell_cost(costmap.height, costmap.width, CV_32F);
+    for (int y = 0; y < costmap.height; ++y)
+    {
+        const float* cost = &cell_costs[static_cast<std::size_t>(y) * static_cast<std::size_t>(costmap.width)];
+        uint8_t* b = blocked.ptr<uint8_t>(y);
+        float* c = cell_cost.ptr<float>(y);
+        for (int x = 0; x < costmap.width; ++x)
+        {
+            b[x] = std::isfinite(cost[x]) ? 0 : 255;
+            c[x] = std::isfinite(cost[x]) ? cost[x] : 0.f;
+        }
+    }
+
+    blocked_.push_back(blocked);
+    cell_cost_.push_back(cell_cost);
+
+    for (int level = 1; level < levels; ++level)
+    {
+        const cv::Mat& fine_blocked = blocked_.back();
+        const cv::Mat& fine_cost = cell_cost_.back();
+        const int width = (fine_blocked.cols + 1) / 2;
+        const int height = (fine_blocked.rows + 1) / 2;
+
+        cv::Mat coarse_blocked(height, width, CV_8U);
+        cv::Mat coarse_cost(height, width, CV_32F);
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                uint8_t max_blocked = 0;
+                float sum_cost = 0;
+                int count = 0;
+                for (int fy = 2 * y; fy < std::min(2 * y + 2, fine_blocked.rows); ++fy)
+                {
+                    for (int fx = 2 * x; fx < std::min(2 * x + 2, fine_blocked.cols); ++fx)
+                    {
+                        const uint8_t b = fine_blocked.at<uint8_t>(fy, fx);
+                        max_blocked = std::max(max_blocked, b);
+                        if (!b)
+                        {
+                            sum_cost += fine_cost.at<float>(fy, fx);
+                            ++count;
+                        }
+                    }
+                }
+                coarse_blocked.at<uint8_t>(y, x) = max_blocked;
+                coarse_cost.at<float>(y, x) = count > 0 ? sum_cost / count : 0.f;
+            }
+        }
+
+        blocked_.push_back(coarse_blocked);
+        cell_cost_.push_back(coarse_cost);
+    }
+}
+
+Corridor findCorridor(const OccupancyPyramid& pyramid, const State2D& start, const State2D& goal, const int level,
+                      const int margin_px)
+{
+    ROS_ASSERT(margin_px >= 0);
+
+    const cv::Mat& map = pyramid.blocked(0);
+    ROS_ASSERT(start.x >= 0 && start.x < map.cols && start.y >= 0 && start.y < map.rows);
+    ROS_ASSERT(goal.x >= 0 && goal.x < map.cols && goal.y >= 0 && goal.y < map.rows);
+
+    Corridor corridor{false, 0, {}, cv::Mat(), 0};
+    for (int l = std::min(level, pyramid.levels() - 1); l >= 1; --l)
+    {
+        if (findPath(pyramid, l, {start.x >> l, start.y >> l}, {goal.x >> l, goal.y >> l}, corridor.path,
+                     corridor.iterations))
+        {
+            corridor.success = true;
+            corridor.level = l;
+            break;
+        }
+    }
+
+    if (!corridor.success)
+        return corridor;
+
+    corridor.mask = cv::Mat(map.rows, map.cols, CV_8U, cv::Scalar(0));
+    const int size = 1 << corridor.level;
+    for (const State2D& cell : corridor.path)
+    {
+        const cv::Point top_left((cell.x << corridor.level) - margin_px, (cell.y << corridor.level) - margin_px);
+        const cv::Point bottom_right(top_left.x + size - 1 + 2 * margin_px, top_left.y + size - 1 + 2 * margin_px);
+        cv::rectangle(corridor.mask, top_left, bottom_right, cv::Scalar(255), -1);
+    }
+
+    return corridor;
+}
+
+Costmap restrictToCorridor(const Costmap& costmap, const cv::Mat& mask)
+{
+    ROS_ASSERT(mask.type() == CV_8U);
+    ROS_ASSERT(mask.rows == costmap.height && mask.cols == costmap.width);
+
+    // shares everything but the distances with costmap
+    Costmap restricted = costmap;
+    restricted.distance_to_collision = costmap.distance_to_collision.clone();
+    for (int y = 0; y < costmap.height; ++y)
+    {
+        const uint8_t* m = mask.ptr<uint8_t>(y);
+        float* distance = restricted.distance_to_collision.ptr<float>(y);
+        for (int x = 0; x < costmap.width; ++x)
+        {
+            if (!m[x])
+                distance[x] = 0.f;
+        }
+    }
+
+    if (!restricted.cells.empty())
+        restricted.buildCells();
+
+    return restricted;
+}
+
+}  // namespace astar_planner
@@ -1,6 +1,592 @@
 #include <astar_planner/costmap.h>
+#include <astar_planner/parallel.h>
+#include <gridmap/operations/rasterize.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ASTAR_PLANNER_AVX2
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
 
 namespace astar_planner
 {
 
+namespace
+{
+
+cv::Mat inflationKernel(const double inflation_radius, const double resolution)
+{
+    const int cell_inflation_radius = static_cast<int>(2.0 * inflation_radius / resolution);
+    return cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(cell_inflation_radius, cell_inflation_radius));
+}
+
+cv::Rect expand(const cv::Rect& rect, const int margin)
+{
+    return cv::Rect(rect.x - margin, rect.y - margin, rect.width + 2 * margin, rect.height + 2 * margin);
+}
+
+// Footprint offsets and the distance field as seen by the batched clearance
+struct ClearanceInputs
+{
+    const double* offsets_x;
+    const double* offsets_y;
+    std::size_t num_offsets;
+
+    const float* distance_to_collision;
+    int cols;
+    int rows;
+    int stride;
+
+    double origin_x;
+    double origin_y;
+    double resolution;
+};
+
+void clearanceScalar(const ClearanceInputs& in, ClearanceBatch& batch, const std::size_t begin)
+{
+    for (std::size_t i = begin; i < batch.size(); ++i)
+    {
+        const double st = batch.sin_theta[i];
+        const double ct = batch.cos_theta[i];
+
+        double min_distance = std::numeric_limits<double>::max();
+        for (std::size_t j = 0; j < in.num_offsets; ++j)
+        {
+            const double offset_x = batch.x[i] + (in.offsets_x[j] * ct - in.offsets_y[j] * st);
+            const double offset_y = batch.y[i] + (in.offsets_x[j] * st + in.offsets_y[j] * ct);
+
+            const int cell_x = static_cast<int>(std::round((offset_x - in.origin_x) / in.resolution));
+            const int cell_y = static_cast<int>(std::round((offset_y - in.origin_y) / in.resolution));
+
+            double d = 0;
+            if (cell_x >= 0 && cell_x < in.cols && cell_y >= 0 && cell_y < in.rows)
+            {
+                d = static_cast<double>(in.distance_to_collision[cell_y * in.stride + cell_x]);
+            }
+            min_distance = std::min(min_distance, d);
+        }
+        batch.clearance[i] = min_distance;
+    }
+}
+
+#ifdef ASTAR_PLANNER_AVX2
+
+// std::round rounds halfway cases away from zero, which none of the rounding modes of _mm256_round_pd do
+__attribute__((target("avx2"))) inline __m256d roundAwayFromZero(const __m256d v)
+{
+    const __m256d sign_mask = _mm256_set1_pd(-0.0);
+    const __m256d truncated = _mm256_round_pd(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m256d fraction = _mm256_andnot_pd(sign_mask, _mm256_sub_pd(v, truncated));
+    const __m256d step = _mm256_or_pd(_mm256_and_pd(v, sign_mask), _mm256_set1_pd(1.0));
+    const __m256d round_up = _mm256_cmp_pd(fraction, _mm256_set1_pd(0.5), _CMP_GE_OQ);
+    return _mm256_add_pd(truncated, _mm256_and_pd(round_up, step));
+}
+
+// Four states at a time, the arithmetic matches clearanceScalar operation for operation so the results are identical
+// Returns the index of the first state left for the scalar path
+__attribute__((target("avx2"))) std::size_t clearanceAVX2(const ClearanceInputs& in, ClearanceBatch& batch)
+{
+    const __m256d origin_x = _mm256_set1_pd(in.origin_x);
+    const __m256d origin_y = _mm256_set1_pd(in.origin_y);
+    const __m256d resolution = _mm256_set1_pd(in.resolution);
+    const __m128i cols = _mm_set1_epi32(in.cols);
+    const __m128i rows = _mm_set1_epi32(in.rows);
+    const __m128i stride = _mm_set1_epi32(in.stride);
+    const __m128i minus_one = _mm_set1_epi32(-1);
+
+    std::size_t i = 0;
+    for (; i + 4 <= batch.size(); i += 4)
+    {
+        const __m256d x = _mm256_loadu_pd(&batch.x[i]);
+        const __m256d y = _mm256_loadu_pd(&batch.y[i]);
+        const __m256d st = _mm256_loadu_pd(&batch.sin_theta[i]);
+        const __m256d ct = _mm256_loadu_pd(&batch.cos_theta[i]);
+
+        __m256d min_distance = _mm256_set1_pd(std::numeric_limits<double>::max());
+        for (std::size_t j = 0; j < in.num_offsets; ++j)
+        {
+            const __m256d ox = _mm256_set1_pd(in.offsets_x[j]);
+            const __m256d oy = _mm256_set1_pd(in.offsets_y[j]);
+
+            const __m256d offset_x = _mm256_add_pd(x, _mm256_sub_pd(_mm256_mul_pd(ox, ct), _mm256_mul_pd(oy, st)));
+            const __m256d offset_y = _mm256_add_pd(y, _mm256_add_pd(_mm256_mul_pd(ox, st), _mm256_mul_pd(oy, ct)));
+
+            const __m128i cell_x = _mm256_cvttpd_epi32(
+                roundAwayFromZero(_mm256_div_pd(_mm256_sub_pd(offset_x, origin_x), resolution)));
+            const __m128i cell_y = _mm256_cvttpd_epi32(
+                roundAwayFromZero(_mm256_div_pd(_mm256_sub_pd(offset_y, origin_y), resolution)));
+
+            const __m128i inside =
+                _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(cell_x, minus_one), _mm_cmpgt_epi32(cols, cell_x)),
+                              _mm_and_si128(_mm_cmpgt_epi32(cell_y, minus_one), _mm_cmpgt_epi32(rows, cell_y)));
+
+            // cells outside the map are not loaded and count as in collision
+            const __m128i index = _mm_add_epi32(_mm_mullo_epi32(cell_y, stride), cell_x);
+            const __m128 d = _mm_mask_i32gather_ps(_mm_setzero_ps(), in.distance_to_collision, index,
+                                                   _mm_castsi128_ps(inside), 4);
+
+            min_distance = _mm256_min_pd(_mm256_cvtps_pd(d), min_distance);
+        }
+        _mm256_storeu_pd(&batch.clearance[i], min_distance);
+    }
+    return i;
+}
+
+bool hasAVX2()
+{
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+
+#endif
+}  // namespace
+
+void Costmap::processObstacleMap()
+{
+    cv::Mat dilated;
+    {
+        // dilate robot radius
+        cv::dilate(obstacle_map, dilated, inflationKernel(inflation_radius, resolution));
+    }
+
+    // flip
+    cv::bitwise_not(dilated, dilated);
+
+    // allocate
+    distance_to_collision = cv::Mat(dilated.size(), CV_32F);
+
+    // find obstacle distances
+    cv::distanceTransform(dilated, distance_to_collision, cv::DIST_L2, cv::DIST_MASK_PRECISE, CV_32F);
+    cv::threshold(distance_to_collision, distance_to_collision, max_distance, max_distance, cv::THRESH_TRUNC);
+
+    if (!cells.empty())
+        buildCells();
+}
+
+std::vector<cv::Rect> Costmap::processObstacleMap(const std::vector<cv::Rect>& regions)
+{
+    ROS_ASSERT(distance_to_collision.rows == height && distance_to_collision.cols == width);
+
+    const cv::Mat kernel = inflationKernel(inflation_radius, resolution);
+    const int kernel_reach = std::max(kernel.rows, kernel.cols) / 2 + 1;
+    const int distance_reach = static_cast<int>(std::ceil(max_distance)) + 1;
+
+    // a changed obstacle moves the dilation within kernel_reach and the distances within distance_reach of that
+    const cv::Rect bounds(0, 0, width, height);
+    std::vector<cv::Rect> affected;
+    for (const cv::Rect& region : regions)
+    {
+        if ((region & bounds).area() > 0)
+            affected.push_back(expand(region, kernel_reach + distance_reach) & bounds);
+    }
+
+    // merge overlapping regions so no cell is computed twice
+    for (bool merged = true; merged;)
+    {
+        merged = false;
+        for (std::size_t i = 0; i < affected.size() && !merged; ++i)
+        {
+            for (std::size_t j = i + 1; j < affected.size() && !merged; ++j)
+            {
+                if ((affected[i] & affected[j]).area() > 0)
+                {
+                    affected[i] = affected[i] | affected[j];
+                    affected.erase(affected.begin() + static_cast<std::ptrdiff_t>(j));
+                    merged = true;
+                }
+            }
+        }
+    }
+
+    for (const cv::Rect& region : affected)
+    {
+        // cells within distance_reach of the region can hold the closest obstacle, and their dilation depends on the
+        // obstacles within kernel_reach of them
+        const cv::Rect distance_region = expand(region, distance_reach) & bounds;
+        const cv::Rect obstacle_region = expand(distance_region, kernel_reach) & bounds;
+
+        cv::Mat dilated;
+        cv::dilate(obstacle_map(obstacle_region), dilated, kernel);
+
+        cv::Mat free = dilated(cv::Rect(distance_region.x - obstacle_region.x, distance_region.y - obstacle_region.y,
+                                        distance_region.width, distance_region.height));
+        cv::bitwise_not(free, free);
+
+        cv::Mat distance;
+        cv::distanceTransform(free, distance, cv::DIST_L2, cv::DIST_MASK_PRECISE, CV_32F);
+        cv::threshold(distance, distance, max_distance, max_distance, cv::THRESH_TRUNC);
+
+        distance(cv::Rect(region.x - distance_region.x, region.y - distance_region.y, region.width, region.height))
+            .copyTo(distance_to_collision(region));
+
+        if (!cells.empty())
+            updateCells(region);
+    }
+
+    return affected;
+}
+
+void Costmap::buildCells()
+{
+    ROS_ASSERT(traversal_cost);
+    ROS_ASSERT(traversal_cost->rows == height && traversal_cost->cols == width);
+
+    // CV_32FC2 so that the mat is shared between copies of the costmap like the others
+    const int tiles_x = (width + 7) >> 3;
+    const int tiles_y = (height + 7) >> 3;
+    cells = cv::Mat(tiles_x * tiles_y, 64, CV_32FC2, cv::Scalar(0, 0));
+    updateCells(cv::Rect(0, 0, width, height));
+}
+
+void Costmap::updateCells(const cv::Rect& region)
+{
+    ROS_ASSERT(!cells.empty());
+
+    const cv::Rect roi = region & cv::Rect(0, 0, width, height);
+    for (int y = roi.y; y < roi.y + roi.height; ++y)
+    {
+        const float* distance = distance_to_collision.ptr<float>(y);
+        const float* traversal = traversal_cost->ptr<float>(y);
+        for (int x = roi.x; x < roi.x + roi.width; ++x)
+        {
+            const cv::Point index = cellsIndex(x, y);
+            cells.ptr<CostmapCell>(index.y)[index.x] = {distance[x], traversal[x]};
+        }
+    }
+}
+
+cv::Rect Costmap::clearFootprint(const Eigen::Isometry2d& pose, const std::vector<Eigen::Vector2d>& offsets)
+{
+    const int radius_px = static_cast<int>(inflation_radius / resolution);
+    cv::Rect region;
+    for (const auto& offset : offsets)
+    {
+        const Eigen::Vector2d p = pose * offset;
+        const Eigen::Array2i map_cell = getCellIndex({p.x(), p.y()});
+        cv::circle(obstacle_map, cv::Point(map_cell.x(), map_cell.y()), radius_px, cv::Scalar(0), -1);
+
+        const cv::Rect circle_region(map_cell.x() - radius_px, map_cell.y() - radius_px, 2 * radius_px + 1,
+                                     2 * radius_px + 1);
+        region = region.area() > 0 ? (region | circle_region) : circle_region;
+    }
+    return region;
+}
+
+std::vector<cv::Rect> Costmap::updateObstacleMap(const gridmap::MapData& map_data, const cv::Rect& refresh)
+{
+    const gridmap::OccupancyGrid& grid = map_data.grid;
+    ROS_ASSERT(grid.dimensions().size().x() == width && grid.dimensions().size().y() == height);
+
+    const cv::Mat raw(height, width, CV_8U, reinterpret_cast<void*>(const_cast<uint8_t*>(grid.cells().data())));
+
+    // merge the changed tiles of each tile row into one span
+    std::vector<cv::Rect> regions;
+    if (grid.version() != grid_version)
+    {
+        for (int tile_y = 0; tile_y < grid.tilesY(); ++tile_y)
+        {
+            int min_x = std::numeric_limits<int>::max();
+            int max_x = -1;
+            for (int tile_x = 0; tile_x < grid.tilesX(); ++tile_x)
+            {
+                if (grid.tileVersion(tile_x, tile_y) > grid_version)
+                {
+                    min_x = std::min(min_x, tile_x);
+                    max_x = tile_x;
+                }
+            }
+
+            if (max_x < 0)
+                continue;
+
+            const gridmap::AABB first = grid.tileBounds(min_x, tile_y);
+            const gridmap::AABB last = grid.tileBounds(max_x, tile_y);
+            regions.emplace_back(first.roi_start.x(), first.roi_start.y(),
+                                 last.roi_start.x() + last.roi_size.x() - first.roi_start.x(), first.roi_size.y());
+        }
+        grid_version = grid.version();
+    }
+
+    const cv::Rect refresh_region = refresh & cv::Rect(0, 0, width, height);
+    if (refresh_region.area() > 0)
+        regions.push_back(refresh_region);
+
+    for (const cv::Rect& region : regions)
+        raw(region).copyTo(obstacle_map(region));
+
+    return regions;
+}
+
+std::shared_ptr<cv::Mat> traversalCostMap(const gridmap::MapData& map_data, const double avoid_zone_cost,
+                                          const double path_cost)
+{
+    // need to generate a data structure for zones
+    auto traversal_cost_map = std::make_shared<cv::Mat>(map_data.grid.dimensions().size().y(),
+                                                        map_data.grid.dimensions().size().x(), CV_32F, cv::Scalar(1.0));
+    cv::Mat& traversal_cost = *traversal_cost_map;
+
+    struct Polygon
+    {
+        std::vector<Eigen::Array2i> connected;
+        int min_x;
+        int max_x;
+        int min_y;
+        int max_y;
+    };
+
+    std::vector<Polygon> avoid_zones;
+    for (const hd_map::Zone& zone : map_data.hd_map.zones)
+    {
+        if (zone.zone_type == hd_map::Zone::AVOID_ZONE)
+        {
+            int min_x = std::numeric_limits<int>::max();
+            int max_x = 0;
+
+            int min_y = std::numeric_limits<int>::max();
+            int max_y = 0;
+
+            std::vector<Eigen::Array2i> map_polygon;
+            for (const geometry_msgs::Point32& p : zone.polygon.points)
+            {
+                const Eigen::Array2i map_point = map_data.grid.dimensions().getCellIndex({p.x, p.y});
+                min_x = std::min(map_point.x(), min_x);
+                max_x = std::max(map_point.x(), max_x);
+                min_y = std::min(map_point.y(), min_y);
+                max_y = std::max(map_point.y(), max_y);
+                map_polygon.push_back(map_point);
+            }
+            if (!map_polygon.empty())
+                map_polygon.push_back(map_polygon.front());
+
+            avoid_zones.push_back({gridmap::connectPolygon(map_polygon), min_x, max_x, min_y, max_y});
+        }
+    }
+
+    // fill the zones in bands of rows so every band is written by one thread
+    const int band_rows = 64;
+    const float zone_cost = static_cast<float>(avoid_zone_cost);
+    parallelFor((traversal_cost.rows + band_rows - 1) / band_rows, [&](const int band) {
+        const int band_min_y = band * band_rows;
+        const int band_max_y = std::min(band_min_y + band_rows, traversal_cost.rows);
+        auto append_raster = [&traversal_cost, zone_cost](const int x, const int y) {
+            if (x >= 0 && x < traversal_cost.cols && y >= 0 && y < traversal_cost.rows)
+            {
+                traversal_cost.at<float>(y, x) = zone_cost;
+            }
+        };
+
+        for (const Polygon& zone : avoid_zones)
+        {
+            const int min_y = std::max(zone.min_y, band_min_y);
+            const int max_y = std::min(zone.max_y, band_max_y);
+            if (min_y < max_y)
+                gridmap::rasterPolygonFill(append_raster, zone.connected, zone.min_x, zone.max_x, min_y, max_y);
+        }
+    });
+
+    std::unordered_map<std::string, const hd_map::Node*> nodes;
+    nodes.reserve(map_data.hd_map.nodes.size());
+    for (const hd_map::Node& node : map_data.hd_map.nodes)
+        nodes.emplace(node.id, &node);
+
+    for (const hd_map::Path& path : map_data.hd_map.paths)
+    {
+        ROS_INFO_STREAM("Loading path: " << path.name);
+        for (size_t i = 0; i + 1 < path.nodes.size(); ++i)
+        {
+            const auto first_it = nodes.find(path.nodes[i]);
+            ROS_ASSERT(first_it != nodes.end());
+            const hd_map::Node& start_node = *first_it->second;
+
+            const auto next_it = nodes.find(path.nodes[i + 1]);
+            ROS_ASSERT(next_it != nodes.end());
+            const hd_map::Node& end_node = *next_it->second;
+
+            const Eigen::Array2i start_mp = map_data.grid.dimensions().getCellIndex({start_node.x, start_node.y});
+            const Eigen::Array2i end_mp = map_data.grid.dimensions().getCellIndex({end_node.x, end_node.y});
+
+            cv::line(traversal_cost, cv::Point(start_mp[0], start_mp[1]), cv::Point(end_mp[0], end_mp[1]), path_cost,
+                     10);
+        }
+    }
+
+    // blur the traversal cost map to help provide a smooth manifold for planning
+    // in tiles with the margin of the kernel, only where the costs within reach of the tile vary
+    const int tile_size = 64;
+    const int kernel_reach = 5;
+    const cv::Mat unblurred = traversal_cost.clone();
+    const cv::Rect bounds(0, 0, traversal_cost.cols, traversal_cost.rows);
+    const int tiles_x = (traversal_cost.cols + tile_size - 1) / tile_size;
+    const int tiles_y = (traversal_cost.rows + tile_size - 1) / tile_size;
+    parallelFor(tiles_x * tiles_y, [&](const int tile) {
+        const cv::Rect tile_rect =
+            cv::Rect((tile % tiles_x) * tile_size, (tile / tiles_x) * tile_size, tile_size, tile_size) & bounds;
+        const cv::Rect halo = expand(tile_rect, kernel_reach) & bounds;
+
+        double min_cost;
+        double max_cost;
+        cv::minMaxLoc(unblurred(halo), &min_cost, &max_cost);
+        if (min_cost == max_cost)
+            return;
+
+        // the border of the blur only matters at the edge of the map, where the halo ends as well
+        cv::Mat blurred;
+        cv::GaussianBlur(unblurred(halo), blurred, cv::Size(2 * kernel_reach + 1, 2 * kernel_reach + 1), 0);
+        blurred(cv::Rect(tile_rect.x - halo.x, tile_rect.y - halo.y, tile_rect.width, tile_rect.height))
+            .copyTo(traversal_cost(tile_rect));
+    });
+
+    return traversal_cost_map;
+}
+
+namespace
+{
+
+const char TRAVERSAL_COST_MAGIC[8] = {'A', 'S', 'T', 'A', 'R', 'T', 'C', 'M'};
+const uint32_t TRAVERSAL_COST_VERSION = 1;
+
+// what the traversal costs of a map were computed from
+struct TraversalCostKey
+{
+    uint32_t modified_sec;
+    uint32_t modified_nsec;
+    int32_t width;
+    int32_t height;
+    double resolution;
+    double origin_x;
+    double origin_y;
+    double avoid_zone_cost;
+    double path_cost;
+
+    bool operator==(const TraversalCostKey& other) const
+    {
+        return modified_sec == other.modified_sec && modified_nsec == other.modified_nsec && width == other.width &&
+               height == other.height && resolution == other.resolution && origin_x == other.origin_x &&
+               origin_y == other.origin_y && avoid_zone_cost == other.avoid_zone_cost && path_cost == other.path_cost;
+    }
+};
+
+std::shared_ptr<cv::Mat> loadTraversalCostMap(const std::string& path, const TraversalCostKey& key)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return nullptr;
+
+    char magic[8];
+    uint32_t version;
+    TraversalCostKey file_key;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&file_key), sizeof(file_key));
+    if (!file || std::memcmp(magic, TRAVERSAL_COST_MAGIC, sizeof(TRAVERSAL_COST_MAGIC)) != 0 ||
+        version != TRAVERSAL_COST_VERSION || !(file_key == key))
+        return nullptr;
+
+    auto traversal_cost_map = std::make_shared<cv::Mat>(key.height, key.width, CV_32F);
+    for (int y = 0; y < key.height; ++y)
+        file.read(reinterpret_cast<char*>(traversal_cost_map->ptr<float>(y)),
+                  static_cast<std::streamsize>(key.width * sizeof(float)));
+    if (!file || file.peek() != std::char_traits<char>::eof())
+        return nullptr;
+
+    return traversal_cost_map;
+}
+
+bool saveTraversalCostMap(const std::string& path, const TraversalCostKey& key, const cv::Mat& traversal_cost)
+{
+    // written next to the file and moved over it so a reader never sees part of a file
+    const std::string temporary_path = path + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        file.write(TRAVERSAL_COST_MAGIC, sizeof(TRAVERSAL_COST_MAGIC));
+        file.write(reinterpret_cast<const char*>(&TRAVERSAL_COST_VERSION), sizeof(TRAVERSAL_COST_VERSION));
+        file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+        for (int y = 0; y < key.height; ++y)
+            file.write(reinterpret_cast<const char*>(traversal_cost.ptr<float>(y)),
+                       static_cast<std::streamsize>(key.width * sizeof(float)));
+        if (!file)
+            return false;
+    }
+
+    return std::rename(temporary_path.c_str(), path.c_str()) == 0;
+}
+
+}  // namespace
+
+std::shared_ptr<cv::Mat> traversalCostMap(const gridmap::MapData& map_data, const double avoid_zone_cost,
+                                          const double path_cost, const std::string& cache_directory)
+{
+    if (cache_directory.empty())
+        return traversalCostMap(map_data, avoid_zone_cost, path_cost);
+
+    TraversalCostKey key;
+    std::memset(&key, 0, sizeof(key));
+    key.modified_sec = map_data.hd_map.info.modified.sec;
+    key.modified_nsec = map_data.hd_map.info.modified.nsec;
+    key.width = map_data.grid.dimensions().size().x();
+    key.height = map_data.grid.dimensions().size().y();
+    key.resolution = map_data.grid.dimensions().resolution();
+    key.origin_x = map_data.grid.dimensions().origin().x();
+    key.origin_y = map_data.grid.dimensions().origin().y();
+    key.avoid_zone_cost = avoid_zone_cost;
+    key.path_cost = path_cost;
+
+    // one file per map name, replaced when the map is modified
+    std::string name = map_data.hd_map.info.name.empty() ? "unnamed" : map_data.hd_map.info.name;
+    std::replace_if(name.begin(), name.end(),
+                    [](const char c) { return !std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_'; },
+                    '_');
+    const std::string path =
+        cache_directory + (cache_directory.back() == '/' ? "" : "/") + name + ".traversal_cost";
+
+    std::shared_ptr<cv::Mat> traversal_cost_map = loadTraversalCostMap(path, key);
+    if (traversal_cost_map)
+    {
+        ROS_INFO_STREAM("Loaded traversal costs from " << path);
+        return traversal_cost_map;
+    }
+
+    traversal_cost_map = traversalCostMap(map_data, avoid_zone_cost, path_cost);
+    if (!saveTraversalCostMap(path, key, *traversal_cost_map))
+        ROS_WARN_STREAM("Failed to write traversal costs to " << path);
+
+    return traversal_cost_map;
+}
+
+void CollisionChecker::clearance(ClearanceBatch& batch) const
+{
+    ROS_ASSERT(batch.y.size() == batch.size() && batch.sin_theta.size() == batch.size() &&
+               batch.cos_theta.size() == batch.size());
+    ROS_ASSERT(costmap_.distance_to_collision.type() == CV_32F);
+
+    batch.clearance.resize(batch.size());
+
+    const ClearanceInputs in{offsets_x_.data(),
+                             offsets_y_.data(),
+                             offsets_x_.size(),
+                             costmap_.distance_to_collision.ptr<float>(),
+                             costmap_.distance_to_collision.cols,
+                             costmap_.distance_to_collision.rows,
+                             static_cast<int>(costmap_.distance_to_collision.step1()),
+                             costmap_.origin_x,
+                             costmap_.origin_y,
+                             costmap_.resolution};
+
+    std::size_t begin = 0;
+#ifdef ASTAR_PLANNER_AVX2
+    if (hasAVX2())
+        begin = clearanceAVX2(in, batch);
+#endif
+    clearanceScalar(in, batch, begin);
+}
+
 }  // namespace astar_planner
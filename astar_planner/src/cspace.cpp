@@ -0,0 +1,213 @@
+#include <astar_planner/costmap.h>
+#include <astar_planner/cspace.h>
+#include <astar_planner/parallel.h>
+
+#include <algorithm>
+
+namespace astar_planner
+{
+
+namespace
+{
+
+// 64 bits of a bit packed row starting at bit, bits outside [0, width) and rows outside the grid (nullptr) read as set
+uint64_t readBits(const uint64_t* row, const int width, const int bit)
+{
+    if (!row)
+        return ~uint64_t(0);
+
+    if (bit >= 0 && bit + 64 <= width)
+    {
+        const int word = bit >> 6;
+        const int shift = bit & 63;
+        if (shift == 0)
+            return row[word];
+        return (row[word] >> shift) | (row[word + 1] << (64 - shift));
+    }
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 64; ++i)
+    {
+        const int b = bit + i;
+        if (b < 0 || b >= width || ((row[b >> 6] >> (b & 63)) & 1u))
+            bits |= uint64_t(1) << i;
+    }
+    return bits;
+}
+
+cv::Rect expand(const cv::Rect& rect, const int margin)
+{
+    return cv::Rect(rect.x - margin, rect.y - margin, rect.width + 2 * margin, rect.height + 2 * margin);
+}
+
+}  // namespace
+
+CSpace::CSpace(const double angular_resolution, const std::vector<Eigen::Vector2d>& offsets)
+    : angular_resolution_(angular_resolution), offsets_(offsets),
+      max_theta_index_(static_cast<int>(std::ceil(M_PI / angular_resolution)) + 1), built_(false), width_(0),
+      height_(0), resolution_(0), padded_width_(0), padded_height_(0), padded_words_(0), reach_(0), layer_words_(0)
+{
+    ROS_ASSERT(angular_resolution > 0);
+}
+
+void CSpace::build(const Costmap& costmap)
+{
+    resize(costmap);
+
+    const cv::Rect map(0, 0, width_, height_);
+    updateBlocked(costmap, map);
+    updateSure(map);
+    parallelFor(static_cast<int>(layers_.size()),
+                [this, &map](const int bin) { updateLayer(static_cast<std::size_t>(bin), map); });
+
+    built_ = true;
+}
+
+void CSpace::update(const Costmap& costmap, const std::vector<cv::Rect>& regions)
+{
+    if (!built_ || costmap.width != width_ || costmap.height != height_ || costmap.resolution != resolution_)
+    {
+        build(costmap);
+        return;
+    }
+
+    const cv::Rect map(0, 0, width_, height_);
+    std::vector<cv::Rect> changed;
+    for (const cv::Rect& region : regions)
+    {
+        const cv::Rect r = region & map;
+        if (r.area() == 0)
+            continue;
+
+        updateBlocked(costmap, r);
+        updateSure(r);
+        changed.push_back(r);
+    }
+
+    if (changed.empty())
+        return;
+
+    parallelFor(static_cast<int>(layers_.size()), [this, &changed](const int bin) {
+        for (const cv::Rect& r : changed)
+            updateLayer(static_cast<std::size_t>(bin), r);
+    });
+}
+
+void CSpace::resize(const Costmap& costmap)
+{
+    width_ = costmap.width;
+    height_ = costmap.height;
+    resolution_ = costmap.resolution;
+
+    padded_width_ = width_ + 2;
+    padded_height_ = height_ + 2;
+    padded_words_ = (padded_width_ + 63) / 64;
+    const std::size_t padded_size = static_cast<std::size_t>(padded_height_ * padded_words_);
+    blocked_.assign(padded_size, ~uint64_t(0));
+    sure_.assign(padded_size, ~uint64_t(0));
+
+    // the offsets are rotated exactly as the collision checker rotates them
+    const std::size_t bins = static_cast<std::size_t>(2 * max_theta_index_ + 1);
+    shifts_.assign(bins, {});
+    reach_ = 0;
+    for (int theta_index = -max_theta_index_; theta_index <= max_theta_index_; ++theta_index)
+    {
+        const double theta = theta_index * angular_resolution_;
+        const double st = std::sin(theta);
+        const double ct = std::cos(theta);
+
+        std::vector<Eigen::Array2i>& shifts = shifts_[static_cast<std::size_t>(theta_index + max_theta_index_)];
+        for (const auto& offset : offsets_)
+        {
+            const Eigen::Array2i shift(static_cast<int>(std::round((offset.x() * ct - offset.y() * st) / resolution_)),
+                                       static_cast<int>(std::round((offset.x() * st + offset.y() * ct) / resolution_)));
+            if (std::none_of(shifts.begin(), shifts.end(),
+                             [&shift](const Eigen::Array2i& s) { return (s == shift).all(); }))
+                shifts.push_back(shift);
+            reach_ = std::max(reach_, shift.abs().maxCoeff());
+        }
+    }
+
+    // the one cell erosion
+    reach_ += 1;
+
+    layer_words_ = (width_ + 63) / 64;
+    layers_.assign(bins, std::vector<uint64_t>(static_cast<std::size_t>(height_ * layer_words_), 0));
+}
+
+void CSpace::updateBlocked(const Costmap& costmap, const cv::Rect& rect)
+{
+    ROS_ASSERT(costmap.distance_to_collision.type() == CV_32F);
+    for (int y = rect.y; y < rect.y + rect.height; ++y)
+    {
+        const float* distance = costmap.distance_to_collision.ptr<float>(y);
+        uint64_t* row = &blocked_[static_cast<std::size_t>((y + 1) * padded_words_)];
+        for (int x = rect.x; x < rect.x + rect.width; ++x)
+        {
+            const int px = x + 1;
+            const uint64_t bit = uint64_t(1) << (px & 63);
+            if (distance[x] <= 0.f)
+                row[px >> 6] |= bit;
+            else
+                row[px >> 6] &= ~bit;
+        }
+    }
+}
+
+void CSpace::updateSure(const cv::Rect& rect)
+{
+    // a blocked cell changes the sure cells around it, rect grown by one is rect in padded coordinates
+    const int px_begin = std::max(0, rect.x);
+    const int px_end = std::min(padded_width_, rect.x + rect.width + 2);
+    const int py_begin = std::max(0, rect.y);
+    const int py_end = std::min(padded_height_, rect.y + rect.height + 2);
+    if (px_begin >= px_end || py_begin >= py_end)
+        return;
+
+    for (int py = py_begin; py < py_end; ++py)
+    {
+        for (int word = px_begin >> 6; word <= (px_end - 1) >> 6; ++word)
+        {
+            const int bit = word * 64;
+            uint64_t sure = ~uint64_t(0);
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                const int row_y = py + dy;
+                const uint64_t* row = (row_y >= 0 && row_y < padded_height_)
+                                          ? &blocked_[static_cast<std::size_t>(row_y * padded_words_)]
+                                          : nullptr;
+                sure &= readBits(row, padded_width_, bit - 1) & readBits(row, padded_width_, bit) &
+                        readBits(row, padded_width_, bit + 1);
+            }
+            sure_[static_cast<std::size_t>(py * padded_words_ + word)] = sure;
+        }
+    }
+}
+
+void CSpace::updateLayer(const std::size_t bin, const cv::Rect& rect)
+{
+    const cv::Rect r = expand(rect, reach_) & cv::Rect(0, 0, width_, height_);
+    if (r.area() == 0)
+        return;
+
+    const std::vector<Eigen::Array2i>& shifts = shifts_[bin];
+    std::vector<uint64_t>& layer = layers_[bin];
+    for (int y = r.y; y < r.y + r.height; ++y)
+    {
+        for (int word = r.x >> 6; word <= (r.x + r.width - 1) >> 6; ++word)
+        {
+            const int bit = word * 64;
+            uint64_t blocked = 0;
+            for (const Eigen::Array2i& shift : shifts)
+            {
+                const int py = y + shift.y() + 1;
+                const uint64_t* row =
+                    (py >= 0 && py < padded_height_) ? &sure_[static_cast<std::size_t>(py * padded_words_)] : nullptr;
+                blocked |= readBits(row, padded_width_, bit + shift.x() + 1);
+            }
+            layer[static_cast<std::size_t>(y * layer_words_ + word)] = blocked;
+        }
+    }
+}
+
+}  // namespace astar_planner
@@ -0,0 +1,304 @@
+#include <astar_planner/astar.h>
+#include <astar_planner/dstar_lite.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace astar_planner
+{
+
+namespace
+{
+
+const double INF = std::numeric_limits<double>::infinity();
+
+}  // namespace
+
+DStarLite::DStarLite()
+    : started_(false), goal_{0, 0}, last_start_{0, 0}, width_(0), height_(0), heuristic_scale_(1.0),
+      key_modifier_(0), expansions_(0)
+{
+}
+
+void DStarLite::reset(const State2D& goal, const CollisionChecker& collision_checker)
+{
+    const Costmap& costmap = collision_checker.costmap();
+    ROS_ASSERT(costmap.traversal_cost);
+
+    open_set_.clear();
+    nodes_ = NodeIndexMap<DStarNode>();
+
+    width_ = costmap.width;
+    height_ = costmap.height;
+    goal_ = goal;
+    last_start_ = goal;
+    key_modifier_ = 0;
+    expansions_ = 0;
+
+    cellCosts2D(collision_checker, cell_costs_);
+    next_cell_costs_ = cell_costs_;
+
+    // collision costs are at least 1 so the traversal cost bounds the cell cost from below
+    double min_traversal_cost = std::numeric_limits<double>::max();
+    for (int y = 0; y < costmap.height; ++y)
+    {
+        const float* traversal_cost = costmap.traversal_cost->ptr<float>(y);
+        for (int x = 0; x < costmap.width; ++x)
+            min_traversal_cost = std::min(min_traversal_cost, static_cast<double>(traversal_cost[x]));
+    }
+    heuristic_scale_ = std::max(0.0, min_traversal_cost);
+
+    DStarNode* goal_node = node(goal);
+    goal_node->rhs = 0;
+    calculateKey(goal_node);
+    open_set_.push(goal_node);
+
+    started_ = true;
+}
+
+std::size_t DStarLite::updateCellCosts(const CollisionChecker& collision_checker,
+                                       const std::vector<cv::Rect>& regions)
+{
+    ROS_ASSERT(started_);
+    ROS_ASSERT(collision_checker.costmap().width == width_ && collision_checker.costmap().height == height_);
+
+    std::size_t changed = 0;
+    const cv::Rect bounds(0, 0, width_, height_);
+    for (const cv::Rect& r : regions)
+    {
+        const cv::Rect region = r & bounds;
+        cellCosts2D(collision_checker, region, next_cell_costs_);
+
+        for (int y = region.y; y < region.y + region.height; ++y)
+        {
+            for (int x = region.x; x < region.x + region.width; ++x)
+            {
+                const State2D v{x, y};
+                const std::size_t v_index = index(v);
+                const double old_cost = static_cast<double>(cell_costs_[v_index]);
+                const double new_cost = static_cast<double>(next_cell_costs_[v_index]);
+                if (old_cost == new_cost)
+                    continue;
+
+                ++changed;
+                cell_costs_[v_index] = next_cell_costs_[v_index];
+
+                // only the edges leaving v changed
+                // cells blocked until now have no node as the search never enters them, a freed cell next to reached
+                // cells is queued here and the expansions reach the rest of them
+                if (v == goal_)
+                    continue;
+                const double rhs = bestSuccessor(v);
+                DStarNode* v_node = nodes_.find(v_index);
+                if (!v_node && !std::isfinite(rhs))
+                    continue;
+                if (!v_node)
+                    v_node = node(v);
+                v_node->rhs = rhs;
+                updateVertex(v_node);
+            }
+        }
+    }
+
+    return changed;
+}
+
+bool DStarLite::computeShortestPath(const State2D& start)
+{
+    ROS_ASSERT(started_);
+
+    expansions_ = 0;
+    if (!contains(start))
+        return false;
+
+    key_modifier_ += heuristic(last_start_, start);
+    last_start_ = start;
+
+    DStarNode* start_node = node(start);
+    while (!open_set_.empty())
+    {
+        DStarNode* u = open_set_.top();
+
+        const double start_min = std::min(start_node->g, start_node->rhs);
+        const std::pair<double, double> start_key(start_min + key_modifier_, start_min);
+        if (std::make_pair(u->key_1, u->key_2) >= start_key && start_node->rhs <= start_node->g)
+            break;
+
+        ++expansions_;
+
+        const std::pair<double, double> old_key(u->key_1, u->key_2);
+        calculateKey(u);
+        if (old_key < std::make_pair(u->key_1, u->key_2))
+        {
+            // the key was computed for an earlier start
+            open_set_.update(u);
+        }
+        else if (u->g > u->rhs)
+        {
+            u->g = u->rhs;
+            open_set_.pop();
+
+            for (std::size_t i = 0; i < directions_2d.size(); ++i)
+            {
+                const State2D s = u->state + directions_2d[i];
+                if (!contains(s) || s == goal_)
+                    continue;
+
+                const double s_cost = static_cast<double>(cell_costs_[index(s)]);
+                if (!std::isfinite(s_cost))
+                    continue;
+
+                DStarNode* s_node = node(s);
+                s_node->rhs = std::min(s_node->rhs, directions_2d_cost[i] * s_cost + u->g);
+                updateVertex(s_node);
+            }
+        }
+        else
+        {
+            const double old_g = u->g;
+            u->g = INF;
+
+            for (std::size_t i = 0; i < directions_2d.size(); ++i)
+            {
+                const State2D s = u->state + directions_2d[i];
+                if (!contains(s) || s == goal_)
+                    continue;
+
+                const double s_cost = static_cast<double>(cell_costs_[index(s)]);
+                if (!std::isfinite(s_cost))
+                    continue;
+
+                DStarNode* s_node = node(s);
+                if (s_node->rhs == directions_2d_cost[i] * s_cost + old_g)
+                    s_node->rhs = bestSuccessor(s);
+                updateVertex(s_node);
+            }
+
+            if (!(u->state == goal_))
+                u->rhs = bestSuccessor(u->state);
+            updateVertex(u);
+        }
+    }
+
+    return std::isfinite(start_node->rhs);
+}
+
+std::vector<State2D> DStarLite::path(const State2D& start) const
+{
+    std::vector<State2D> path;
+    if (!contains(start) || !std::isfinite(costToGo(start)))
+        return path;
+
+    path.push_back(start);
+    State2D current = start;
+    const std::size_t max_length = static_cast<std::size_t>(width_) * static_cast<std::size_t>(height_);
+    while (!(current == goal_) && path.size() < max_length)
+    {
+        const double current_cost = static_cast<double>(cell_costs_[index(current)]);
+        double best = INF;
+        State2D next = current;
+        for (std::size_t i = 0; i < directions_2d.size(); ++i)
+        {
+            const State2D s = current + directions_2d[i];
+            if (!contains(s))
+                continue;
+
+            const DStarNode* s_node = findNode(s);
+            if (!s_node)
+                continue;
+
+            const double cost = directions_2d_cost[i] * current_cost + s_node->g;
+            if (cost < best)
+            {
+                best = cost;
+                next = s;
+            }
+        }
+
+        if (!std::isfinite(best))
+            return {};
+
+        current = next;
+        path.push_back(current);
+    }
+
+    if (!(current == goal_))
+        return {};
+
+    return path;
+}
+
+double DStarLite::costToGo(const State2D& state) const
+{
+    // the search can stop with the start overconsistent, rhs already holds its cost through the best successor
+    const DStarNode* state_node = findNode(state);
+    if (state_node && std::isfinite(state_node->rhs))
+        return state_node->rhs;
+    else
+        return std::numeric_limits<double>::max();
+}
+
+double DStarLite::heuristic(const State2D& s1, const State2D& s2) const
+{
+    const double dx = s2.x - s1.x;
+    const double dy = s2.y - s1.y;
+    return heuristic_scale_ * std::sqrt(dx * dx + dy * dy);
+}
+
+DStarNode* DStarLite::node(const State2D& state)
+{
+    return nodes_.emplace(index(state), DStarNode{state, INF, INF, INF, INF}).first;
+}
+
+const DStarNode* DStarLite::findNode(const State2D& state) const
+{
+    return nodes_.find(index(state));
+}
+
+void DStarLite::calculateKey(DStarNode* node) const
+{
+    const double min_g = std::min(node->g, node->rhs);
+    node->key_1 = min_g + heuristic(last_start_, node->state) + key_modifier_;
+    node->key_2 = min_g;
+}
+
+void DStarLite::updateVertex(DStarNode* node)
+{
+    if (node->g != node->rhs)
+    {
+        calculateKey(node);
+        if (open_set_.contains(node))
+            open_set_.update(node);
+        else
+            open_set_.push(node);
+    }
+    else if (open_set_.contains(node))
+    {
+        open_set_.erase(node);
+    }
+}
+
+double DStarLite::bestSuccessor(const State2D& state) const
+{
+    const double state_cost = static_cast<double>(cell_costs_[index(state)]);
+    if (!std::isfinite(state_cost))
+        return INF;
+
+    double best = INF;
+    for (std::size_t i = 0; i < directions_2d.size(); ++i)
+    {
+        const State2D s = state + directions_2d[i];
+        if (!contains(s))
+            continue;
+
+        const DStarNode* s_node = findNode(s);
+        if (!s_node)
+            continue;
+
+        best = std::min(best, directions_2d_cost[i] * state_cost + s_node->g);
+    }
+    return best;
+}
+
+}  // namespace astar_planner
@@ -0,0 +1,179 @@
+#include <Eigen/Geometry>
+
+#include <astar_planner/astar.h>
+#include <astar_planner/dstar_lite_plugin.h>
+#include <navigation_interface/params.h>
+#include <pluginlib/class_list_macros.h>
+
+#include <chrono>
+
+PLUGINLIB_EXPORT_CLASS(astar_planner::DStarLitePlanner, navigation_interface::PathPlanner)
+
+namespace astar_planner
+{
+
+DStarLitePlanner::DStarLitePlanner()
+{
+}
+
+DStarLitePlanner::~DStarLitePlanner()
+{
+}
+
+navigation_interface::PathPlanner::Result  // cppcheck-suppress unusedFunction
+    DStarLitePlanner::plan(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal, const GoalSampleSettings&)
+{
+    navigation_interface::PathPlanner::Result result;
+    result.outcome = navigation_interface::PathPlanner::Outcome::FAILED;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    bool rebuild = false;
+    std::vector<cv::Rect> changed;
+    {
+        // cppcheck-suppress unreadVariable
+        auto lock = map_data_->grid.getLock();
+        if (!costmap_ || costmap_map_data_ != map_data_)
+        {
+            costmap_ = std::make_shared<Costmap>(*map_data_, robot_radius_);
+            costmap_map_data_ = map_data_;
+            rebuild = true;
+        }
+        else
+        {
+            changed = costmap_->updateObstacleMap(*map_data_, footprint_region_);
+        }
+    }
+
+    // clear the robot footprint
+    footprint_region_ = costmap_->clearFootprint(start, offsets_);
+
+    if (rebuild)
+    {
+        costmap_->processObstacleMap();
+    }
+    else
+    {
+        changed.push_back(footprint_region_);
+        changed = costmap_->processObstacleMap(changed);
+    }
+
+    ROS_ASSERT(traversal_cost_);
+    costmap_->traversal_cost = traversal_cost_;
+    const CollisionChecker collision_checker(*costmap_, offsets_, conservative_robot_radius_);
+
+    const Eigen::Array2i start_cell = costmap_->getCellIndex(start.translation());
+    const Eigen::Array2i goal_cell = costmap_->getCellIndex(goal.translation());
+    const State2D start_2d{start_cell.x(), start_cell.y()};
+    const State2D goal_2d{goal_cell.x(), goal_cell.y()};
+
+    if (!collision_checker.isWithinBounds(start_2d) || !collision_checker.isWithinBounds(goal_2d))
+    {
+        ROS_WARN("Start or goal outside of the map!");
+        return result;
+    }
+
+    // the search is kept while the goal stays the same, otherwise only the changed cells are repaired
+    std::size_t changed_cells = 0;
+    if (rebuild || !dstar_.started() || !(dstar_.goal() == goal_2d))
+        dstar_.reset(goal_2d, collision_checker);
+    else
+        changed_cells = dstar_.updateCellCosts(collision_checker, changed);
+
+    const bool success = dstar_.computeShortestPath(start_2d);
+
+    ROS_INFO_STREAM(
+        "D* Lite took "
+        << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0).count()
+        << " changed cells: " << changed_cells << " expansions: " << dstar_.expansions());
+
+    if (!success)
+    {
+        ROS_WARN("No path to goal!");
+        return result;
+    }
+
+    const std::vector<State2D> cells = dstar_.path(start_2d);
+    if (cells.empty())
+    {
+        ROS_WARN("Failed to follow D* Lite solution!");
+        return result;
+    }
+
+    // sample the cells every path_spacing and turn towards the goal orientation along the way
+    const std::size_t step =
+        std::max(std::size_t(1), static_cast<std::size_t>(std::round(path_spacing_ / costmap_->resolution)));
+    const Eigen::Rotation2Dd start_rotation(start.linear());
+    const Eigen::Rotation2Dd goal_rotation(goal.linear());
+
+    result.path.nodes.push_back(start);
+    for (std::size_t i = step; i + 1 < cells.size(); i += step)
+    {
+        const double fraction = static_cast<double>(i) / static_cast<double>(cells.size() - 1);
+        const Eigen::Vector2d p(costmap_->origin_x + cells[i].x * costmap_->resolution,
+                                costmap_->origin_y + cells[i].y * costmap_->resolution);
+        result.path.nodes.push_back(Eigen::Translation2d(p) * start_rotation.slerp(fraction, goal_rotation));
+    }
+    result.path.nodes.push_back(goal);
+
+    result.cost = pathCost(result.path, collision_checker, backwards_mult_, strafe_mult_, rotation_mult_);
+    result.outcome = navigation_interface::PathPlanner::Outcome::SUCCESSFUL;
+    return result;
+}
+
+// cppcheck-suppress unusedFunction
+bool DStarLitePlanner::valid(const navigation_interface::Path& path) const
+{
+    // assume this is called immediately after plan to re-use the data structures
+    ROS_ASSERT(costmap_);
+
+    const CollisionChecker collision_checker(*costmap_, offsets_, conservative_robot_radius_);
+    return pathCost(path, collision_checker, backwards_mult_, strafe_mult_, rotation_mult_) <
+           std::numeric_limits<double>::max();
+}
+
+double DStarLitePlanner::cost(const navigation_interface::Path& path) const
+{
+    // assume this is called immediately after plan to re-use the data structures
+    ROS_ASSERT(costmap_);
+
+    const CollisionChecker collision_checker(*costmap_, offsets_, conservative_robot_radius_);
+    return pathCost(path, collision_checker, backwards_mult_, strafe_mult_, rotation_mult_);
+}
+
+// cppcheck-suppress unusedFunction
+void DStarLitePlanner::onInitialize(const YAML::Node& parameters)
+{
+    robot_radius_ = parameters["robot_radius"].as<double>(robot_radius_);
+    conservative_robot_radius_ = parameters["conservative_robot_radius"].as<double>(conservative_robot_radius_);
+    avoid_zone_cost_ = parameters["avoid_zone_cost"].as<double>(avoid_zone_cost_);
+    path_cost_ = parameters["path_cost"].as<double>(path_cost_);
+
+    backwards_mult_ = parameters["backwards_mult"].as<double>(backwards_mult_);
+    strafe_mult_ = parameters["strafe_mult"].as<double>(strafe_mult_);
+    rotation_mult_ = parameters["rotation_mult"].as<double>(rotation_mult_);
+
+    path_spacing_ = parameters["path_spacing"].as<double>(path_spacing_);
+
+    offsets_ = navigation_interface::get_point_list(parameters, "robot_radius_offsets",
+                                                    {{-0.268, 0.000},
+                                                     {0.268, 0.000},
+                                                     {0.265, -0.185},
+                                                     {0.077, -0.185},
+                                                     {-0.077, -0.185},
+                                                     {-0.265, -0.185},
+                                                     {0.265, 0.185},
+                                                     {-0.265, 0.185},
+                                                     {-0.077, 0.185},
+                                                     {0.077, 0.185}});
+}
+
+// cppcheck-suppress unusedFunction
+void DStarLitePlanner::onMapDataChanged()
+{
+    ROS_INFO("Building avoid zone traversal costmap");
+
+    traversal_cost_ = traversalCostMap(*map_data_, avoid_zone_cost_, path_cost_);
+}
+
+}  // namespace astar_planner
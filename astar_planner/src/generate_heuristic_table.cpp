@@ -0,0 +1,43 @@
+#include <astar_planner/heuristic_table.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Writes the heuristic table for the motion model of the planner
+// The resolutions are those of AStarPlanner, the cost multipliers must match its parameters
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 6)
+    {
+        std::cout << "Usage: " << argv[0] << " <output> [size=2.0] [backwards_mult=1.5] [strafe_mult=1.5]"
+                  << " [rotation_mult=0.3/pi]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    astar_planner::HeuristicTable::Settings settings;
+    settings.linear_resolution = 0.04;
+    settings.angular_resolution = M_PI / 16;
+    settings.size = argc > 2 ? std::stod(argv[2]) : 2.0;
+    settings.backwards_mult = argc > 3 ? std::stod(argv[3]) : 1.5;
+    settings.strafe_mult = argc > 4 ? std::stod(argv[4]) : 1.5;
+    settings.rotation_mult = argc > 5 ? std::stod(argv[5]) : 0.3 / M_PI;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const astar_planner::HeuristicTable table(settings);
+    const auto t1 = std::chrono::steady_clock::now();
+
+    if (!table.save(argv[1]))
+    {
+        std::cout << "Failed to write " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Generated " << table.headings() << " headings of " << 2 * table.halfCells() + 1 << "x"
+              << 2 * table.halfCells() + 1 << " cells in "
+              << std::chrono::duration<double>(t1 - t0).count() << "s" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,405 @@
+#include <astar_planner/heuristic_table.h>
+#include <astar_planner/motion_primitives.h>
+
+#include <ros/assert.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <utility>
+
+namespace astar_planner
+{
+
+namespace
+{
+
+const char MAGIC[8] = {'A', 'S', 'T', 'A', 'R', 'H', 'T', 'B'};
+const uint32_t VERSION = 2;
+
+struct Move
+{
+    int dx;
+    int dy;
+    int heading;
+    double cost;
+};
+
+int wrapHeading(const int heading, const int headings)
+{
+    return (heading % headings + headings) % headings;
+}
+
+// the displacements in cells of a move of cells on the lattice of res_mult, from every position on the lattice
+// both sides of a tie are taken as the search rounds it by the sign and the last bits of the position
+std::vector<int> snapped(const double cells, const int res_mult)
+{
+    std::vector<int> result;
+    for (int phase = 0; phase < res_mult; ++phase)
+    {
+        const double position = (phase + cells) / res_mult;
+        const double lower = std::floor(position);
+        if (std::abs(position - lower - 0.5) < 1e-6)
+        {
+            result.push_back(static_cast<int>(lower) * res_mult - phase);
+            result.push_back(static_cast<int>(lower + 1) * res_mult - phase);
+        }
+        else
+        {
+            result.push_back(static_cast<int>(std::round(position)) * res_mult - phase);
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+// the moves of MotionPrimitives from each heading in cells, to the heading of the move, costed as the search costs
+// them away from obstacles
+std::vector<std::vector<Move>> moves(const HeuristicTable::Settings& settings, const int headings)
+{
+    const double res = settings.linear_resolution;
+    const double ang = settings.angular_resolution;
+    const MotionPrimitives primitives(res, ang, res, {});
+
+    std::vector<std::vector<Move>> result(static_cast<std::size_t>(headings));
+
+    // pi is reached from both sides
+    const int max_theta_index = static_cast<int>(std::ceil(M_PI / ang));
+    HeadingPrimitives scratch;
+    for (int theta_index = -max_theta_index; theta_index <= max_theta_index; ++theta_index)
+    {
+        const double theta = theta_index * ang;
+        const HeadingPrimitives& heading = primitives.successors(theta, scratch);
+        std::vector<Move>& heading_moves = result[static_cast<std::size_t>(wrapHeading(theta_index, headings))];
+
+        for (std::size_t level = 0; level < NUM_RESOLUTION_LEVELS; ++level)
+        {
+            const int res_mult = static_cast<int>(MotionPrimitives::resolutionMult(level));
+            for (const MotionPrimitive& primitive : heading.primitives[level])
+            {
+                const double st = primitives.sinTheta(primitive.theta_index);
+                const double ct = primitives.cosTheta(primitive.theta_index);
+                const double rotation_cost =
+                    std::abs(wrapAngle(primitive.theta_index * ang - theta)) * settings.rotation_mult;
+
+                for (const int dx : snapped(primitive.dx / res, res_mult))
+                {
+                    for (const int dy : snapped(primitive.dy / res, res_mult))
+                    {
+                        if (dx == 0 && dy == 0 && primitive.theta_index == theta_index)
+                            continue;
+
+                        // inverse rotation of the snapped move into the new heading
+                        const double trans_x = dx * res;
+                        const double trans_y = dy * res;
+                        const double x = trans_x * ct + trans_y * st;
+                        const double y = -trans_x * st + trans_y * ct;
+
+                        const double x_cost = std::abs((x > 0) ? x : settings.backwards_mult * x);
+                        const double y_cost = std::abs(settings.strafe_mult * y);
+
+                        heading_moves.push_back(
+                            {dx, dy, wrapHeading(primitive.theta_index, headings), x_cost + y_cost + rotation_cost});
+                    }
+                }
+            }
+        }
+    }
+
+    // the moves turned by a quarter as well, which lets the table be turned by a quarter too
+    if (headings % 4 == 0)
+    {
+        const int quarter = headings / 4;
+        std::vector<std::vector<Move>> turned = result;
+        for (int heading = 0; heading < headings; ++heading)
+        {
+            for (const Move& move : result[static_cast<std::size_t>(heading)])
+            {
+                Move turned_move = move;
+                int from = heading;
+                for (int i = 1; i < 4; ++i)
+                {
+                    turned_move = {-turned_move.dy, turned_move.dx,
+                                   wrapHeading(turned_move.heading + quarter, headings), turned_move.cost};
+                    from = wrapHeading(from + quarter, headings);
+                    turned[static_cast<std::size_t>(from)].push_back(turned_move);
+                }
+            }
+        }
+        result = std::move(turned);
+    }
+
+    // the cheapest of equal moves
+    for (std::vector<Move>& heading_moves : result)
+    {
+        std::sort(heading_moves.begin(), heading_moves.end(), [](const Move& lhs, const Move& rhs) {
+            return std::tie(lhs.heading, lhs.dx, lhs.dy, lhs.cost) < std::tie(rhs.heading, rhs.dx, rhs.dy, rhs.cost);
+        });
+        heading_moves.erase(std::unique(heading_moves.begin(), heading_moves.end(),
+                                        [](const Move& lhs, const Move& rhs) {
+                                            return lhs.heading == rhs.heading && lhs.dx == rhs.dx && lhs.dy == rhs.dy;
+                                        }),
+                            heading_moves.end());
+    }
+
+    return result;
+}
+
+// the cheapest translation from cells away from the goal cell to a state the search accepts as the goal
+double distanceCost(const HeuristicTable::Settings& settings, const int x, const int y)
+{
+    const double mult = std::min({1.0, settings.backwards_mult, settings.strafe_mult});
+    return mult * std::max(0, std::max(std::abs(x), std::abs(y)) - 2) * settings.linear_resolution;
+}
+
+}  // namespace
+
+HeuristicTable::HeuristicTable(const Settings& settings) : settings_(settings)
+{
+    ROS_ASSERT(settings.linear_resolution > 0);
+    ROS_ASSERT(settings.angular_resolution > 0);
+    ROS_ASSERT(settings.size > 0);
+
+    half_cells_ = static_cast<int>(std::round(settings.size / settings.linear_resolution));
+    headings_ = static_cast<int>(std::round(2 * M_PI / settings.angular_resolution));
+    ROS_ASSERT_MSG(std::abs(headings_ * settings.angular_resolution - 2 * M_PI) < 1e-6,
+                   "Angular resolution must divide a full turn");
+    goal_headings_ = headings_ % 4 == 0 ? headings_ / 4 : headings_;
+
+    const int half = half_cells_;
+    const int width = 2 * half + 1;
+    const std::size_t layer = static_cast<std::size_t>(width) * static_cast<std::size_t>(width);
+    auto searchIndex = [&](const int x, const int y, const int heading) {
+        return static_cast<std::size_t>(heading) * layer + static_cast<std::size_t>(y + half) * width +
+               static_cast<std::size_t>(x + half);
+    };
+
+    const std::vector<std::vector<Move>> heading_moves = moves(settings, headings_);
+
+    // the moves into each heading, from the heading of the move
+    std::vector<std::vector<Move>> reverse_moves(static_cast<std::size_t>(headings_));
+    int max_move = 0;
+    for (int heading = 0; heading < headings_; ++heading)
+    {
+        for (const Move& move : heading_moves[static_cast<std::size_t>(heading)])
+        {
+            reverse_moves[static_cast<std::size_t>(move.heading)].push_back({move.dx, move.dy, heading, move.cost});
+            max_move = std::max({max_move, std::abs(move.dx), std::abs(move.dy)});
+        }
+    }
+
+    // moves leaving the table still have to cover the distance to the goal, which bounds the states near the edge
+    std::vector<double> exit_cost(layer * static_cast<std::size_t>(headings_), std::numeric_limits<double>::max());
+    for (int heading = 0; heading < headings_; ++heading)
+    {
+        for (int y = -half; y <= half; ++y)
+        {
+            for (int x = -half; x <= half; ++x)
+            {
+                if (std::max(std::abs(x), std::abs(y)) + max_move <= half)
+                    continue;
+
+                double& cost = exit_cost[searchIndex(x, y, heading)];
+                for (const Move& move : heading_moves[static_cast<std::size_t>(heading)])
+                {
+                    const int to_x = x + move.dx;
+                    const int to_y = y + move.dy;
+                    if (std::abs(to_x) > half || std::abs(to_y) > half)
+                        cost = std::min(cost, move.cost + distanceCost(settings, to_x, to_y));
+                }
+            }
+        }
+    }
+
+    costs_.resize(static_cast<std::size_t>(goal_headings_) * static_cast<std::size_t>(headings_) * layer);
+    for (int goal_heading = 0; goal_heading < goal_headings_; ++goal_heading)
+    {
+        std::vector<double> cost = exit_cost;
+
+        using Entry = std::pair<double, std::size_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open_set;
+        for (std::size_t i = 0; i < cost.size(); ++i)
+        {
+            if (cost[i] < std::numeric_limits<double>::max())
+                open_set.push({cost[i], i});
+        }
+
+        // every state the search accepts as reaching a goal in the goal cell
+        for (int heading = goal_heading - 2; heading <= goal_heading + 2; ++heading)
+        {
+            for (int y = -2; y <= 2; ++y)
+            {
+                for (int x = -2; x <= 2; ++x)
+                {
+                    const std::size_t i = searchIndex(x, y, wrapHeading(heading, headings_));
+                    cost[i] = 0;
+                    open_set.push({0, i});
+                }
+            }
+        }
+
+        while (!open_set.empty())
+        {
+            const Entry current = open_set.top();
+            open_set.pop();
+            if (current.first > cost[current.second])
+                continue;
+
+            const int heading = static_cast<int>(current.second / layer);
+            const int y = static_cast<int>((current.second % layer) / width) - half;
+            const int x = static_cast<int>(current.second % width) - half;
+
+            // the states with a move to the current state
+            for (const Move& move : reverse_moves[static_cast<std::size_t>(heading)])
+            {
+                const int from_x = x - move.dx;
+                const int from_y = y - move.dy;
+                if (std::abs(from_x) > half || std::abs(from_y) > half)
+                    continue;
+
+                const std::size_t from = searchIndex(from_x, from_y, move.heading);
+                const double from_cost = current.first + move.cost;
+                if (from_cost < cost[from])
+                {
+                    cost[from] = from_cost;
+                    open_set.push({from_cost, from});
+                }
+            }
+        }
+
+        // rounded down to stay a lower bound
+        for (int heading = 0; heading < headings_; ++heading)
+        {
+            for (int y = -half; y <= half; ++y)
+            {
+                for (int x = -half; x <= half; ++x)
+                {
+                    const double c = cost[searchIndex(x, y, heading)];
+                    float& table_cost = costs_[index(goal_heading, x, y, heading)];
+                    table_cost = std::numeric_limits<float>::max();
+                    if (c < std::numeric_limits<double>::max())
+                    {
+                        table_cost = static_cast<float>(c);
+                        if (table_cost > c)
+                            table_cost = std::nextafter(table_cost, 0.0f);
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::shared_ptr<HeuristicTable> HeuristicTable::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return nullptr;
+
+    char magic[8];
+    uint32_t version;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION)
+        return nullptr;
+
+    std::shared_ptr<HeuristicTable> table(new HeuristicTable());
+    Settings& settings = table->settings_;
+    int32_t half_cells;
+    int32_t headings;
+    int32_t goal_headings;
+    file.read(reinterpret_cast<char*>(&settings.linear_resolution), sizeof(double));
+    file.read(reinterpret_cast<char*>(&settings.angular_resolution), sizeof(double));
+    file.read(reinterpret_cast<char*>(&settings.backwards_mult), sizeof(double));
+    file.read(reinterpret_cast<char*>(&settings.strafe_mult), sizeof(double));
+    file.read(reinterpret_cast<char*>(&settings.rotation_mult), sizeof(double));
+    file.read(reinterpret_cast<char*>(&settings.size), sizeof(double));
+    file.read(reinterpret_cast<char*>(&half_cells), sizeof(half_cells));
+    file.read(reinterpret_cast<char*>(&headings), sizeof(headings));
+    file.read(reinterpret_cast<char*>(&goal_headings), sizeof(goal_headings));
+    if (!file || half_cells < 0 || headings <= 0 || (goal_headings != headings && goal_headings * 4 != headings))
+        return nullptr;
+
+    table->half_cells_ = half_cells;
+    table->headings_ = headings;
+    table->goal_headings_ = goal_headings;
+    table->costs_.resize(static_cast<std::size_t>(2 * half_cells + 1) * static_cast<std::size_t>(2 * half_cells + 1) *
+                         static_cast<std::size_t>(headings) * static_cast<std::size_t>(goal_headings));
+    file.read(reinterpret_cast<char*>(table->costs_.data()),
+              static_cast<std::streamsize>(table->costs_.size() * sizeof(float)));
+    if (!file || file.peek() != std::char_traits<char>::eof())
+        return nullptr;
+
+    return table;
+}
+
+bool HeuristicTable::save(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    const int32_t half_cells = half_cells_;
+    const int32_t headings = headings_;
+    const int32_t goal_headings = goal_headings_;
+    file.write(MAGIC, sizeof(MAGIC));
+    file.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+    file.write(reinterpret_cast<const char*>(&settings_.linear_resolution), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&settings_.angular_resolution), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&settings_.backwards_mult), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&settings_.strafe_mult), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&settings_.rotation_mult), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&settings_.size), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&half_cells), sizeof(half_cells));
+    file.write(reinterpret_cast<const char*>(&headings), sizeof(headings));
+    file.write(reinterpret_cast<const char*>(&goal_headings), sizeof(goal_headings));
+    file.write(reinterpret_cast<const char*>(costs_.data()),
+               static_cast<std::streamsize>(costs_.size() * sizeof(float)));
+
+    return static_cast<bool>(file);
+}
+
+double HeuristicTable::costToGo(const State3D& state, const State3D& goal) const
+{
+    const double res = settings_.linear_resolution;
+    const double ang = settings_.angular_resolution;
+
+    // the search snaps states to the cells of the lattice, the goal can be anywhere in its cell
+    int x = static_cast<int>(std::round(state.x / res)) - static_cast<int>(std::round(goal.x / res));
+    int y = static_cast<int>(std::round(state.y / res)) - static_cast<int>(std::round(goal.y / res));
+    if (std::abs(x) > half_cells_ || std::abs(y) > half_cells_)
+        return distanceCost(settings_, x, y);
+
+    const int goal_heading = wrapHeading(static_cast<int>(std::round(goal.theta / ang)), headings_);
+    int heading = wrapHeading(static_cast<int>(std::round(state.theta / ang)), headings_);
+
+    // turn the state back by the quarters of the goal heading which are not stored
+    for (int i = 0; i < goal_heading / goal_headings_; ++i)
+    {
+        std::swap(x, y);
+        y = -y;
+        heading -= goal_headings_;
+    }
+
+    const float cost = costs_[index(goal_heading % goal_headings_, x, y, wrapHeading(heading, headings_))];
+    return cost < std::numeric_limits<float>::max() ? static_cast<double>(cost) : 0;
+}
+
+bool HeuristicTable::matches(const double linear_resolution, const double angular_resolution,
+                             const double backwards_mult, const double strafe_mult, const double rotation_mult) const
+{
+    auto equal = [](const double a, const double b) { return std::abs(a - b) < 1e-9; };
+    return equal(settings_.linear_resolution, linear_resolution) &&
+           equal(settings_.angular_resolution, angular_resolution) &&
+           equal(settings_.backwards_mult, backwards_mult) && equal(settings_.strafe_mult, strafe_mult) &&
+           equal(settings_.rotation_mult, rotation_mult);
+}
+
+}  // namespace astar_planner
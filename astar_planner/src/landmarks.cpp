@@ -0,0 +1,179 @@
+#include <astar_planner/astar.h>
+#include <astar_planner/landmarks.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace astar_planner
+{
+
+namespace
+{
+
+// Dijkstra over the moves and cell costs of shortestPath2D
+void costsFrom(const State2D& source, const int width, const int height, const std::vector<float>& cell_costs,
+               std::vector<double>& costs)
+{
+    costs.assign(cell_costs.size(), std::numeric_limits<double>::max());
+
+    using Entry = std::pair<double, std::size_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open_set;
+
+    const std::size_t source_index = static_cast<std::size_t>(source.y * width + source.x);
+    costs[source_index] = 0;
+    open_set.push({0, source_index});
+
+    while (!open_set.empty())
+    {
+        const Entry current = open_set.top();
+        open_set.pop();
+        if (current.first > costs[current.second])
+            continue;
+
+        const State2D state{static_cast<int>(current.second % static_cast<std::size_t>(width)),
+                            static_cast<int>(current.second / static_cast<std::size_t>(width))};
+        for (std::size_t i = 0; i < directions_2d.size(); ++i)
+        {
+            const State2D new_state = state + directions_2d[i];
+            if (new_state.x < 0 || new_state.x >= width || new_state.y < 0 || new_state.y >= height)
+                continue;
+
+            const std::size_t new_index = static_cast<std::size_t>(new_state.y * width + new_state.x);
+            if (!std::isfinite(cell_costs[new_index]))
+                continue;
+
+            const double cost = current.first + directions_2d_cost[i] * cell_costs[new_index];
+            if (cost < costs[new_index])
+            {
+                costs[new_index] = cost;
+                open_set.push({cost, new_index});
+            }
+        }
+    }
+}
+
+}  // namespace
+
+Landmarks::Landmarks(const CollisionChecker& collision_checker, const std::vector<State2D>& candidates,
+                     const std::size_t count)
+{
+    ROS_ASSERT(count > 0);
+
+    const Costmap& costmap = collision_checker.costmap();
+    width_ = costmap.width;
+    height_ = costmap.height;
+
+    std::vector<float> cell_costs;
+    cellCosts2D(collision_checker, cell_costs);
+
+    auto free = [&](const State2D& cell) {
+        return cell.x >= 0 && cell.x < width_ && cell.y >= 0 && cell.y < height_ &&
+               std::isfinite(cell_costs[costmap.to2DGridIndex(cell)]);
+    };
+
+    std::vector<State2D> remaining;
+    for (const State2D& cell : candidates)
+    {
+        if (free(cell))
+            remaining.push_back(cell);
+    }
+
+    // the free cell closest to the centre when there are no candidates
+    State2D next{-1, -1};
+    if (!remaining.empty())
+    {
+        next = remaining.front();
+        remaining.erase(remaining.begin());
+    }
+    else
+    {
+        const State2D centre{width_ / 2, height_ / 2};
+        int best = std::numeric_limits<int>::max();
+        for (int y = 0; y < height_; ++y)
+        {
+            for (int x = 0; x < width_; ++x)
+            {
+                const int d = (x - centre.x) * (x - centre.x) + (y - centre.y) * (y - centre.y);
+                if (d < best && free({x, y}))
+                {
+                    best = d;
+                    next = {x, y};
+                }
+            }
+        }
+    }
+
+    // landmark major until all are found
+    std::vector<std::vector<uint16_t>> fields;
+    std::vector<double> costs;
+    std::vector<double> closest(cell_costs.size(), std::numeric_limits<double>::max());
+    while (next.x >= 0 && cells_.size() < count)
+    {
+        cells_.push_back(next);
+        costsFrom(next, width_, height_, cell_costs, costs);
+
+        double max_cost = 0;
+        for (std::size_t i = 0; i < closest.size(); ++i)
+        {
+            closest[i] = std::min(closest[i], costs[i]);
+            if (costs[i] < std::numeric_limits<double>::max())
+                max_cost = std::max(max_cost, costs[i]);
+        }
+
+        const double step = max_cost > 0 ? max_cost / (UNREACHABLE - 1) : 1.0;
+        steps_.push_back(step);
+        fields.emplace_back(cell_costs.size());
+        for (std::size_t i = 0; i < cell_costs.size(); ++i)
+            fields.back()[i] =
+                costs[i] < std::numeric_limits<double>::max() ? static_cast<uint16_t>(costs[i] / step) : UNREACHABLE;
+
+        // the cell reachable from the landmarks which is farthest from all of them
+        next = {-1, -1};
+        double farthest = 0;
+        auto consider = [&](const State2D& cell) {
+            const double d = closest[costmap.to2DGridIndex(cell)];
+            if (d < std::numeric_limits<double>::max() && d > farthest)
+            {
+                farthest = d;
+                next = cell;
+            }
+        };
+
+        if (!remaining.empty())
+        {
+            for (const State2D& cell : remaining)
+                consider(cell);
+
+            // candidates which cannot be reached are dropped
+            remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                           [&](const State2D& cell) {
+                                               return cell == next || !(closest[costmap.to2DGridIndex(cell)] <
+                                                                        std::numeric_limits<double>::max());
+                                           }),
+                            remaining.end());
+        }
+
+        if (next.x < 0)
+        {
+            for (int y = 0; y < height_; ++y)
+            {
+                for (int x = 0; x < width_; ++x)
+                    consider({x, y});
+            }
+        }
+    }
+
+    const std::size_t landmarks = cells_.size();
+    distances_.resize(cell_costs.size() * landmarks);
+    for (std::size_t l = 0; l < landmarks; ++l)
+    {
+        for (std::size_t i = 0; i < cell_costs.size(); ++i)
+            distances_[i * landmarks + l] = fields[l][i];
+    }
+}
+
+}  // namespace astar_planner
@@ -0,0 +1,101 @@
+#include <astar_planner/motion_primitives.h>
+
+#include <ros/assert.h>
+
+#include <algorithm>
+
+namespace astar_planner
+{
+
+MotionPrimitives::MotionPrimitives(const double linear_resolution, const double angular_resolution,
+                                   const double map_resolution, const std::vector<Eigen::Vector2d>& offsets)
+    : linear_resolution_(linear_resolution), angular_resolution_(angular_resolution), map_resolution_(map_resolution),
+      offsets_(offsets)
+{
+    ROS_ASSERT(linear_resolution > 0);
+    ROS_ASSERT(angular_resolution > 0);
+    ROS_ASSERT(map_resolution > 0);
+
+    directions_ = {{
+        {linear_resolution, 0, 0},                    // forwards
+        {linear_resolution, 0, angular_resolution},   // forwards + rotate left
+        {linear_resolution, 0, -angular_resolution},  // forwards + rotate right
+        {-linear_resolution, 0, 0},                   // backwards
+        {0, linear_resolution, 0},                    // left
+        {0, -linear_resolution, 0},                   // right
+        {0, 0, angular_resolution},                   // rotate left
+        {0, 0, -angular_resolution}                   // rotate right
+    }};
+
+    // wrapped headings round to at most pi / angular_resolution
+    max_theta_index_ = static_cast<int>(std::ceil(M_PI / angular_resolution)) + 1;
+
+    const std::size_t bins = static_cast<std::size_t>(2 * max_theta_index_ + 1);
+    headings_.resize(bins);
+    footprints_.resize(bins);
+    sin_theta_.resize(bins);
+    cos_theta_.resize(bins);
+    for (int theta_index = -max_theta_index_; theta_index <= max_theta_index_; ++theta_index)
+    {
+        const std::size_t bin = static_cast<std::size_t>(theta_index + max_theta_index_);
+        const double theta = theta_index * angular_resolution_;
+
+        compute(theta, headings_[bin]);
+
+        const double st = std::sin(theta);
+        const double ct = std::cos(theta);
+        sin_theta_[bin] = st;
+        cos_theta_[bin] = ct;
+
+        footprints_[bin].reserve(offsets_.size());
+        for (const auto& offset : offsets_)
+            footprints_[bin].emplace_back(offset.x() * ct - offset.y() * st, offset.x() * st + offset.y() * ct);
+    }
+}
+
+const HeadingPrimitives& MotionPrimitives::successors(const double theta, HeadingPrimitives& scratch) const
+{
+    int theta_index;
+    if (onBin(theta, theta_index))
+        return headings_[static_cast<std::size_t>(theta_index + max_theta_index_)];
+
+    compute(theta, scratch);
+    return scratch;
+}
+
+void MotionPrimitives::compute(const double theta, HeadingPrimitives& heading) const
+{
+    const double s1 = std::abs(map_resolution_ / std::cos(theta));
+    const double s2 = std::abs(map_resolution_ / std::sin(theta));
+
+    for (std::size_t level = 0; level < NUM_RESOLUTION_LEVELS; ++level)
+    {
+        // I think this needs to be sqrt(2) = 1.4, use 1.5 to help rounding up
+        const double step_mult = 1.5 * resolutionMult(level) * std::min(s1, s2) / map_resolution_;
+        ROS_ASSERT(step_mult >= 1.0);
+
+        for (std::size_t i = 0; i < NUM_DIRECTIONS; ++i)
+        {
+            const ExploreDirection& direction = directions_[i];
+            MotionPrimitive& primitive = heading.primitives[level][i];
+
+            primitive.theta = theta;
+            if (std::abs(direction.rotation) > 0)
+                primitive.theta = wrapAngle(theta + direction.rotation);
+
+            primitive.dx = 0;
+            primitive.dy = 0;
+            if (std::abs(direction.x) > 0 || std::abs(direction.y) > 0)
+            {
+                const double st = std::sin(primitive.theta);
+                const double ct = std::cos(primitive.theta);
+                primitive.dx = step_mult * (direction.x * ct - direction.y * st);
+                primitive.dy = step_mult * (direction.x * st + direction.y * ct);
+            }
+
+            primitive.theta_index = static_cast<int>(std::round(primitive.theta / angular_resolution_));
+        }
+    }
+}
+
+}  // namespace astar_planner
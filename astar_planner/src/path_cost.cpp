@@ -0,0 +1,219 @@
+#include <astar_planner/astar.h>
+#include <astar_planner/path_cost.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+namespace astar_planner
+{
+
+namespace
+{
+
+std::size_t hashPoses(const Eigen::Isometry2d& from, const Eigen::Isometry2d& to)
+{
+    std::size_t seed = 0;
+    for (const Eigen::Isometry2d* pose : {&from, &to})
+    {
+        for (const double value :
+             {pose->translation().x(), pose->translation().y(), pose->linear()(0, 0), pose->linear()(1, 0)})
+            seed ^= std::hash<double>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+}  // namespace
+
+void segmentCosts(const navigation_interface::Path& path, const std::vector<std::size_t>& segments,
+                  const CollisionChecker& collision_checker, const double backwards_mult, const double strafe_mult,
+                  const double rotation_mult, std::vector<double>& costs)
+{
+    const Costmap& costmap = collision_checker.costmap();
+
+    ClearanceBatch batch;
+    std::vector<State3D> states;
+    states.reserve(segments.size());
+    for (const std::size_t i : segments)
+    {
+        ROS_ASSERT(i + 1 < path.nodes.size());
+
+        const Eigen::Isometry2d& node = path.nodes[i];
+        const double st = node.linear()(1, 0);
+        const double ct = node.linear()(0, 0);
+        states.push_back({node.translation().x(), node.translation().y(), std::atan2(st, ct)});
+        batch.add(states.back(), st, ct);
+    }
+
+    collision_checker.clearance(batch);
+
+    costs.resize(segments.size());
+    for (std::size_t n = 0; n < segments.size(); ++n)
+    {
+        const State3D& state = states[n];
+        if (!(batch.clearance[n] > 0.0) || collision_checker.inCSpaceCollision(state))
+        {
+            costs[n] = std::numeric_limits<double>::max();
+            continue;
+        }
+
+        // the move and the rotation to the next node in the frame of the node
+        const Eigen::Isometry2d& next = path.nodes[segments[n] + 1];
+        const double st = batch.sin_theta[n];
+        const double ct = batch.cos_theta[n];
+        const double trans_x = next.translation().x() - state.x;
+        const double trans_y = next.translation().y() - state.y;
+        const double dx = trans_x * ct + trans_y * st;
+        const double dy = -trans_x * st + trans_y * ct;
+
+        const double next_st = next.linear()(1, 0);
+        const double next_ct = next.linear()(0, 0);
+        const double rotation = std::atan2(next_st * ct - next_ct * st, next_ct * ct + next_st * st);
+
+        const double x_cost = std::abs((dx > 0) ? dx : backwards_mult * dx);
+        const double y_cost = std::abs(strafe_mult * dy);
+
+        const Eigen::Array2i map_cell = costmap.getCellIndex({state.x, state.y});
+        const double collision_cost = collisionCost(map_cell.x(), map_cell.y(), collision_checker);
+        const double traversal_cost = traversalCost(map_cell.x(), map_cell.y(), costmap);
+
+        const double rotation_collision_cost = rotationCollisionCost(batch.clearance[n] * costmap.resolution);
+
+        costs[n] = (x_cost + y_cost) * traversal_cost * collision_cost +
+                   std::abs(rotation) * rotation_mult * rotation_collision_cost;
+    }
+}
+
+double pathCost(const navigation_interface::Path& path, const CollisionChecker& collision_checker,
+                const double backwards_mult, const double strafe_mult, const double rotation_mult)
+{
+    if (path.nodes.size() < 2)
+        return 0.0;
+
+    std::vector<std::size_t> segments(path.nodes.size() - 1);
+    std::iota(segments.begin(), segments.end(), 0);
+
+    std::vector<double> costs;
+    segmentCosts(path, segments, collision_checker, backwards_mult, strafe_mult, rotation_mult, costs);
+
+    double cost = 0.0;
+    for (const double segment_cost : costs)
+    {
+        if (segment_cost == std::numeric_limits<double>::max())
+            return std::numeric_limits<double>::max();
+        cost += segment_cost;
+    }
+    return cost;
+}
+
+double PathCostCache::cost(const navigation_interface::Path& path, const CollisionChecker& collision_checker,
+                           const gridmap::MapData& map_data, const double backwards_mult, const double strafe_mult,
+                           const double rotation_mult)
+{
+    const Costmap& costmap = collision_checker.costmap();
+    const gridmap::OccupancyGrid& grid = map_data.grid;
+
+    ROS_ASSERT(grid.dimensions().size().x() == costmap.width && grid.dimensions().size().y() == costmap.height);
+
+    costed_ = 0;
+    if (path.nodes.size() < 2)
+    {
+        segments_.clear();
+        return 0.0;
+    }
+
+    const int tile_size = gridmap::OccupancyGrid::TILE_SIZE;
+    const int tiles_x = grid.tilesX();
+    const int tiles_y = grid.tilesY();
+    std::vector<uint64_t> tile_versions;
+    tile_versions.reserve(static_cast<std::size_t>(tiles_x * tiles_y));
+    {
+        // cppcheck-suppress unreadVariable
+        auto lock = grid.getLock();
+        for (int tile_y = 0; tile_y < tiles_y; ++tile_y)
+            for (int tile_x = 0; tile_x < tiles_x; ++tile_x)
+                tile_versions.push_back(grid.tileVersion(tile_x, tile_y));
+    }
+
+    auto newest_version = [&](const cv::Rect& region) {
+        uint64_t version = 0;
+        if (region.area() <= 0)
+            return version;
+        for (int tile_y = region.y / tile_size; tile_y <= (region.y + region.height - 1) / tile_size; ++tile_y)
+            for (int tile_x = region.x / tile_size; tile_x <= (region.x + region.width - 1) / tile_size; ++tile_x)
+                version = std::max(version, tile_versions[static_cast<std::size_t>(tile_y * tiles_x + tile_x)]);
+        return version;
+    };
+
+    // the cost of a segment depends on the grid within the reach of its first node
+    const int reach = costmap.reach(collision_checker.offsets());
+    const cv::Rect bounds(0, 0, costmap.width, costmap.height);
+
+    const std::size_t size = path.nodes.size() - 1;
+    std::vector<std::size_t> keys(size);
+    std::vector<Segment> segments(size);
+    std::vector<std::size_t> stale;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        const Eigen::Isometry2d& from = path.nodes[i];
+        const Eigen::Isometry2d& to = path.nodes[i + 1];
+        const Eigen::Array2i cell = costmap.getCellIndex(from.translation());
+        const cv::Rect region =
+            cv::Rect(cell.x() - reach, cell.y() - reach, 2 * reach + 1, 2 * reach + 1) & bounds;
+
+        keys[i] = hashPoses(from, to);
+        segments[i] = Segment{from, to, region, costmap.grid_version, 0.0};
+
+        bool found = false;
+        const auto range = segments_.equal_range(keys[i]);
+        for (auto it = range.first; it != range.second && !found; ++it)
+        {
+            const Segment& segment = it->second;
+            if (segment.from.matrix() == from.matrix() && segment.to.matrix() == to.matrix() &&
+                newest_version(region) <= segment.grid_version)
+            {
+                segments[i] = segment;
+                found = true;
+            }
+        }
+
+        if (!found)
+            stale.push_back(i);
+    }
+
+    std::vector<double> stale_costs;
+    segmentCosts(path, stale, collision_checker, backwards_mult, strafe_mult, rotation_mult, stale_costs);
+    for (std::size_t n = 0; n < stale.size(); ++n)
+        segments[stale[n]].cost = stale_costs[n];
+    costed_ = stale.size();
+
+    segments_.clear();
+    segments_.reserve(size);
+    double cost = 0.0;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        segments_.emplace(keys[i], segments[i]);
+        if (cost < std::numeric_limits<double>::max())
+            cost = segments[i].cost == std::numeric_limits<double>::max() ? segments[i].cost : cost + segments[i].cost;
+    }
+
+    return cost;
+}
+
+void PathCostCache::invalidate(const cv::Rect& region)
+{
+    if (region.area() <= 0)
+        return;
+
+    for (auto it = segments_.begin(); it != segments_.end();)
+    {
+        if ((it->second.region & region).area() > 0)
+            it = segments_.erase(it);
+        else
+            ++it;
+    }
+}
+
+}  // namespace astar_planner
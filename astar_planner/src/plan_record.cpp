@@ -0,0 +1,291 @@
+#include <astar_planner/plan_record.h>
+
+#include <ros/assert.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace astar_planner
+{
+
+namespace
+{
+
+const char MAGIC[8] = {'A', 'S', 'T', 'A', 'R', 'P', 'L', 'N'};
+const uint32_t VERSION = 3;
+
+static_assert(sizeof(PlanRecord::Settings) % 8 == 0, "PlanRecord::Settings must not need padding");
+
+template <typename T> void write(std::ofstream& file, const T& value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T> void read(std::ifstream& file, T& value)
+{
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+void writePose(std::ofstream& file, const Eigen::Isometry2d& pose)
+{
+    write(file, pose.translation().x());
+    write(file, pose.translation().y());
+    write(file, Eigen::Rotation2Dd(pose.linear()).smallestAngle());
+}
+
+Eigen::Isometry2d readPose(std::ifstream& file)
+{
+    double x = 0;
+    double y = 0;
+    double theta = 0;
+    read(file, x);
+    read(file, y);
+    read(file, theta);
+    return Eigen::Translation2d(x, y) * Eigen::Rotation2Dd(theta);
+}
+
+void writeMat(std::ofstream& file, const cv::Mat& mat)
+{
+    const int32_t rows = mat.rows;
+    const int32_t cols = mat.cols;
+    const int32_t type = mat.type();
+    write(file, rows);
+    write(file, cols);
+    write(file, type);
+    for (int y = 0; y < rows; ++y)
+        file.write(reinterpret_cast<const char*>(mat.ptr(y)), static_cast<std::streamsize>(cols * mat.elemSize()));
+}
+
+bool readMat(std::ifstream& file, const int expected_type, cv::Mat& mat)
+{
+    int32_t rows = 0;
+    int32_t cols = 0;
+    int32_t type = 0;
+    read(file, rows);
+    read(file, cols);
+    read(file, type);
+    if (!file || rows <= 0 || cols <= 0 || type != expected_type)
+        return false;
+
+    mat = cv::Mat(rows, cols, type);
+    for (int y = 0; y < rows; ++y)
+        file.read(reinterpret_cast<char*>(mat.ptr(y)), static_cast<std::streamsize>(cols * mat.elemSize()));
+    return static_cast<bool>(file);
+}
+
+}  // namespace
+
+std::shared_ptr<PlanRecord> PlanRecord::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return nullptr;
+
+    char magic[8];
+    uint32_t version;
+    file.read(magic, sizeof(magic));
+    read(file, version);
+    if (!file || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION)
+        return nullptr;
+
+    auto record = std::make_shared<PlanRecord>();
+    read(file, record->settings);
+
+    uint32_t offsets = 0;
+    read(file, offsets);
+    if (!file || offsets > 1024)
+        return nullptr;
+    record->offsets.resize(offsets);
+    for (Eigen::Vector2d& offset : record->offsets)
+    {
+        read(file, offset.x());
+        read(file, offset.y());
+    }
+
+    uint32_t table_length = 0;
+    read(file, table_length);
+    if (!file || table_length > 4096)
+        return nullptr;
+    record->heuristic_table.resize(table_length);
+    file.read(&record->heuristic_table[0], table_length);
+
+    record->start = readPose(file);
+    uint32_t goals = 0;
+    read(file, goals);
+    if (!file || goals == 0 || goals > 1024)
+        return nullptr;
+    for (uint32_t i = 0; i < goals; ++i)
+        record->goals.push_back(readPose(file));
+
+    read(file, record->resolution);
+    read(file, record->origin_x);
+    read(file, record->origin_y);
+    if (!readMat(file, CV_8U, record->obstacle_map) || !readMat(file, CV_32F, record->traversal_cost) ||
+        record->obstacle_map.size() != record->traversal_cost.size())
+        return nullptr;
+
+    read(file, record->duration);
+    read(file, record->iterations);
+    read(file, record->success);
+    if (!file || file.peek() != std::char_traits<char>::eof())
+        return nullptr;
+
+    return record;
+}
+
+bool PlanRecord::save(const std::string& path) const
+{
+    ROS_ASSERT(!goals.empty());
+    ROS_ASSERT(obstacle_map.type() == CV_8U && traversal_cost.type() == CV_32F);
+    ROS_ASSERT(obstacle_map.size() == traversal_cost.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+
+    file.write(MAGIC, sizeof(MAGIC));
+    write(file, VERSION);
+    write(file, settings);
+
+    write(file, static_cast<uint32_t>(offsets.size()));
+    for (const Eigen::Vector2d& offset : offsets)
+    {
+        write(file, offset.x());
+        write(file, offset.y());
+    }
+
+    write(file, static_cast<uint32_t>(heuristic_table.size()));
+    file.write(heuristic_table.data(), static_cast<std::streamsize>(heuristic_table.size()));
+
+    writePose(file, start);
+    write(file, static_cast<uint32_t>(goals.size()));
+    for (const Eigen::Isometry2d& goal : goals)
+        writePose(file, goal);
+
+    write(file, resolution);
+    write(file, origin_x);
+    write(file, origin_y);
+    writeMat(file, obstacle_map);
+    writeMat(file, traversal_cost);
+
+    write(file, duration);
+    write(file, iterations);
+    write(file, success);
+
+    return static_cast<bool>(file);
+}
+
+void PlanRecord::setRegion(const Costmap& costmap, const cv::Rect& region)
+{
+    ROS_ASSERT(costmap.traversal_cost);
+    ROS_ASSERT(region.area() > 0 && (region & cv::Rect(0, 0, costmap.width, costmap.height)) == region);
+
+    resolution = costmap.resolution;
+    origin_x = costmap.origin_x + region.x * costmap.resolution;
+    origin_y = costmap.origin_y + region.y * costmap.resolution;
+    obstacle_map = costmap.obstacle_map(region).clone();
+    traversal_cost = (*costmap.traversal_cost)(region).clone();
+}
+
+std::shared_ptr<Costmap> PlanRecord::costmap() const
+{
+    auto costmap = std::make_shared<Costmap>(obstacle_map, resolution, origin_x, origin_y, settings.robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(traversal_cost);
+    costmap->min_traversal_cost = settings.min_traversal_cost;
+    if (settings.packed_cells)
+        costmap->buildCells();
+    return costmap;
+}
+
+PathResult PlanRecord::replay(const Costmap& costmap, const std::shared_ptr<const CSpace>& cspace,
+                              const std::shared_ptr<const HeuristicTable>& table,
+                              const std::shared_ptr<ThreadPool>& thread_pool) const
+{
+    const CollisionChecker collision_checker(costmap, offsets, settings.conservative_robot_radius, cspace);
+    const auto primitives = std::make_shared<const MotionPrimitives>(settings.linear_resolution,
+                                                                     settings.angular_resolution, costmap.resolution,
+                                                                     offsets);
+    const navigation_interface::PathPlanner::GoalSampleSettings sample = {
+        settings.sample_std_x, settings.sample_std_y, settings.sample_std_w,
+        static_cast<std::size_t>(settings.sample_max_samples)};
+
+    AnalyticExpansionSettings analytic_expansion;
+    analytic_expansion.interval = static_cast<std::size_t>(settings.analytic_expansion_interval);
+    analytic_expansion.heuristic_threshold = settings.analytic_expansion_threshold;
+    analytic_expansion.cost_tolerance = settings.analytic_expansion_cost_tolerance;
+
+    SearchOptions options;
+    options.explore_cache = std::make_shared<Explore2DCache>();
+    options.heuristic_mode = static_cast<HeuristicMode>(settings.heuristic_mode);
+    options.motion_primitives = primitives;
+    options.thread_pool = thread_pool;
+    options.analytic_expansion = analytic_expansion;
+    options.lazy_evaluation = settings.lazy_evaluation;
+    options.heuristic_table = table;
+
+    const std::size_t max_iterations = static_cast<std::size_t>(settings.max_iterations);
+
+    if (settings.anytime)
+    {
+        AnytimeSettings anytime;
+        anytime.initial_weight = settings.anytime_initial_weight;
+        anytime.weight_step = settings.anytime_weight_step;
+        anytime.first_max_iterations = static_cast<std::size_t>(settings.anytime_first_max_iterations);
+        const auto deadline = std::chrono::steady_clock::now() +
+                              std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                  std::chrono::duration<double>(settings.anytime_budget));
+        return anytimeHybridAStar(start, goals, deadline, anytime, max_iterations, collision_checker,
+                                  settings.linear_resolution, settings.angular_resolution, sample,
+                                  settings.backwards_mult, settings.strafe_mult, settings.rotation_mult, options);
+    }
+
+    return hybridAStar(start, goals, max_iterations, collision_checker, settings.linear_resolution,
+                       settings.angular_resolution, sample, settings.backwards_mult, settings.strafe_mult,
+                       settings.rotation_mult, options);
+}
+
+cv::Rect searchedRegion(const PathResult& result, const Costmap& costmap, const std::vector<Eigen::Vector2d>& offsets)
+{
+    int min_x = std::numeric_limits<int>::max();
+    int min_y = std::numeric_limits<int>::max();
+    int max_x = std::numeric_limits<int>::min();
+    int max_y = std::numeric_limits<int>::min();
+    auto extend = [&](const int x, const int y) {
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+    };
+    auto extendState = [&](const State3D& state) {
+        const Eigen::Array2i cell = costmap.getCellIndex({state.x, state.y});
+        extend(cell.x(), cell.y());
+    };
+
+    const Eigen::Array2i start_cell = costmap.getCellIndex(result.start.translation());
+    extend(start_cell.x(), start_cell.y());
+    for (const auto& node : result.explore_3d)
+    {
+        if (node.second->cost_so_far < std::numeric_limits<double>::max())
+            extendState(node.second->state);
+    }
+    for (const Node3D* node : result.path)
+        extendState(node->state);
+
+    const Explore2DCache* explore_cache = result.explore_cache.get();
+    if (explore_cache && explore_cache->width() == costmap.width && explore_cache->height() == costmap.height)
+    {
+        for (int y = 0; y < costmap.height; ++y)
+            for (int x = 0; x < costmap.width; ++x)
+                if (explore_cache->find(costmap.to2DGridIndex({x, y})))
+                    extend(x, y);
+    }
+
+    const int reach = costmap.reach(offsets);
+    return cv::Rect(min_x - reach, min_y - reach, max_x - min_x + 1 + 2 * reach, max_y - min_y + 1 + 2 * reach) &
+           cv::Rect(0, 0, costmap.width, costmap.height);
+}
+}  // namespace astar_planner
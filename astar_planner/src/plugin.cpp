@@ -1,10 +1,11 @@
 #include <Eigen/Geometry>
 
 #include <astar_planner/astar.h>
+#include <astar_planner/corridor.h>
+#include <astar_planner/parallel.h>
+#include <astar_planner/plan_record.h>
 #include <astar_planner/plugin.h>
 #include <astar_planner/visualisation.h>
-#include <gridmap/operations/rasterize.h>
-#include <gridmap/operations/raytrace.h>
 #include <nav_msgs/OccupancyGrid.h>
 #include <navigation_interface/params.h>
 #include <opencv2/highgui.hpp>
@@ -12,6 +13,7 @@
 #include <pluginlib/class_list_macros.h>
 #include <visualization_msgs/MarkerArray.h>
 
+#include <algorithm>
 #include <chrono>
 
 PLUGINLIB_EXPORT_CLASS(astar_planner::AStarPlanner, navigation_interface::PathPlanner)
@@ -22,41 +24,45 @@ namespace astar_planner
 namespace
 {
 
-double pathCost(const navigation_interface::Path& path, const astar_planner::CollisionChecker& collision_checker,
-                const double backwards_mult, const double strafe_mult, const double rotation_mult)
-{
-    double cost = 0.0;
-    for (std::size_t i = 0; i < path.nodes.size() - 1; ++i)
-    {
-        const State3D state{path.nodes[i].translation().x(), path.nodes[i].translation().y(),
-                            Eigen::Rotation2Dd(path.nodes[i].linear()).smallestAngle()};
-        if (!collision_checker.isValid(state))
-            return std::numeric_limits<double>::max();
-
-        const Eigen::Vector2d dir = path.nodes[i + 1].translation() - path.nodes[i].translation();
-        const Eigen::Vector2d dir_wrt_robot = path.nodes[i].linear().inverse() * dir;
-        const Eigen::Rotation2Dd rotation(path.nodes[i].linear().inverse() * path.nodes[i + 1].linear());
+const double LINEAR_RESOLUTION = 0.04;
+const double ANGULAR_RESOLUTION = M_PI / 16;
 
-        const double x_cost = std::abs((dir_wrt_robot[0] > 0) ? dir_wrt_robot[0] : backwards_mult * dir_wrt_robot[0]);
-        const double y_cost = std::abs(strafe_mult * dir_wrt_robot[1]);
+// iterations of a single search and of an anytime search, whose first search is bounded like a single search
+const std::size_t MAX_ITERATIONS = 3e5;
+const std::size_t ANYTIME_MAX_ITERATIONS = 2e6;
 
-        const Eigen::Array2i map_point = collision_checker.costmap().getCellIndex(path.nodes[i].translation());
-
-        const double collision_cost = collisionCost(map_point.x(), map_point.y(), collision_checker);
-        const double traversal_cost = traversalCost(map_point.x(), map_point.y(), collision_checker.costmap());
+navigation_interface::PathPlanner::Result toResult(const Eigen::Isometry2d& start,
+                                                   const astar_planner::PathResult& astar_result)
+{
+    navigation_interface::PathPlanner::Result result;
+    if (astar_result.success)
+    {
+        result.path.nodes.push_back(start);
 
-        const double d_to_collision_m = collision_checker.clearance(state) * collision_checker.costmap().resolution;
-        const double rotation_collision_cost = rotationCollisionCost(d_to_collision_m);
+        for (auto r_it = astar_result.path.crbegin(); r_it != astar_result.path.crend(); ++r_it)
+        {
+            const Eigen::Isometry2d p =
+                Eigen::Translation2d((*r_it)->state.x, (*r_it)->state.y) * Eigen::Rotation2Dd((*r_it)->state.theta);
+            result.path.nodes.push_back(p);
+        }
 
-        cost += (x_cost + y_cost) * traversal_cost * collision_cost;
-        cost += std::abs(rotation.smallestAngle()) * rotation_mult * rotation_collision_cost;
+        result.cost = astar_result.path.front()->cost_so_far;
+        result.outcome = navigation_interface::PathPlanner::Outcome::SUCCESSFUL;
+    }
+    else
+    {
+        result.outcome = navigation_interface::PathPlanner::Outcome::FAILED;
     }
-    return cost;
+    return result;
 }
+
 }  // namespace
 
 AStarPlanner::AStarPlanner()
+    : explore_cache_(std::make_shared<Explore2DCache>()), corridor_explore_cache_(std::make_shared<Explore2DCache>())
 {
+    // updateCostmap reports the changes of the costmap to the cache
+    explore_cache_->track_changes = true;
 }
 
 AStarPlanner::~AStarPlanner()
@@ -66,59 +72,293 @@ AStarPlanner::~AStarPlanner()
 navigation_interface::PathPlanner::Result  // cppcheck-suppress unusedFunction
     AStarPlanner::plan(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal, const GoalSampleSettings& sample)
 {
-    navigation_interface::PathPlanner::Result result;
+    return plan(start, {goal}, sample, nullptr);
+}
 
+navigation_interface::PathPlanner::Result  // cppcheck-suppress unusedFunction
+    AStarPlanner::plan(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal, const GoalSampleSettings& sample,
+                       const std::chrono::steady_clock::time_point& deadline)
+{
+    return plan(start, {goal}, sample, &deadline);
+}
+
+navigation_interface::PathPlanner::Result  // cppcheck-suppress unusedFunction
+    AStarPlanner::plan(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                       const GoalSampleSettings& sample)
+{
+    return plan(start, goals, sample, nullptr);
+}
+
+navigation_interface::PathPlanner::Result  // cppcheck-suppress unusedFunction
+    AStarPlanner::plan(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                       const GoalSampleSettings& sample, const std::chrono::steady_clock::time_point& deadline)
+{
+    return plan(start, goals, sample, &deadline);
+}
+
+navigation_interface::PathPlanner::Result AStarPlanner::plan(const Eigen::Isometry2d& start,
+                                                             const std::vector<Eigen::Isometry2d>& goals,
+                                                             const GoalSampleSettings& sample,
+                                                             const std::chrono::steady_clock::time_point* deadline)
+{
+    navigation_interface::PathPlanner::Result result;
+    if (goals.empty())
     {
-        // cppcheck-suppress unreadVariable
-        auto lock = map_data_->grid.getLock();
-        costmap_ = std::make_shared<Costmap>(*map_data_, robot_radius_);
+        result.outcome = navigation_interface::PathPlanner::Outcome::FAILED;
+        return result;
     }
 
-    // clear the robot footprint
-    const int radius_px = static_cast<int>(robot_radius_ / costmap_->resolution);
-    for (const auto& offset : offsets_)
+    const size_t max_iterations = MAX_ITERATIONS;
+    const size_t anytime_max_iterations = ANYTIME_MAX_ITERATIONS;
+    const double linear_resolution = LINEAR_RESOLUTION;
+    const double angular_resolution = ANGULAR_RESOLUTION;
+
+    const gridmap::MapDimensions& dimensions = map_data_->grid.dimensions();
+
+    // the primitives only depend on the resolutions and the robot offsets
+    if (!motion_primitives_ || motion_primitives_->mapResolution() != dimensions.resolution())
     {
-        const Eigen::Vector2d p = start * offset;
-        const Eigen::Array2i map_cell = costmap_->getCellIndex({p.x(), p.y()});
-        cv::circle(costmap_->obstacle_map, cv::Point(map_cell.x(), map_cell.y()), radius_px, cv::Scalar(0), -1);
+        motion_primitives_ = std::make_shared<const MotionPrimitives>(linear_resolution, angular_resolution,
+                                                                      dimensions.resolution(), offsets_);
     }
 
-    costmap_->processObstacleMap();
+    // the landmarks are used from the first plan after they are ready
+    if (landmarks_future_.valid() && landmarks_future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        std::atomic_store(&map_landmarks_, landmarks_future_.get());
+    explore_cache_->landmarks = map_landmarks_;
+    corridor_explore_cache_->landmarks = map_landmarks_;
 
-    ROS_ASSERT(traversal_cost_);
-    costmap_->traversal_cost = traversal_cost_;
-    const astar_planner::CollisionChecker collision_checker(*costmap_, offsets_, conservative_robot_radius_);
+    const auto t0 = std::chrono::steady_clock::now();
 
-    const size_t max_iterations = 3e5;
-    const double linear_resolution = 0.04;
-    const double angular_resolution = M_PI / 16;
+    // with a deadline the time is the budget, the iterations only bound the memory
+    SearchOptions options;
+    options.heuristic_mode = heuristic_mode_;
+    options.motion_primitives = motion_primitives_;
+    options.thread_pool = thread_pool_;
+    options.analytic_expansion = analytic_expansion_;
+    options.lazy_evaluation = lazy_evaluation_;
+    options.heuristic_table = heuristic_table_;
+    auto search = [&](const CollisionChecker& checker, const std::shared_ptr<Explore2DCache>& cache,
+                      const std::chrono::steady_clock::time_point* search_deadline) {
+        options.explore_cache = cache;
+        return search_deadline
+                   ? astar_planner::anytimeHybridAStar(start, goals, *search_deadline, anytime_, anytime_max_iterations,
+                                                       checker, linear_resolution, angular_resolution, sample,
+                                                       backwards_mult_, strafe_mult_, rotation_mult_, options)
+                   : astar_planner::hybridAStar(start, goals, max_iterations, checker, linear_resolution,
+                                                angular_resolution, sample, backwards_mult_, strafe_mult_,
+                                                rotation_mult_, options);
+    };
+
+    astar_planner::PathResult astar_result;
+
+    // the costmap astar_result was searched on
+    std::shared_ptr<const Costmap> searched_costmap;
+
+    // a path found within the region whose search reached the edge of the region, used if the search after it fails
+    astar_planner::PathResult region_path;
+    std::shared_ptr<const Costmap> region_path_costmap;
+
+    // short plans are first searched on a costmap of the region around start and goals only, a search which reaches
+    // the edge of the region is repeated on the whole map, whose costmap and 2D search are kept between plans
+    // the region has configuration space layers of its own, and a 2D search of its own as its cells are indexed from
+    // its corner
+    Eigen::AlignedBox2d box(start.translation());
+    for (const Eigen::Isometry2d& goal : goals)
+        box.extend(goal.translation());
+    if (roi_max_distance_ > 0 && box.sizes().maxCoeff() <= roi_max_distance_)
+    {
+        const cv::Rect bounds(0, 0, dimensions.size().x(), dimensions.size().y());
+        const int reach = Costmap::reach(dimensions.resolution(), robot_radius_, offsets_);
+        const double margin = std::max(roi_margin_, box.sizes().maxCoeff());
+        const Eigen::Array2i min_cell = dimensions.getCellIndex(box.min() - Eigen::Vector2d::Constant(margin));
+        const Eigen::Array2i max_cell = dimensions.getCellIndex(box.max() + Eigen::Vector2d::Constant(margin));
+        const cv::Rect region =
+            cv::Rect(cv::Point(min_cell.x(), min_cell.y()), cv::Point(max_cell.x() + 1, max_cell.y() + 1)) & bounds;
+
+        // the distances within the region also depend on the obstacles within reach of it
+        const cv::Rect padded =
+            cv::Rect(region.x - reach, region.y - reach, region.width + 2 * reach, region.height + 2 * reach) & bounds;
+        if (padded != bounds && region.area() > 0)
+        {
+            std::shared_ptr<Costmap> costmap;
+            {
+                // cppcheck-suppress unreadVariable
+                auto lock = map_data_->grid.getLock();
+                costmap = std::make_shared<Costmap>(*map_data_, robot_radius_, padded);
+            }
+            costmap->clearFootprint(start, offsets_);
+            costmap->processObstacleMap();
+            costmap->traversal_cost = std::make_shared<cv::Mat>((*traversal_cost_)(padded));
+            costmap->min_traversal_cost = min_traversal_cost_;
+            if (packed_cells_)
+                costmap->buildCells();
+            auto cspace = std::make_shared<CSpace>(ANGULAR_RESOLUTION, offsets_);
+            cspace->build(*costmap);
+
+            // the region gets half of the time so the whole map still gets some
+            const auto region_start = std::chrono::steady_clock::now();
+            const std::chrono::steady_clock::time_point region_deadline =
+                deadline ? region_start + (*deadline - region_start) / 2 : region_start;
+
+            const CollisionChecker region_checker(*costmap, offsets_, conservative_robot_radius_, cspace);
+            astar_planner::PathResult region_result =
+                search(region_checker, nullptr, deadline ? &region_deadline : nullptr);
+
+            // nodes may reach the sides of the region at the edge of the map, there is nothing beyond them
+            const cv::Point tl(padded.x == 0 ? 0 : region.x - padded.x, padded.y == 0 ? 0 : region.y - padded.y);
+            const cv::Point br(padded.br().x == bounds.width ? padded.width : region.br().x - padded.x,
+                               padded.br().y == bounds.height ? padded.height : region.br().y - padded.y);
+            const cv::Rect inside(tl, br);
+
+            if (!region_result.out_of_time && searchedWithin(region_result, *costmap, inside))
+            {
+                // the cells beyond the region would not have changed the result, whether a path was found or not
+                astar_result = std::move(region_result);
+                searched_costmap = costmap;
+            }
+            else
+            {
+                // a path within the region is valid, a cheaper one may leave it
+                const bool path_inside =
+                    std::all_of(region_result.path.begin(), region_result.path.end(), [&](const Node3D* node) {
+                        const Eigen::Array2i cell = costmap->getCellIndex({node->state.x, node->state.y});
+                        return inside.contains(cv::Point(cell.x(), cell.y()));
+                    });
+                if (region_result.success && path_inside)
+                {
+                    region_path = std::move(region_result);
+                    region_path_costmap = costmap;
+                }
+            }
 
-    const auto t0 = std::chrono::steady_clock::now();
+            ROS_INFO_STREAM("Searched a region, result found within it: " << static_cast<bool>(searched_costmap));
+        }
+    }
 
-    const astar_planner::PathResult astar_result =
-        astar_planner::hybridAStar(start, goal, max_iterations, collision_checker, linear_resolution,
-                                   angular_resolution, sample, backwards_mult_, strafe_mult_, rotation_mult_);
+    // cost() and valid() may update costmap_ as well, it is held until the searched costmap is no longer used
+    std::unique_lock<std::mutex> costmap_lock(costmap_mutex_, std::defer_lock);
+    if (!searched_costmap)
+    {
+        costmap_lock.lock();
+        updateCostmap(start);
+        searched_costmap = costmap_;
+
+        const astar_planner::CollisionChecker collision_checker(*costmap_, offsets_, conservative_robot_radius_,
+                                                                cspace_);
+
+        // long routes are first searched within a corridor around a path found on a coarse level of the map
+        // a corridor leads to a single goal, several goals are searched on the whole map
+        astar_result = astar_planner::PathResult();
+        const Eigen::Isometry2d& goal = goals.front();
+        const Eigen::Array2i start_cell = costmap_->getCellIndex(start.translation());
+        const Eigen::Array2i goal_cell = costmap_->getCellIndex(goal.translation());
+        if (corridor_level_ > 0 && goals.size() == 1 &&
+            (goal.translation() - start.translation()).norm() > corridor_min_distance_ && start_cell.x() >= 0 &&
+            start_cell.x() < costmap_->width && start_cell.y() >= 0 && start_cell.y() < costmap_->height &&
+            goal_cell.x() >= 0 && goal_cell.x() < costmap_->width && goal_cell.y() >= 0 &&
+            goal_cell.y() < costmap_->height)
+        {
+            const OccupancyPyramid pyramid(collision_checker, corridor_level_ + 1);
+            const Corridor corridor =
+                findCorridor(pyramid, {start_cell.x(), start_cell.y()}, {goal_cell.x(), goal_cell.y()},
+                             corridor_level_, static_cast<int>(std::ceil(corridor_margin_ / costmap_->resolution)));
+            if (corridor.success)
+            {
+                // the corridor moves with every plan, so its cache is compared with the whole map instead of tracking
+                // the changed regions
+                const Costmap corridor_costmap = restrictToCorridor(*costmap_, corridor.mask);
+                const CollisionChecker corridor_checker(corridor_costmap, offsets_, conservative_robot_radius_,
+                                                        cspace_);
+                astar_result = search(corridor_checker, corridor_explore_cache_, deadline);
+
+                ROS_INFO_STREAM("Corridor on level " << corridor.level << " took " << corridor.iterations
+                                                     << " iterations, path found within it: "
+                                                     << astar_result.success);
+            }
+        }
+
+        if (!astar_result.success)
+            astar_result = search(collision_checker, explore_cache_, deadline);
 
+        // e.g. out of iterations, the path found within a smaller region is better than none
+        if (!astar_result.success && region_path.success)
+        {
+            astar_result = std::move(region_path);
+            searched_costmap = region_path_costmap;
+        }
+    }
+
+    const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
     ROS_INFO_STREAM(
-        "Hybrid A Star took "
-        << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0).count()
-        << " iterations: " << astar_result.iterations << " nodes: " << astar_result.explore_3d.size());
+        "Hybrid A Star took " << duration << " iterations: " << astar_result.iterations
+        << " nodes: " << astar_result.explore_3d.size()
+        << " searches: " << astar_result.searches << " weight: " << astar_result.weight
+        << " collision checks: " << astar_result.collision_checks
+        << " skipped: " << astar_result.collision_checks_saved);
+
+    if (!record_plans_.empty() && duration > record_threshold_)
+    {
+        PlanRecord record;
+        record.settings.linear_resolution = linear_resolution;
+        record.settings.angular_resolution = angular_resolution;
+        record.settings.robot_radius = robot_radius_;
+        record.settings.conservative_robot_radius = conservative_robot_radius_;
+        record.settings.backwards_mult = backwards_mult_;
+        record.settings.strafe_mult = strafe_mult_;
+        record.settings.rotation_mult = rotation_mult_;
+        record.settings.analytic_expansion_threshold = analytic_expansion_.heuristic_threshold;
+        record.settings.analytic_expansion_cost_tolerance = analytic_expansion_.cost_tolerance;
+        record.settings.anytime_initial_weight = anytime_.initial_weight;
+        record.settings.anytime_weight_step = anytime_.weight_step;
+        record.settings.anytime_budget = deadline ? std::chrono::duration<double>(*deadline - t0).count() : 0.0;
+        record.settings.min_traversal_cost = searched_costmap->min_traversal_cost;
+        record.settings.sample_std_x = sample.std_x;
+        record.settings.sample_std_y = sample.std_y;
+        record.settings.sample_std_w = sample.std_w;
+        record.settings.sample_max_samples = sample.max_samples;
+        record.settings.max_iterations = deadline ? anytime_max_iterations : max_iterations;
+        record.settings.anytime_first_max_iterations = anytime_.first_max_iterations;
+        record.settings.analytic_expansion_interval = analytic_expansion_.interval;
+        record.settings.heuristic_mode = static_cast<int32_t>(heuristic_mode_);
+        record.settings.threads = threads_;
+        record.settings.lazy_evaluation = lazy_evaluation_;
+        record.settings.packed_cells = packed_cells_;
+        record.settings.anytime = deadline != nullptr;
+        record.settings.reserved = 0;
+        record.offsets = offsets_;
+        record.heuristic_table = heuristic_table_file_;
+        record.start = start;
+        record.goals = goals;
+        record.setRegion(*searched_costmap, searchedRegion(astar_result, *searched_costmap, offsets_));
+        record.duration = duration;
+        record.iterations = astar_result.iterations;
+        record.success = astar_result.success;
+
+        const auto stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+        const std::string path = record_plans_ + "/plan_" + std::to_string(stamp.count()) + ".astar_plan";
+        if (record.save(path))
+            ROS_INFO_STREAM("Recorded slow plan to " << path);
+        else
+            ROS_WARN_STREAM("Failed to record slow plan to " << path);
+    }
 
     if (debug_viz_)
     {
         if (explore_pub_.getNumSubscribers() > 0)
         {
-            cv::Mat disp = astar_planner::visualise(*costmap_, astar_result);
+            cv::Mat disp = astar_planner::visualise(*searched_costmap, astar_result);
             cv::cvtColor(disp, disp, cv::COLOR_BGR2GRAY);
 
             nav_msgs::OccupancyGrid og;
             og.header.stamp = ros::Time::now();
-            og.info.resolution = costmap_->resolution;
-            og.info.width = costmap_->width;
-            og.info.height = costmap_->height;
+            og.info.resolution = searched_costmap->resolution;
+            og.info.width = searched_costmap->width;
+            og.info.height = searched_costmap->height;
             og.data.resize(static_cast<size_t>(og.info.width * og.info.height));
-            og.info.origin.position.x = costmap_->origin_x;
-            og.info.origin.position.y = costmap_->origin_y;
+            og.info.origin.position.x = searched_costmap->origin_x;
+            og.info.origin.position.y = searched_costmap->origin_y;
             og.info.origin.orientation.w = 1.0;
 
             unsigned char* input = (unsigned char*)(disp.data);
@@ -128,54 +368,224 @@ navigation_interface::PathPlanner::Result  // cppcheck-suppress unusedFunction
         }
     }
 
-    if (astar_result.success)
-    {
-        result.path.nodes.push_back(start);
-
-        for (auto r_it = astar_result.path.crbegin(); r_it != astar_result.path.crend(); ++r_it)
-        {
-            const Eigen::Isometry2d p =
-                Eigen::Translation2d((*r_it)->state.x, (*r_it)->state.y) * Eigen::Rotation2Dd((*r_it)->state.theta);
-            result.path.nodes.push_back(p);
-        }
-
-        result.cost = astar_result.path.front()->cost_so_far;
-        result.outcome = navigation_interface::PathPlanner::Outcome::SUCCESSFUL;
-    }
-    else
+    if (!astar_result.success)
     {
         if (astar_result.start_in_collision)
             ROS_WARN("Start in collision!");
         if (astar_result.goal_in_collision)
             ROS_WARN("Goal in collision!");
-        result.outcome = navigation_interface::PathPlanner::Outcome::FAILED;
     }
-    return result;
+    return toResult(start, astar_result);
+}
+
+std::vector<AStarPlanner::BatchResult>
+    AStarPlanner::planBatch(const std::vector<std::pair<Eigen::Isometry2d, Eigen::Isometry2d>>& requests,
+                            const GoalSampleSettings& sample)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::shared_ptr<const BatchSnapshot> snapshot;
+    {
+        std::shared_ptr<const gridmap::MapData> map_data;
+        std::shared_ptr<cv::Mat> traversal_cost;
+        double min_traversal_cost;
+        BatchSettings settings;
+        {
+            // the settings are those of one call of onInitialize, which holds mutex_ as well
+            std::lock_guard<std::mutex> lock(mutex_);
+            map_data = map_data_;
+            traversal_cost = traversal_cost_;
+            min_traversal_cost = min_traversal_cost_;
+
+            settings.version = settings_version_;
+            settings.robot_radius = robot_radius_;
+            settings.conservative_robot_radius = conservative_robot_radius_;
+            settings.offsets = offsets_;
+            settings.backwards_mult = backwards_mult_;
+            settings.strafe_mult = strafe_mult_;
+            settings.rotation_mult = rotation_mult_;
+            settings.packed_cells = packed_cells_;
+            settings.lazy_evaluation = lazy_evaluation_;
+            settings.analytic_expansion = analytic_expansion_;
+            settings.heuristic_table = heuristic_table_;
+        }
+        ROS_ASSERT(map_data && traversal_cost);
+
+        // one batch builds the snapshot while the others wait for it
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        bool stale = !batch_snapshot_ || batch_snapshot_->map_data != map_data ||
+                     batch_snapshot_->costmap->traversal_cost != traversal_cost ||
+                     batch_snapshot_->settings.version != settings.version;
+        std::shared_ptr<Costmap> costmap;
+        {
+            // cppcheck-suppress unreadVariable
+            auto lock = map_data->grid.getLock();
+            stale = stale || map_data->grid.version() != batch_snapshot_->costmap->grid_version;
+            if (stale)
+                costmap = std::make_shared<Costmap>(*map_data, settings.robot_radius);
+        }
+
+        if (stale)
+        {
+            costmap->processObstacleMap();
+            costmap->traversal_cost = traversal_cost;
+            costmap->min_traversal_cost = min_traversal_cost;
+            if (settings.packed_cells)
+                costmap->buildCells();
+
+            auto cspace = std::make_shared<CSpace>(ANGULAR_RESOLUTION, settings.offsets);
+            cspace->build(*costmap);
+
+            auto primitives = std::make_shared<const MotionPrimitives>(LINEAR_RESOLUTION, ANGULAR_RESOLUTION,
+                                                                       costmap->resolution, settings.offsets);
+
+            batch_snapshot_ = std::make_shared<const BatchSnapshot>(
+                BatchSnapshot{map_data, costmap, cspace, primitives, std::move(settings)});
+        }
+        snapshot = batch_snapshot_;
+    }
+
+    const auto t1 = std::chrono::steady_clock::now();
+
+    // every search grows a 2D search of its own and only reads the snapshot
+    const std::shared_ptr<const Landmarks> landmarks = std::atomic_load(&map_landmarks_);
+    const BatchSettings& settings = snapshot->settings;
+    const CollisionChecker collision_checker(*snapshot->costmap, settings.offsets, settings.conservative_robot_radius,
+                                             snapshot->cspace);
+    std::vector<BatchResult> results(requests.size());
+    parallelFor(static_cast<int>(requests.size()), [&](const int i) {
+        const auto start_time = std::chrono::steady_clock::now();
+
+        const Eigen::Isometry2d& start = requests[i].first;
+        const Eigen::Isometry2d& goal = requests[i].second;
+
+        // the requests are already searched in parallel, each on a single thread
+        SearchOptions options;
+        options.explore_cache = std::make_shared<Explore2DCache>();
+        options.explore_cache->landmarks = landmarks;
+        options.motion_primitives = snapshot->primitives;
+        options.analytic_expansion = settings.analytic_expansion;
+        options.lazy_evaluation = settings.lazy_evaluation;
+        options.heuristic_table = settings.heuristic_table;
+        const astar_planner::PathResult astar_result = astar_planner::hybridAStar(
+            start, {goal}, MAX_ITERATIONS, collision_checker, LINEAR_RESOLUTION, ANGULAR_RESOLUTION, sample,
+            settings.backwards_mult, settings.strafe_mult, settings.rotation_mult, options);
+
+        results[i].result = toResult(start, astar_result);
+        results[i].duration = std::chrono::steady_clock::now() - start_time;
+    });
+
+    ROS_INFO_STREAM("Planned " << requests.size() << " routes in "
+                               << std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count()
+                               << " snapshot: " << std::chrono::duration<double>(t1 - t0).count());
+
+    return results;
 }
 
 // cppcheck-suppress unusedFunction
 bool AStarPlanner::valid(const navigation_interface::Path& path) const
 {
-    // assume this is called immediately after plan to re-use the data structures
-    ROS_ASSERT(costmap_);
-
-    const astar_planner::CollisionChecker collision_checker(*costmap_, offsets_, conservative_robot_radius_);
-    return pathCost(path, collision_checker, backwards_mult_, strafe_mult_, rotation_mult_) <
-           std::numeric_limits<double>::max();
+    return cost(path) < std::numeric_limits<double>::max();
 }
 
 double AStarPlanner::cost(const navigation_interface::Path& path) const
 {
-    // assume this is called immediately after plan to re-use the data structures
+    // a path without segments costs nothing, also before there is a costmap to check it on
+    if (path.nodes.size() < 2)
+        return 0.0;
+
+    // re-uses the costmap of the last plan while the map has not changed since, otherwise the footprint of the robot is
+    // cleared at the start of the path
+    std::lock_guard<std::mutex> costmap_lock(costmap_mutex_);
+    bool stale = !costmap_ || costmap_map_data_ != map_data_;
+    if (!stale)
+    {
+        // cppcheck-suppress unreadVariable
+        auto lock = map_data_->grid.getLock();
+        stale = map_data_->grid.version() != costmap_->grid_version;
+    }
+    if (stale)
+        updateCostmap(path.nodes.front());
     ROS_ASSERT(costmap_);
 
     const astar_planner::CollisionChecker collision_checker(*costmap_, offsets_, conservative_robot_radius_);
-    return pathCost(path, collision_checker, backwards_mult_, strafe_mult_, rotation_mult_);
+    return path_cost_cache_.cost(path, collision_checker, *costmap_map_data_, backwards_mult_, strafe_mult_,
+                                 rotation_mult_);
+}
+
+void AStarPlanner::updateCostmap(const Eigen::Isometry2d& start) const
+{
+    // the costmap is kept between plans and only the parts of the map which changed are processed again
+    bool rebuild = false;
+    std::vector<cv::Rect> changed;
+    {
+        // cppcheck-suppress unreadVariable
+        auto lock = map_data_->grid.getLock();
+        if (!costmap_ || costmap_map_data_ != map_data_)
+        {
+            costmap_ = std::make_shared<Costmap>(*map_data_, robot_radius_);
+            costmap_map_data_ = map_data_;
+            rebuild = true;
+        }
+        else
+        {
+            // also restore the footprint cleared by the previous plan
+            changed = costmap_->updateObstacleMap(*map_data_, footprint_region_);
+        }
+    }
+
+    // clear the robot footprint
+    const cv::Rect previous_footprint_region = footprint_region_;
+    footprint_region_ = costmap_->clearFootprint(start, offsets_);
+
+    if (!cspace_)
+    {
+        cspace_ = std::make_shared<CSpace>(ANGULAR_RESOLUTION, offsets_);
+    }
+
+    ROS_ASSERT(traversal_cost_);
+    const bool traversal_changed = costmap_->traversal_cost != traversal_cost_;
+    if (rebuild)
+    {
+        costmap_->processObstacleMap();
+        cspace_->build(*costmap_);
+        path_cost_cache_.clear();
+        explore_cache_->all_changed = true;
+    }
+    else
+    {
+        changed.push_back(footprint_region_);
+        const std::vector<cv::Rect> processed = costmap_->processObstacleMap(changed);
+        cspace_->update(*costmap_, processed);
+
+        // the 2D search only compares the cells within the changed regions
+        if (traversal_changed)
+            explore_cache_->all_changed = true;
+        auto& changed_regions = explore_cache_->changed_regions;
+        changed_regions.insert(changed_regions.end(), processed.begin(), processed.end());
+        changed_regions.push_back(previous_footprint_region);
+        changed_regions.push_back(footprint_region_);
+
+        // the footprints are not part of the versions of the grid
+        if (traversal_changed)
+            path_cost_cache_.clear();
+        path_cost_cache_.invalidate(previous_footprint_region);
+        path_cost_cache_.invalidate(footprint_region_);
+    }
+
+    costmap_->traversal_cost = traversal_cost_;
+    costmap_->min_traversal_cost = min_traversal_cost_;
+
+    // processObstacleMap keeps the distances of the cells up to date, not their traversal costs
+    if (packed_cells_ && (costmap_->cells.empty() || traversal_changed))
+        costmap_->buildCells();
 }
 
 // cppcheck-suppress unusedFunction
 void AStarPlanner::onInitialize(const YAML::Node& parameters)
 {
+    ++settings_version_;
+
     debug_viz_ = parameters["debug_viz"].as<bool>(debug_viz_);
     robot_radius_ = parameters["robot_radius"].as<double>(robot_radius_);
     conservative_robot_radius_ = parameters["conservative_robot_radius"].as<double>(conservative_robot_radius_);
@@ -186,6 +596,84 @@ void AStarPlanner::onInitialize(const YAML::Node& parameters)
     strafe_mult_ = parameters["strafe_mult"].as<double>(strafe_mult_);
     rotation_mult_ = parameters["rotation_mult"].as<double>(rotation_mult_);
 
+    // lazy grows the 2D heuristic on demand, wavefront computes it for the whole map using all cores
+    const std::string heuristic_mode = parameters["heuristic_mode"].as<std::string>("lazy");
+    ROS_ASSERT_MSG(heuristic_mode == "lazy" || heuristic_mode == "wavefront", "Unknown heuristic_mode: %s",
+                   heuristic_mode.c_str());
+    heuristic_mode_ = (heuristic_mode == "wavefront") ? HeuristicMode::WAVEFRONT : HeuristicMode::LAZY;
+
+    // threads evaluating successors during the search, 1 keeps the search on the calling thread
+    threads_ = parameters["threads"].as<int>(threads_);
+    ROS_ASSERT_MSG(threads_ >= 1, "threads must be at least 1: %d", threads_);
+    thread_pool_.reset();
+    if (threads_ > 1)
+        thread_pool_ = std::make_shared<ThreadPool>(threads_);
+
+    // successors are only collision checked once they reach the top of the open set
+    lazy_evaluation_ = parameters["lazy_evaluation"].as<bool>(lazy_evaluation_);
+
+    // the searches read the clearance and traversal cost of a cell from one interleaved copy of the costmap
+    packed_cells_ = parameters["packed_cells"].as<bool>(packed_cells_);
+
+    // direct moves to the goal tried during the search, an interval of 0 disables them
+    analytic_expansion_.interval = static_cast<std::size_t>(
+        parameters["analytic_expansion_interval"].as<int>(static_cast<int>(analytic_expansion_.interval)));
+    analytic_expansion_.heuristic_threshold =
+        parameters["analytic_expansion_threshold"].as<double>(analytic_expansion_.heuristic_threshold);
+    analytic_expansion_.cost_tolerance =
+        parameters["analytic_expansion_cost_tolerance"].as<double>(analytic_expansion_.cost_tolerance);
+    ROS_ASSERT_MSG(analytic_expansion_.cost_tolerance >= 1.0, "analytic_expansion_cost_tolerance must be at least 1");
+
+    // weights of the heuristic for plans with a deadline, the first search uses the initial weight and every following
+    // search lowers it by the step until it reaches 1
+    anytime_.initial_weight = parameters["anytime_initial_weight"].as<double>(anytime_.initial_weight);
+    anytime_.weight_step = parameters["anytime_weight_step"].as<double>(anytime_.weight_step);
+    ROS_ASSERT_MSG(anytime_.initial_weight >= 1.0, "anytime_initial_weight must be at least 1");
+    ROS_ASSERT_MSG(anytime_.weight_step > 0.0, "anytime_weight_step must be positive");
+    anytime_.first_max_iterations = MAX_ITERATIONS;
+
+    // plans longer than corridor_min_distance are searched within corridor_margin of a path found with cells
+    // 2^corridor_level times larger first, a level of 0 disables the corridor
+    corridor_level_ = parameters["corridor_level"].as<int>(corridor_level_);
+    corridor_margin_ = parameters["corridor_margin"].as<double>(corridor_margin_);
+    corridor_min_distance_ = parameters["corridor_min_distance"].as<double>(corridor_min_distance_);
+    ROS_ASSERT_MSG(corridor_level_ >= 0, "corridor_level must not be negative: %d", corridor_level_);
+    ROS_ASSERT_MSG(corridor_margin_ >= 0.0, "corridor_margin must not be negative");
+
+    // number of ALT landmarks bounding the 2D heuristic, the nodes of the hd map are used first, 0 disables them
+    const int landmarks = parameters["alt_landmarks"].as<int>(static_cast<int>(landmarks_));
+    ROS_ASSERT_MSG(landmarks >= 0, "alt_landmarks must not be negative: %d", landmarks);
+    landmarks_ = static_cast<std::size_t>(landmarks);
+
+    // plans whose start and goals are within roi_max_distance of each other search a costmap of the region around them
+    // with a margin of at least roi_margin before the whole map, 0 (the default) disables it
+    roi_max_distance_ = parameters["roi_max_distance"].as<double>(roi_max_distance_);
+    roi_margin_ = parameters["roi_margin"].as<double>(roi_margin_);
+    ROS_ASSERT_MSG(roi_margin_ > 0.0, "roi_margin must be positive");
+
+    // directory keeping the traversal costs of the maps seen before, empty disables it
+    traversal_cost_cache_ = parameters["traversal_cost_cache"].as<std::string>(traversal_cost_cache_);
+
+    // directory the slow plans are written to, empty disables it
+    record_plans_ = parameters["record_plans"].as<std::string>(record_plans_);
+    record_threshold_ = parameters["record_threshold"].as<double>(record_threshold_);
+
+    // file written by generate_heuristic_table for the cost multipliers above, empty disables the table
+    const std::string heuristic_table = parameters["heuristic_table"].as<std::string>("");
+    heuristic_table_file_ = heuristic_table;
+    if (!heuristic_table.empty())
+    {
+        heuristic_table_ = HeuristicTable::load(heuristic_table);
+        ROS_ASSERT_MSG(heuristic_table_, "Failed to load heuristic table: %s", heuristic_table.c_str());
+
+        const HeuristicTable::Settings& settings = heuristic_table_->settings();
+        ROS_ASSERT_MSG(heuristic_table_->matches(LINEAR_RESOLUTION, ANGULAR_RESOLUTION, backwards_mult_, strafe_mult_,
+                                                 rotation_mult_),
+                       "Heuristic table %s was generated for different resolutions or cost multipliers",
+                       heuristic_table.c_str());
+        ROS_INFO_STREAM("Loaded heuristic table " << heuristic_table << " covering " << settings.size << "m");
+    }
+
     offsets_ = navigation_interface::get_point_list(parameters, "robot_radius_offsets",
                                                     {{-0.268, 0.000},
                                                      {0.268, 0.000},
@@ -210,76 +698,51 @@ void AStarPlanner::onMapDataChanged()
 {
     ROS_INFO("Building avoid zone traversal costmap");
 
-    // need to generate a data structure for zones
-    traversal_cost_ = std::make_shared<cv::Mat>(map_data_->grid.dimensions().size().y(),
-                                                map_data_->grid.dimensions().size().x(), CV_32F, cv::Scalar(1.0));
+    traversal_cost_ = traversalCostMap(*map_data_, avoid_zone_cost_, path_cost_, traversal_cost_cache_);
+    cv::minMaxLoc(*traversal_cost_, &min_traversal_cost_, nullptr);
 
-    for (const hd_map::Zone& zone : map_data_->hd_map.zones)
+    // waits for the landmarks of the previous map if they are still being computed
+    std::atomic_store(&map_landmarks_, std::shared_ptr<const Landmarks>());
+    landmarks_future_ = {};
+    if (landmarks_ > 0)
     {
-        if (zone.zone_type == hd_map::Zone::AVOID_ZONE)
-        {
-            int min_x = std::numeric_limits<int>::max();
-            int max_x = 0;
-
-            int min_y = std::numeric_limits<int>::max();
-            int max_y = 0;
-
-            std::vector<Eigen::Array2i> map_polygon;
-            for (const geometry_msgs::Point32& p : zone.polygon.points)
-            {
-                const Eigen::Array2i map_point = map_data_->grid.dimensions().getCellIndex({p.x, p.y});
-                min_x = std::min(map_point.x(), min_x);
-                max_x = std::max(map_point.x(), max_x);
-                min_y = std::min(map_point.y(), min_y);
-                max_y = std::max(map_point.y(), max_y);
-                map_polygon.push_back(map_point);
-            }
-            if (!map_polygon.empty())
-                map_polygon.push_back(map_polygon.front());
-
-            const std::vector<Eigen::Array2i> connected = gridmap::connectPolygon(map_polygon);
-
-            cv::Mat& traversal_cost = *(traversal_cost_.get());
-            const float avoid_zone_cost = static_cast<float>(avoid_zone_cost_);
-            auto append_raster = [&traversal_cost, avoid_zone_cost](const int x, const int y) {
-                if (x >= 0 && x < traversal_cost.cols && y >= 0 && y < traversal_cost.rows)
+        landmarks_future_ = std::async(
+            std::launch::async, [map_data = map_data_, traversal_cost = traversal_cost_, count = landmarks_,
+                                 robot_radius = robot_radius_, offsets = offsets_,
+                                 conservative_robot_radius = conservative_robot_radius_]() {
+                const auto t0 = std::chrono::steady_clock::now();
+
+                // the obstacles of the grid come and go and plans clear the footprint of the robot, the costs without
+                // any obstacles are the only ones no later plan can undercut
+                std::unique_ptr<Costmap> costmap;
                 {
-                    traversal_cost.at<float>(y, x) = avoid_zone_cost;
+                    // cppcheck-suppress unreadVariable
+                    auto lock = map_data->grid.getLock();
+                    const gridmap::MapDimensions& dimensions = map_data->grid.dimensions();
+                    costmap.reset(new Costmap(cv::Mat::zeros(dimensions.size().y(), dimensions.size().x(), CV_8U),
+                                              dimensions.resolution(), dimensions.origin().x(),
+                                              dimensions.origin().y(), robot_radius));
                 }
-            };
-
-            gridmap::rasterPolygonFill(append_raster, connected, min_x, max_x, min_y, max_y);
-        }
-    }
-
-    for (const hd_map::Path& path : map_data_->hd_map.paths)
-    {
-        ROS_INFO_STREAM("Loading path: " << path.name);
-        for (size_t i = 0; i < path.nodes.size() - 1; ++i)
-        {
-            const std::string first_id = path.nodes[i];
-            const std::string next_id = path.nodes[i + 1];
+                costmap->processObstacleMap();
+                costmap->traversal_cost = traversal_cost;
 
-            auto first_it = std::find_if(map_data_->hd_map.nodes.begin(), map_data_->hd_map.nodes.end(),
-                                         [&first_id](const hd_map::Node& n) { return n.id == first_id; });
-            ROS_ASSERT(first_it != map_data_->hd_map.nodes.end());
-            hd_map::Node start_node = *first_it;
-
-            auto next_it = std::find_if(map_data_->hd_map.nodes.begin(), map_data_->hd_map.nodes.end(),
-                                        [&next_id](const hd_map::Node& n) { return n.id == next_id; });
-            ROS_ASSERT(next_it != map_data_->hd_map.nodes.end());
-            hd_map::Node end_node = *next_it;
+                std::vector<State2D> candidates;
+                for (const hd_map::Node& node : map_data->hd_map.nodes)
+                {
+                    const Eigen::Array2i cell = costmap->getCellIndex({node.x, node.y});
+                    candidates.push_back({cell.x(), cell.y()});
+                }
 
-            const Eigen::Array2i start_mp = map_data_->grid.dimensions().getCellIndex({start_node.x, start_node.y});
-            const Eigen::Array2i end_mp = map_data_->grid.dimensions().getCellIndex({end_node.x, end_node.y});
+                const CollisionChecker collision_checker(*costmap, offsets, conservative_robot_radius);
+                auto landmarks = std::make_shared<const Landmarks>(collision_checker, candidates, count);
 
-            cv::line(*traversal_cost_, cv::Point(start_mp[0], start_mp[1]), cv::Point(end_mp[0], end_mp[1]), path_cost_,
-                     10);
-        }
+                ROS_INFO_STREAM("Computed " << landmarks->size() << " ALT landmarks in "
+                                            << std::chrono::duration_cast<std::chrono::duration<double>>(
+                                                   std::chrono::steady_clock::now() - t0)
+                                                   .count());
+                return landmarks;
+            });
     }
-
-    // blue the traversal cost map to help provide a smooth manifold for planning
-    cv::GaussianBlur(*traversal_cost_, *traversal_cost_, cv::Size(11, 11), 0);
 }
 
 }  // namespace astar_planner
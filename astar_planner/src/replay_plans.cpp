@@ -0,0 +1,112 @@
+#include <astar_planner/plan_record.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// bytes the search allocated for its nodes and its 2D search, which it keeps until the result is released
+std::size_t searchMemory(const astar_planner::PathResult& result)
+{
+    return result.explore_3d.memoryUsage() + result.analytic_nodes.memoryUsage() + result.path_nodes.memoryUsage() +
+           (result.explore_cache ? result.explore_cache->memoryUsage() : 0);
+}
+
+}  // namespace
+
+// Searches the plans recorded by AStarPlanner again and compares them with the recording
+// The memory is that allocated by each replayed search, not that of the process
+int main(int argc, char** argv)
+{
+    const std::string usage = std::string("Usage: ") + argv[0] + " <record>... [--repeat=1]";
+
+    int repeat = 1;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg.compare(0, 9, "--repeat=") == 0)
+        {
+            const std::string value = arg.substr(9);
+            char* end = nullptr;
+            const long parsed = std::strtol(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0' || parsed < 1 || parsed > std::numeric_limits<int>::max())
+            {
+                std::cout << usage << std::endl;
+                return EXIT_FAILURE;
+            }
+            repeat = static_cast<int>(parsed);
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.empty())
+    {
+        std::cout << usage << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int failures = 0;
+    for (const std::string& path : paths)
+    {
+        const auto record = astar_planner::PlanRecord::load(path);
+        if (!record)
+        {
+            std::cout << "Failed to read " << path << std::endl;
+            ++failures;
+            continue;
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        const auto costmap = record->costmap();
+        auto cspace = std::make_shared<astar_planner::CSpace>(record->settings.angular_resolution, record->offsets);
+        cspace->build(*costmap);
+        const auto t1 = std::chrono::steady_clock::now();
+
+        // the table is left out if it is not on this machine
+        std::shared_ptr<const astar_planner::HeuristicTable> table;
+        if (!record->heuristic_table.empty() && std::ifstream(record->heuristic_table))
+            table = astar_planner::HeuristicTable::load(record->heuristic_table);
+
+        std::cout << path << ": " << costmap->width << "x" << costmap->height << " cells, " << record->goals.size()
+                  << " goals, costmap built in " << std::chrono::duration<double>(t1 - t0).count() << "s"
+                  << (record->heuristic_table.empty() || table ? "" : ", heuristic table not found") << std::endl;
+        std::cout << "  recorded: " << record->duration << "s iterations: " << record->iterations
+                  << " success: " << record->success << std::endl;
+
+        // the planner keeps its threads between plans, so they are not started within the timed replays either
+        std::shared_ptr<astar_planner::ThreadPool> thread_pool;
+        if (record->settings.threads > 1)
+            thread_pool = std::make_shared<astar_planner::ThreadPool>(record->settings.threads);
+
+        for (int i = 0; i < repeat; ++i)
+        {
+            const auto start_time = std::chrono::steady_clock::now();
+            const astar_planner::PathResult result = record->replay(*costmap, cspace, table, thread_pool);
+            const double duration =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+            std::cout << "  replayed: " << duration << "s iterations: " << result.iterations
+                      << " nodes: " << result.explore_3d.size() << " searches: " << result.searches
+                      << " success: " << result.success << " cost: "
+                      << (result.success ? result.path.front()->cost_so_far : std::nan(""))
+                      << " memory: " << searchMemory(result) / (1024 * 1024) << "MB" << std::endl;
+
+            if (static_cast<bool>(result.success) != static_cast<bool>(record->success))
+                ++failures;
+        }
+    }
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
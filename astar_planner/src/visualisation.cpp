@@ -27,18 +27,24 @@ cv::Mat visualise(cv::Mat& disp, const Costmap& costmap, const PathResult& astar
     // draw the 2d heuristic cost values
     // draw as a blue gradient
     {
+        const Explore2DCache& explore_cache = *astar_result.explore_cache;
+        const std::size_t size = explore_cache.size();
+
         double max_cost_so_far = 0;
-        for (const auto& node : astar_result.explore_cache.explore_2d)
+        for (std::size_t i = 0; i < size; ++i)
         {
-            if (node.second.cost_so_far < std::numeric_limits<double>::max())
-                max_cost_so_far = std::max(node.second.cost_so_far, max_cost_so_far);
+            const Node2D* node = explore_cache.find(i);
+            if (node && node->cost_so_far < std::numeric_limits<double>::max())
+                max_cost_so_far = std::max(node->cost_so_far, max_cost_so_far);
         }
 
-        for (const auto& node : astar_result.explore_cache.explore_2d)
+        for (std::size_t i = 0; i < size; ++i)
         {
-            const unsigned char c =
-                static_cast<unsigned char>(255.0 - 255.0 * node.second.cost_so_far / max_cost_so_far);
-            disp.at<cv::Vec3b>(node.second.state.y, node.second.state.x) = cv::Vec3b(c, c, 0);
+            const Node2D* node = explore_cache.find(i);
+            if (!node || node->cost_so_far == std::numeric_limits<double>::max())
+                continue;
+            const unsigned char c = static_cast<unsigned char>(255.0 - 255.0 * node->cost_so_far / max_cost_so_far);
+            disp.at<cv::Vec3b>(node->state.y, node->state.x) = cv::Vec3b(c, c, 0);
         }
     }
 
@@ -154,10 +160,9 @@ cv::Mat visualise(cv::Mat& disp, const Costmap& costmap, const PathResult& astar
         auto first_node = astar_result.path.back();
         const Eigen::Array2i start_cell = costmap.getCellIndex({first_node->state.x, first_node->state.y});
         const std::size_t start_index = costmap.to2DGridIndex({start_cell.x(), start_cell.y()});
-        auto node_it = astar_result.explore_cache.explore_2d.find(start_index);
-        if (node_it != astar_result.explore_cache.explore_2d.end())
+        const Node2D* node = astar_result.explore_cache->find(start_index);
+        if (node)
         {
-            auto node = &node_it->second;
             do
             {
                 cv::circle(disp, cv::Point(node->state.x * scale, node->state.y * scale), 2, cv::Scalar(255, 0, 0), -1);
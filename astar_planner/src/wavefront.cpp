@@ -0,0 +1,376 @@
+#include <astar_planner/parallel.h>
+#include <astar_planner/wavefront.h>
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace astar_planner
+{
+
+namespace
+{
+
+class TiledWavefront
+{
+  public:
+    TiledWavefront(const int width, const int height, const int tile_size, const std::vector<float>& cell_costs,
+                   std::vector<double>& cost_to_go)
+        : width_(width), height_(height), tile_size_(tile_size), tiles_x_((width + tile_size - 1) / tile_size),
+          tiles_y_((height + tile_size - 1) / tile_size), cell_costs_(cell_costs), cost_to_go_(cost_to_go),
+          keys_(new std::atomic<uint64_t>[static_cast<std::size_t>(tiles_x_ * tiles_y_)]),
+          solved_(static_cast<std::size_t>(tiles_x_ * tiles_y_), 0)
+    {
+        for (int t = 0; t < tileCount(); ++t)
+            keys_[t] = INACTIVE;
+
+        // advance the wave by about a tile per round
+        float min_cell_cost = std::numeric_limits<float>::infinity();
+        for (const float cell_cost : cell_costs)
+            min_cell_cost = std::min(min_cell_cost, cell_cost);
+        step_ = tile_size * (min_cell_cost < std::numeric_limits<float>::infinity() ? min_cell_cost : 1.0);
+    }
+
+    int tileCount() const
+    {
+        return tiles_x_ * tiles_y_;
+    }
+
+    int tileOf(const int x, const int y) const
+    {
+        return (y / tile_size_) * tiles_x_ + (x / tile_size_);
+    }
+
+    void tileBounds(const int tile, int& x0, int& y0, int& x1, int& y1) const
+    {
+        x0 = (tile % tiles_x_) * tile_size_;
+        y0 = (tile / tiles_x_) * tile_size_;
+        x1 = std::min(x0 + tile_size_, width_);
+        y1 = std::min(y0 + tile_size_, height_);
+    }
+
+    void activate(const int tile)
+    {
+        keys_[tile] = toKey(0.0);
+    }
+
+    bool solved(const int tile) const
+    {
+        return solved_[static_cast<std::size_t>(tile)] != 0;
+    }
+
+    std::size_t run()
+    {
+        std::size_t tiles_solved = 0;
+        std::vector<int> batch;
+
+        while (true)
+        {
+            // solving the tiles in order of the cheapest cost flowing into them avoids solving tiles again and again
+            // as better costs arrive from other directions
+            uint64_t min_key = INACTIVE;
+            for (int t = 0; t < tileCount(); ++t)
+                min_key = std::min(min_key, keys_[t].load());
+
+            if (min_key == INACTIVE)
+                break;
+
+            const uint64_t threshold = toKey(fromKey(min_key) + step_);
+
+            for (int colour = 0; colour < 4; ++colour)
+            {
+                batch.clear();
+                for (int t = 0; t < tileCount(); ++t)
+                {
+                    const int tx = t % tiles_x_;
+                    const int ty = t / tiles_x_;
+                    if ((tx & 1) + 2 * (ty & 1) == colour && keys_[t] <= threshold)
+                    {
+                        keys_[t] = INACTIVE;
+                        batch.push_back(t);
+                    }
+                }
+
+                if (batch.empty())
+                    continue;
+
+                tiles_solved += batch.size();
+                parallelFor(static_cast<int>(batch.size()), [this, &batch](const int i) { solveTile(batch[i]); });
+            }
+        }
+
+        return tiles_solved;
+    }
+
+  private:
+    typedef std::pair<double, std::size_t> QueueEntry;
+
+    // non-negative doubles keep their order when compared as integers, which allows an atomic minimum
+    static constexpr uint64_t INACTIVE = std::numeric_limits<uint64_t>::max();
+
+    static uint64_t toKey(const double cost)
+    {
+        uint64_t key;
+        std::memcpy(&key, &cost, sizeof(key));
+        return key;
+    }
+
+    static double fromKey(const uint64_t key)
+    {
+        double cost;
+        std::memcpy(&cost, &key, sizeof(cost));
+        return cost;
+    }
+
+    std::size_t index(const int x, const int y) const
+    {
+        return static_cast<std::size_t>(y) * static_cast<std::size_t>(width_) + static_cast<std::size_t>(x);
+    }
+
+    // a changed cell within reach of the tile border has to be seen by the neighbouring tiles
+    void wakeNeighbours(const int x, const int y, const int tile, const double cost)
+    {
+        const uint64_t key = toKey(cost);
+        const int tx0 = std::max(0, x - 2) / tile_size_;
+        const int tx1 = std::min(width_ - 1, x + 2) / tile_size_;
+        const int ty0 = std::max(0, y - 2) / tile_size_;
+        const int ty1 = std::min(height_ - 1, y + 2) / tile_size_;
+        for (int ty = ty0; ty <= ty1; ++ty)
+        {
+            for (int tx = tx0; tx <= tx1; ++tx)
+            {
+                const int t = ty * tiles_x_ + tx;
+                if (t == tile)
+                    continue;
+
+                uint64_t current = keys_[t].load();
+                while (key < current && !keys_[t].compare_exchange_weak(current, key))
+                {
+                }
+            }
+        }
+    }
+
+    void solveTile(const int tile)
+    {
+        int x0, y0, x1, y1;
+        tileBounds(tile, x0, y0, x1, y1);
+
+        solved_[static_cast<std::size_t>(tile)] = 1;
+
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+        // pull in the costs from the halo and any cells which can be improved in one step
+        for (int y = y0; y < y1; ++y)
+        {
+            for (int x = x0; x < x1; ++x)
+            {
+                const std::size_t idx = index(x, y);
+                const float cell_cost = cell_costs_[idx];
+                if (cell_cost == std::numeric_limits<float>::infinity())
+                    continue;
+
+                double best = cost_to_go_[idx];
+                for (std::size_t i = 0; i < directions_2d.size(); ++i)
+                {
+                    const int ux = x - directions_2d[i].x;
+                    const int uy = y - directions_2d[i].y;
+                    if (ux < 0 || ux >= width_ || uy < 0 || uy >= height_)
+                        continue;
+
+                    const double cost_u = cost_to_go_[index(ux, uy)];
+                    if (cost_u < std::numeric_limits<double>::max())
+                        best = std::min(best, cost_u + directions_2d_cost[i] * cell_cost);
+                }
+
+                if (best < cost_to_go_[idx])
+                {
+                    cost_to_go_[idx] = best;
+                    queue.push({best, idx});
+                    wakeNeighbours(x, y, tile, best);
+                }
+            }
+        }
+
+        // then propagate within the tile
+        while (!queue.empty())
+        {
+            const QueueEntry entry = queue.top();
+            queue.pop();
+
+            if (entry.first > cost_to_go_[entry.second])
+                continue;
+
+            const int x = static_cast<int>(entry.second % static_cast<std::size_t>(width_));
+            const int y = static_cast<int>(entry.second / static_cast<std::size_t>(width_));
+
+            for (std::size_t i = 0; i < directions_2d.size(); ++i)
+            {
+                const int wx = x + directions_2d[i].x;
+                const int wy = y + directions_2d[i].y;
+                if (wx < x0 || wx >= x1 || wy < y0 || wy >= y1)
+                    continue;
+
+                const std::size_t w_idx = index(wx, wy);
+                const float cell_cost = cell_costs_[w_idx];
+                if (cell_cost == std::numeric_limits<float>::infinity())
+                    continue;
+
+                const double cost = entry.first + directions_2d_cost[i] * cell_cost;
+                if (cost < cost_to_go_[w_idx])
+                {
+                    cost_to_go_[w_idx] = cost;
+                    queue.push({cost, w_idx});
+                    wakeNeighbours(wx, wy, tile, cost);
+                }
+            }
+        }
+    }
+
+    const int width_;
+    const int height_;
+    const int tile_size_;
+    const int tiles_x_;
+    const int tiles_y_;
+
+    const std::vector<float>& cell_costs_;
+    std::vector<double>& cost_to_go_;
+
+    // lowest cost flowing into each tile that still has to be solved
+    // tiles of the same colour are solved concurrently and may wake the same neighbour
+    std::unique_ptr<std::atomic<uint64_t>[]> keys_;
+    double step_;
+
+    // only written by the thread solving the tile
+    std::vector<uint8_t> solved_;
+};
+
+}  // namespace
+
+std::size_t wavefront2D(const State2D& goal, Explore2DCache& explore_cache, const CollisionChecker& collision_checker,
+                        const int tile_size)
+{
+    const Costmap& costmap = collision_checker.costmap();
+
+    ROS_ASSERT(tile_size >= 2);
+    ROS_ASSERT(collision_checker.isWithinBounds(goal));
+
+    const std::size_t size = static_cast<std::size_t>(costmap.width) * static_cast<std::size_t>(costmap.height);
+
+    const bool incremental = explore_cache.complete && explore_cache.goal == goal &&
+                             explore_cache.width() == costmap.width && explore_cache.height() == costmap.height &&
+                             explore_cache.cell_costs.size() == size;
+
+    if (!incremental)
+    {
+        // keep the cell costs if updateExplore2DCache already took them for this costmap
+        std::vector<float> cell_costs;
+        cell_costs.swap(explore_cache.cell_costs);
+        explore_cache.reset(costmap.width, costmap.height);
+        explore_cache.goal = goal;
+        if (cell_costs.size() == size)
+            explore_cache.cell_costs.swap(cell_costs);
+        else
+            cellCosts2D(collision_checker, explore_cache.cell_costs);
+    }
+
+    explore_cache.open_set.clear();
+
+    const std::vector<float>& cell_costs = explore_cache.cell_costs;
+    std::vector<double> cost_to_go(size, std::numeric_limits<double>::max());
+
+    TiledWavefront wavefront(costmap.width, costmap.height, tile_size, cell_costs, cost_to_go);
+
+    if (incremental)
+    {
+        // carry over the kept costs and solve the tiles with discarded cells again
+        parallelFor(wavefront.tileCount(), [&](const int tile) {
+            int x0, y0, x1, y1;
+            wavefront.tileBounds(tile, x0, y0, x1, y1);
+            bool discarded = false;
+            for (int y = y0; y < y1; ++y)
+            {
+                for (int x = x0; x < x1; ++x)
+                {
+                    const std::size_t idx = costmap.to2DGridIndex({x, y});
+                    const Node2D* node = explore_cache.find(idx);
+                    if (node)
+                        cost_to_go[idx] = node->cost_so_far;
+                    else
+                        discarded = true;
+                }
+            }
+            if (discarded)
+                wavefront.activate(tile);
+        });
+    }
+    else
+    {
+        cost_to_go[costmap.to2DGridIndex(goal)] = 0;
+        wavefront.activate(wavefront.tileOf(goal.x, goal.y));
+    }
+
+    const std::size_t tiles_solved = wavefront.run();
+
+    // store the results in the cache, every cell gets a node so a complete cache has no gaps
+    auto for_each_written_cell = [&](const std::function<void(const int, const int, const std::size_t)>& function) {
+        parallelFor(wavefront.tileCount(), [&](const int tile) {
+            if (incremental && !wavefront.solved(tile))
+                return;
+
+            int x0, y0, x1, y1;
+            wavefront.tileBounds(tile, x0, y0, x1, y1);
+            for (int y = y0; y < y1; ++y)
+                for (int x = x0; x < x1; ++x)
+                    function(x, y, costmap.to2DGridIndex({x, y}));
+        });
+    };
+
+    for_each_written_cell([&](const int x, const int y, const std::size_t idx) {
+        explore_cache.insert(idx, Node2D{State2D{x, y}, nullptr, cost_to_go[idx], 0});
+    });
+
+    // point every reached cell at its cheapest neighbour so the shortest paths can be followed back to the goal
+    const std::size_t goal_index = costmap.to2DGridIndex(goal);
+    for_each_written_cell([&](const int x, const int y, const std::size_t idx) {
+        if (idx == goal_index || cost_to_go[idx] == std::numeric_limits<double>::max())
+            return;
+
+        double best = std::numeric_limits<double>::max();
+        std::size_t best_idx = idx;
+        for (std::size_t i = 0; i < directions_2d.size(); ++i)
+        {
+            const State2D u{x - directions_2d[i].x, y - directions_2d[i].y};
+            if (!collision_checker.isWithinBounds(u))
+                continue;
+
+            const std::size_t u_idx = costmap.to2DGridIndex(u);
+            if (cost_to_go[u_idx] == std::numeric_limits<double>::max())
+                continue;
+
+            const double cost = cost_to_go[u_idx] + directions_2d_cost[i] * cell_costs[idx];
+            if (cost < best)
+            {
+                best = cost;
+                best_idx = u_idx;
+            }
+        }
+
+        if (best_idx != idx)
+            explore_cache.find(idx)->parent = explore_cache.find(best_idx);
+    });
+
+    explore_cache.setAllVisited();
+    explore_cache.started = true;
+    explore_cache.complete = true;
+
+    return tiles_solved;
+}
+
+}  // namespace astar_planner
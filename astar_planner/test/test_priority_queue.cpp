@@ -0,0 +1,450 @@
+#include <astar_planner/astar.h>
+#include <astar_planner/node.h>
+#include <astar_planner/node_arena.h>
+#include <boost/heap/binomial_heap.hpp>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+
+using namespace astar_planner;
+
+namespace
+{
+
+Node3D makeNode(const double cost_so_far, const double cost_to_go)
+{
+    return Node3D{State3D{0, 0, 0}, nullptr, false, cost_so_far, cost_to_go};
+}
+
+// the slot NodeIndexMap starts probing from, with the same finaliser
+std::size_t homeSlot(uint64_t key, const std::size_t capacity)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return static_cast<std::size_t>(key) & (capacity - 1);
+}
+
+}  // namespace
+
+TEST(IndexedHeap, pop_order)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(0, 100);
+
+    std::deque<Node3D> nodes;
+    PriorityQueue3D open_set;
+    for (int i = 0; i < 1000; ++i)
+    {
+        nodes.push_back(makeNode(dist(gen), dist(gen)));
+        open_set.push(&nodes.back());
+    }
+
+    ASSERT_EQ(1000, open_set.size());
+
+    double last = 0;
+    while (!open_set.empty())
+    {
+        const Node3D* node = open_set.top();
+        open_set.pop();
+        EXPECT_EQ(HEAP_NPOS, node->heap_index);
+        EXPECT_LE(last, node->cost_so_far + node->cost_to_go);
+        last = node->cost_so_far + node->cost_to_go;
+    }
+
+    for (const Node3D& node : nodes)
+        EXPECT_FALSE(open_set.contains(&node));
+}
+
+TEST(IndexedHeap, decrease)
+{
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> dist(10, 100);
+
+    std::deque<Node3D> nodes;
+    PriorityQueue3D open_set;
+    for (int i = 0; i < 500; ++i)
+    {
+        nodes.push_back(makeNode(dist(gen), dist(gen)));
+        open_set.push(&nodes.back());
+    }
+
+    for (std::size_t i = 0; i < nodes.size(); i += 3)
+    {
+        nodes[i].cost_so_far -= 10;
+        open_set.decrease(&nodes[i]);
+    }
+
+    Node3D* cheapest = &nodes[250];
+    cheapest->cost_so_far = 0;
+    cheapest->cost_to_go = 0;
+    open_set.decrease(cheapest);
+    EXPECT_EQ(cheapest, open_set.top());
+
+    double last = 0;
+    while (!open_set.empty())
+    {
+        const Node3D* node = open_set.top();
+        open_set.pop();
+        EXPECT_LE(last, node->cost_so_far + node->cost_to_go);
+        last = node->cost_so_far + node->cost_to_go;
+    }
+}
+
+TEST(IndexedHeap, rebuild)
+{
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(0, 100);
+
+    std::deque<Node2D> nodes;
+    PriorityQueue2D open_set;
+    for (int i = 0; i < 500; ++i)
+    {
+        nodes.push_back(Node2D{State2D{0, 0}, nullptr, dist(gen), dist(gen)});
+        open_set.push(&nodes.back());
+    }
+
+    // heuristics change when the start state moves
+    for (const auto& node : open_set)
+        node->cost_to_go = dist(gen);
+    open_set.rebuild();
+
+    double last = 0;
+    while (!open_set.empty())
+    {
+        const Node2D* node = open_set.top();
+        open_set.pop();
+        EXPECT_LE(last, node->cost_so_far + node->cost_to_go);
+        last = node->cost_so_far + node->cost_to_go;
+    }
+}
+
+TEST(IndexedHeap, update_erase)
+{
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<double> dist(0, 100);
+
+    std::deque<Node3D> nodes;
+    PriorityQueue3D open_set;
+    for (int i = 0; i < 500; ++i)
+    {
+        nodes.push_back(makeNode(dist(gen), dist(gen)));
+        open_set.push(&nodes.back());
+    }
+
+    // move keys in both directions and drop every fifth node
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (i % 5 == 0)
+        {
+            open_set.erase(&nodes[i]);
+            EXPECT_FALSE(open_set.contains(&nodes[i]));
+        }
+        else
+        {
+            nodes[i].cost_so_far = dist(gen);
+            open_set.update(&nodes[i]);
+        }
+    }
+
+    ASSERT_EQ(400, open_set.size());
+
+    double last = 0;
+    while (!open_set.empty())
+    {
+        const Node3D* node = open_set.top();
+        open_set.pop();
+        EXPECT_LE(last, node->cost_so_far + node->cost_to_go);
+        last = node->cost_so_far + node->cost_to_go;
+    }
+}
+
+TEST(IndexedHeap, benchmark)
+{
+    // mimic the access pattern of the search: every pop is followed by a handful of pushes and decreases
+    // the decreased nodes are picked at random among the pushed ones so they sift up from anywhere in the heap
+    const std::size_t iterations = 200000;
+    const std::size_t successors = 6;
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> dist(0, 1);
+
+    std::vector<double> costs(iterations * successors);
+    for (double& cost : costs)
+        cost = dist(gen);
+
+    std::size_t checksum_indexed = 0;
+    std::size_t checksum_boost = 0;
+
+    std::chrono::duration<double> indexed_time;
+    {
+        std::deque<Node3D> nodes;
+        PriorityQueue3D open_set;
+
+        const auto t0 = std::chrono::steady_clock::now();
+
+        nodes.push_back(makeNode(0, 0));
+        open_set.push(&nodes.back());
+        std::size_t c = 0;
+        for (std::size_t i = 0; i < iterations && !open_set.empty(); ++i)
+        {
+            Node3D* current = open_set.top();
+            open_set.pop();
+            checksum_indexed += static_cast<std::size_t>(current->cost_so_far * 1000);
+            for (std::size_t s = 0; s < successors; ++s, ++c)
+            {
+                Node3D* node = &nodes[static_cast<std::size_t>(costs[c] * static_cast<double>(nodes.size()))];
+                if (s % 3 == 0 && open_set.contains(node))
+                {
+                    node->cost_so_far *= 1.0 - 0.5 * costs[c];
+                    open_set.decrease(node);
+                }
+                else
+                {
+                    nodes.push_back(makeNode(current->cost_so_far + costs[c], costs[c]));
+                    open_set.push(&nodes.back());
+                }
+            }
+        }
+
+        indexed_time = std::chrono::steady_clock::now() - t0;
+    }
+
+    std::chrono::duration<double> boost_time;
+    {
+        typedef boost::heap::binomial_heap<Node3D*, boost::heap::compare<CompareNodes>> BinomialHeap;
+
+        std::deque<Node3D> nodes;
+        BinomialHeap open_set;
+        std::unordered_map<const Node3D*, BinomialHeap::handle_type> handles;
+
+        const auto t0 = std::chrono::steady_clock::now();
+
+        nodes.push_back(makeNode(0, 0));
+        handles[&nodes.back()] = open_set.push(&nodes.back());
+        std::size_t c = 0;
+        for (std::size_t i = 0; i < iterations && !open_set.empty(); ++i)
+        {
+            Node3D* current = open_set.top();
+            open_set.pop();
+            handles.erase(current);
+            checksum_boost += static_cast<std::size_t>(current->cost_so_far * 1000);
+            for (std::size_t s = 0; s < successors; ++s, ++c)
+            {
+                Node3D* node = &nodes[static_cast<std::size_t>(costs[c] * static_cast<double>(nodes.size()))];
+                if (s % 3 == 0 && handles.count(node))
+                {
+                    node->cost_so_far *= 1.0 - 0.5 * costs[c];
+                    // the comparison orders the cheapest first, so a lower cost raises the priority in boost's terms
+                    open_set.increase(handles.at(node));
+                }
+                else
+                {
+                    nodes.push_back(makeNode(current->cost_so_far + costs[c], costs[c]));
+                    handles[&nodes.back()] = open_set.push(&nodes.back());
+                }
+            }
+        }
+
+        boost_time = std::chrono::steady_clock::now() - t0;
+    }
+
+    EXPECT_EQ(checksum_boost, checksum_indexed);
+
+    std::cout << "indexed heap: " << indexed_time.count() * 1000 << "ms" << std::endl;
+    std::cout << "binomial heap: " << boost_time.count() * 1000 << "ms" << std::endl;
+}
+
+TEST(Costmap, packed_cells_benchmark)
+{
+    // a 2D search across a map of scattered obstacles and varying traversal costs, with either layout of the cells
+    const int size = 1000;
+    const int runs = 5;
+
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int> position(0, size - 1);
+    cv::Mat obstacles(size, size, CV_8U, cv::Scalar(0));
+    for (int i = 0; i < 300; ++i)
+        cv::circle(obstacles, cv::Point(position(gen), position(gen)), 6, cv::Scalar(255), -1);
+
+    const State2D start{50, size - 50};
+    const State2D goal{size - 50, 50};
+    cv::circle(obstacles, cv::Point(start.x, start.y), 30, cv::Scalar(0), -1);
+    cv::circle(obstacles, cv::Point(goal.x, goal.y), 30, cv::Scalar(0), -1);
+
+    Costmap costmap(obstacles, 0.02, 0.0, 0.0, 0.23);
+    costmap.processObstacleMap();
+    costmap.traversal_cost = std::make_shared<cv::Mat>(size, size, CV_32F);
+    cv::randu(*costmap.traversal_cost, cv::Scalar(1.0), cv::Scalar(2.0));
+
+    Costmap packed = costmap;
+    packed.buildCells();
+
+    const std::vector<Eigen::Vector2d> offsets = {{0.0, 0.0}};
+    auto search = [&](const Costmap& map, double& cost) {
+        const CollisionChecker collision_checker(map, offsets, 0.416);
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int run = 0; run < runs; ++run)
+        {
+            Explore2DCache explore_cache;
+            updateExplore2DCache(explore_cache, goal, collision_checker);
+            const ShortestPath2D result = shortestPath2D(start, goal, explore_cache, collision_checker);
+            cost = result.success ? result.node->cost_so_far : -1.0;
+        }
+        return (std::chrono::steady_clock::now() - t0) / runs;
+    };
+
+    double planar_cost;
+    double packed_cost;
+    const std::chrono::duration<double> planar_time = search(costmap, planar_cost);
+    const std::chrono::duration<double> packed_time = search(packed, packed_cost);
+
+    EXPECT_GT(planar_cost, 0.0);
+    EXPECT_EQ(planar_cost, packed_cost);
+
+    std::cout << "planar cells: " << planar_time.count() * 1000 << "ms" << std::endl;
+    std::cout << "packed cells: " << packed_time.count() * 1000 << "ms" << std::endl;
+}
+
+TEST(NodeArena, pointers_stay_valid)
+{
+    NodeArena<Node3D, 16> arena;
+    std::vector<Node3D*> nodes;
+    for (int i = 0; i < 1000; ++i)
+        nodes.push_back(arena.allocate(makeNode(i, 2 * i)));
+
+    ASSERT_EQ(1000, arena.size());
+
+    // the blocks are allocated whole
+    EXPECT_GE(arena.memoryUsage(), 63 * 16 * sizeof(Node3D));
+
+    // nodes of earlier blocks are not moved by the later ones
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        EXPECT_EQ(i, nodes[i]->cost_so_far);
+        EXPECT_EQ(2 * i, nodes[i]->cost_to_go);
+        if (i > 0)
+        {
+            EXPECT_NE(nodes[i - 1], nodes[i]);
+        }
+    }
+}
+
+TEST(NodeArena, reuse_after_clear)
+{
+    NodeArena<Node3D, 16> arena;
+    for (int i = 0; i < 40; ++i)
+        arena.allocate(makeNode(i, 0));
+
+    arena.clear();
+    EXPECT_EQ(0, arena.size());
+
+    std::vector<Node3D*> nodes;
+    for (int i = 0; i < 40; ++i)
+        nodes.push_back(arena.allocate(makeNode(0, i)));
+
+    ASSERT_EQ(40, arena.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        EXPECT_EQ(0, nodes[i]->cost_so_far);
+        EXPECT_EQ(i, nodes[i]->cost_to_go);
+    }
+}
+
+TEST(NodeIndexMap, grow)
+{
+    NodeIndexMap<Node3D> map(16);
+
+    // lattice keys around the origin, negative indices included
+    std::vector<uint64_t> keys;
+    std::vector<Node3D*> nodes;
+    for (int y = -40; y < 40; ++y)
+    {
+        for (int x = -40; x < 40; ++x)
+        {
+            keys.push_back(IndexToKey(Node3dIndex{x, y, (x + y) % 16}));
+            const auto emplaced = map.emplace(keys.back(), makeNode(x, y));
+            ASSERT_TRUE(emplaced.second);
+            nodes.push_back(emplaced.first);
+        }
+    }
+
+    ASSERT_EQ(keys.size(), map.size());
+    EXPECT_GE(map.memoryUsage(), 2 * keys.size() * sizeof(NodeIndexMap<Node3D>::value_type) +
+                                     keys.size() * sizeof(Node3D));
+
+    // the nodes are neither moved nor copied by the rehashes
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        EXPECT_EQ(nodes[i], map.find(keys[i]));
+
+        const auto emplaced = map.emplace(keys[i], makeNode(-1, -1));
+        EXPECT_FALSE(emplaced.second);
+        EXPECT_EQ(nodes[i], emplaced.first);
+    }
+    EXPECT_EQ(keys.size(), map.size());
+
+    EXPECT_EQ(nullptr, map.find(IndexToKey(Node3dIndex{40, 40, 0})));
+    EXPECT_EQ(nullptr, map.find(IndexToKey(Node3dIndex{-41, 0, 0})));
+
+    // every node is iterated once
+    std::unordered_map<uint64_t, Node3D*> iterated;
+    for (const auto& entry : map)
+        EXPECT_TRUE(iterated.emplace(entry.first, entry.second).second);
+    ASSERT_EQ(keys.size(), iterated.size());
+    for (std::size_t i = 0; i < keys.size(); ++i)
+        EXPECT_EQ(nodes[i], iterated.at(keys[i]));
+}
+
+TEST(NodeIndexMap, probe_wraparound)
+{
+    const std::size_t capacity = 16;
+
+    // keys starting from the last slot and the first slot
+    std::vector<uint64_t> last_keys;
+    std::vector<uint64_t> first_keys;
+    for (uint64_t key = 1; last_keys.size() < 5 || first_keys.size() < 2; ++key)
+    {
+        const std::size_t slot = homeSlot(key, capacity);
+        if (slot == capacity - 1 && last_keys.size() < 5)
+            last_keys.push_back(key);
+        else if (slot == 0 && first_keys.size() < 2)
+            first_keys.push_back(key);
+    }
+
+    // half full, which does not grow the map
+    NodeIndexMap<Node3D> map(capacity);
+    std::vector<std::pair<uint64_t, Node3D*>> inserted;
+    for (std::size_t i = 0; i < 4; ++i)
+        inserted.push_back({last_keys[i], map.emplace(last_keys[i], makeNode(i, 0)).first});
+    for (std::size_t i = 0; i < 2; ++i)
+        inserted.push_back({first_keys[i], map.emplace(first_keys[i], makeNode(0, i)).first});
+
+    ASSERT_EQ(6, map.size());
+
+    // the second key of the last slot wrapped around to the first slot
+    ASSERT_NE(map.begin(), map.end());
+    EXPECT_EQ(last_keys[1], map.begin()->first);
+
+    for (const auto& entry : inserted)
+    {
+        EXPECT_EQ(entry.second, map.find(entry.first));
+        EXPECT_FALSE(map.emplace(entry.first, makeNode(-1, -1)).second);
+    }
+    EXPECT_EQ(6, map.size());
+
+    // a missing key probes across the end until the first empty slot
+    EXPECT_EQ(nullptr, map.find(last_keys[4]));
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,14 +1,26 @@
 #include <astar_planner/astar.h>
+#include <astar_planner/corridor.h>
+#include <astar_planner/dstar_lite.h>
+#include <astar_planner/heuristic_table.h>
+#include <astar_planner/landmarks.h>
+#include <astar_planner/parallel.h>
+#include <astar_planner/path_cost.h>
+#include <astar_planner/plan_record.h>
 #include <astar_planner/plugin.h>
 #include <astar_planner/visualisation.h>
+#include <astar_planner/wavefront.h>
 #include <gridmap/map_data.h>
 #include <gtest/gtest.h>
 #include <hd_map/Map.h>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <deque>
+#include <fstream>
+#include <queue>
 #include <random>
 
 class PlanningTest : public testing::Test
@@ -344,6 +356,1796 @@ TEST_F(PlanningTest, test_goal_sampling)
     cv::imwrite("test_goal_sampling.png", disp);
 }
 
+TEST_F(PlanningTest, test_replan)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(200, 400), cv::Point(900, 500), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(100, 600), cv::Point(800, 700), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(0, 0), cv::Point(140, 500), cv::Scalar(255), -1, cv::LINE_8);
+
+    const auto traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-6, -8) * Eigen::Rotation2Dd(M_PI);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(8, 8) * Eigen::Rotation2Dd(M_PI);
+
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    // the goal rooted 2D search is kept between plans
+    auto explore_cache = std::make_shared<astar_planner::Explore2DCache>();
+
+    auto plan = [&](const Eigen::Isometry2d& plan_start, const std::shared_ptr<astar_planner::Explore2DCache>& cache,
+                    const std::string& name) {
+        auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+        costmap->processObstacleMap();
+        costmap->traversal_cost = traversal_cost;
+
+        const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+        const auto t0 = std::chrono::steady_clock::now();
+
+        astar_planner::SearchOptions options;
+        options.explore_cache = cache;
+        const astar_planner::PathResult astar_result = astar_planner::hybridAStar(
+            plan_start, {goal}, max_iterations, collision_checker, linear_resolution, angular_resolution,
+            goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options);
+
+        std::cout
+            << name << " took: "
+            << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0).count()
+            << std::endl;
+
+        std::cout << "path size: " << astar_result.path.size() << std::endl;
+        std::cout << "success: " << astar_result.success << std::endl;
+        std::cout << "iterations: " << astar_result.iterations << std::endl;
+        std::cout << "nodes: " << astar_result.explore_3d.size() << std::endl;
+
+        EXPECT_TRUE(astar_result.success);
+        for (const auto& node : astar_result.path)
+            EXPECT_TRUE(collision_checker.isValid(node->state));
+
+        const cv::Mat disp = astar_planner::visualise(*costmap, astar_result);
+        cv::imwrite("test_replan_" + name + ".png", disp);
+
+        return astar_result.success ? astar_result.path.front()->cost_so_far : 0.0;
+    };
+
+    const double first_cost = plan(start, explore_cache, "first");
+
+    // unchanged map, the heuristic is reused as is
+    const double unchanged_cost = plan(start, explore_cache, "unchanged");
+    EXPECT_DOUBLE_EQ(first_cost, unchanged_cost);
+
+    // narrow the corridor the previous route went through and move the start along
+    cv::rectangle(cv_im, cv::Point(500, 300), cv::Point(560, 345), cv::Scalar(255), -1, cv::LINE_8);
+    const Eigen::Isometry2d moved_start = Eigen::Translation2d(-5.5, -8) * Eigen::Rotation2Dd(M_PI);
+
+    const double blocked_cost = plan(moved_start, explore_cache, "blocked");
+    EXPECT_DOUBLE_EQ(plan(moved_start, nullptr, "blocked_fresh"), blocked_cost);
+
+    // clear the obstacle again
+    cv::rectangle(cv_im, cv::Point(500, 300), cv::Point(560, 345), cv::Scalar(0), -1, cv::LINE_8);
+
+    const double cleared_cost = plan(moved_start, explore_cache, "cleared");
+    EXPECT_DOUBLE_EQ(plan(moved_start, nullptr, "cleared_fresh"), cleared_cost);
+}
+
+TEST_F(PlanningTest, test_wavefront)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(200, 400), cv::Point(900, 500), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(100, 600), cv::Point(800, 700), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(0, 0), cv::Point(140, 500), cv::Scalar(255), -1, cv::LINE_8);
+
+    const auto traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+    cv::rectangle(*traversal_cost, cv::Point(400, 800), cv::Point(600, 900), cv::Scalar(4.0), -1, cv::LINE_8);
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-6, -8) * Eigen::Rotation2Dd(M_PI);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(8, 8) * Eigen::Rotation2Dd(M_PI);
+
+    auto make_costmap = [&]() {
+        auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+        costmap->processObstacleMap();
+        costmap->traversal_cost = traversal_cost;
+        return costmap;
+    };
+
+    // reference serial Dijkstra over the same cell costs
+    auto dijkstra = [](const astar_planner::Costmap& costmap, const std::vector<float>& cell_costs,
+                       const astar_planner::State2D& root) {
+        std::vector<double> cost_to_go(cell_costs.size(), std::numeric_limits<double>::max());
+        typedef std::pair<double, astar_planner::State2D> Entry;
+        auto compare = [](const Entry& a, const Entry& b) { return a.first > b.first; };
+        std::priority_queue<Entry, std::vector<Entry>, decltype(compare)> queue(compare);
+        cost_to_go[costmap.to2DGridIndex(root)] = 0;
+        queue.push({0, root});
+        while (!queue.empty())
+        {
+            const Entry entry = queue.top();
+            queue.pop();
+            if (entry.first > cost_to_go[costmap.to2DGridIndex(entry.second)])
+                continue;
+            for (std::size_t i = 0; i < astar_planner::directions_2d.size(); ++i)
+            {
+                const astar_planner::State2D next = entry.second + astar_planner::directions_2d[i];
+                if (next.x < 0 || next.x >= costmap.width || next.y < 0 || next.y >= costmap.height)
+                    continue;
+                const std::size_t next_index = costmap.to2DGridIndex(next);
+                if (cell_costs[next_index] == std::numeric_limits<float>::infinity())
+                    continue;
+                const double cost = entry.first + astar_planner::directions_2d_cost[i] * cell_costs[next_index];
+                if (cost < cost_to_go[next_index])
+                {
+                    cost_to_go[next_index] = cost;
+                    queue.push({cost, next});
+                }
+            }
+        }
+        return cost_to_go;
+    };
+
+    auto check_field = [&](const astar_planner::Costmap& costmap, const astar_planner::Explore2DCache& explore_cache,
+                           const astar_planner::State2D& root) {
+        ASSERT_TRUE(explore_cache.complete);
+        const std::vector<double> expected = dijkstra(costmap, explore_cache.cell_costs, root);
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            const astar_planner::Node2D* node = explore_cache.find(i);
+            ASSERT_TRUE(node);
+            if (std::abs(node->cost_so_far - expected[i]) > 1e-6 * std::max(1.0, expected[i]))
+                ++mismatches;
+        }
+        EXPECT_EQ(0, mismatches);
+    };
+
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    auto explore_cache = std::make_shared<astar_planner::Explore2DCache>();
+
+    {
+        auto costmap = make_costmap();
+        const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+        const auto t0 = std::chrono::steady_clock::now();
+
+        astar_planner::SearchOptions options;
+        options.explore_cache = explore_cache;
+        options.heuristic_mode = astar_planner::HeuristicMode::WAVEFRONT;
+        const astar_planner::PathResult astar_result = astar_planner::hybridAStar(
+            start, {goal}, max_iterations, collision_checker, linear_resolution, angular_resolution,
+            goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options);
+
+        std::cout
+            << "planner took: "
+            << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0).count()
+            << std::endl;
+
+        std::cout << "path size: " << astar_result.path.size() << std::endl;
+        std::cout << "success: " << astar_result.success << std::endl;
+        std::cout << "iterations: " << astar_result.iterations << std::endl;
+        std::cout << "nodes: " << astar_result.explore_3d.size() << std::endl;
+
+        EXPECT_TRUE(astar_result.success);
+        check_field(*costmap, *explore_cache, explore_cache->goal);
+
+        const cv::Mat disp = astar_planner::visualise(*costmap, astar_result);
+        cv::imwrite("test_wavefront.png", disp);
+    }
+
+    // narrow a corridor, only the affected tiles are solved again
+    cv::rectangle(cv_im, cv::Point(500, 300), cv::Point(560, 345), cv::Scalar(255), -1, cv::LINE_8);
+    {
+        auto costmap = make_costmap();
+        const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+        const astar_planner::State2D goal_2d = explore_cache->goal;
+        const std::size_t discarded = astar_planner::updateExplore2DCache(*explore_cache, goal_2d, collision_checker);
+        const std::size_t tiles = astar_planner::wavefront2D(goal_2d, *explore_cache, collision_checker);
+
+        std::cout << "discarded: " << discarded << " tiles solved: " << tiles << std::endl;
+
+        check_field(*costmap, *explore_cache, goal_2d);
+    }
+}
+
+TEST_F(PlanningTest, test_incremental_costmap)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(200, 400), cv::Point(900, 500), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(0, 0), cv::Point(140, 500), cv::Scalar(255), -1, cv::LINE_8);
+
+    const int radius_px = static_cast<int>(robot_radius / resolution);
+    const cv::Rect footprint(590, 320, 2 * radius_px + 1, 2 * radius_px + 1);
+    const cv::Point footprint_center(footprint.x + radius_px, footprint.y + radius_px);
+
+    astar_planner::Costmap costmap(*map_data, robot_radius);
+    cv::circle(costmap.obstacle_map, footprint_center, radius_px, cv::Scalar(0), -1);
+    costmap.processObstacleMap();
+
+    // mark the tiles under a change to the grid as the layered map would
+    auto draw = [&](const cv::Rect& rect, const uint8_t value) {
+        cv_im(rect).setTo(cv::Scalar(value));
+        const int tile_size = gridmap::OccupancyGrid::TILE_SIZE;
+        std::vector<std::size_t> tiles;
+        for (int tile_y = rect.y / tile_size; tile_y <= (rect.y + rect.height - 1) / tile_size; ++tile_y)
+            for (int tile_x = rect.x / tile_size; tile_x <= (rect.x + rect.width - 1) / tile_size; ++tile_x)
+                tiles.push_back(static_cast<std::size_t>(tile_y * map_data->grid.tilesX() + tile_x));
+        map_data->grid.setTilesChanged(tiles);
+    };
+
+    draw(cv::Rect(500, 300, 60, 45), 255);
+    draw(cv::Rect(300, 400, 100, 101), 0);
+    draw(cv::Rect(size_x - 10, size_y - 10, 10, 10), 255);
+
+    // move the robot
+    const cv::Rect moved_footprint(footprint.x + 40, footprint.y, footprint.width, footprint.height);
+    const cv::Point moved_footprint_center(footprint_center.x + 40, footprint_center.y);
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<cv::Rect> changed = costmap.updateObstacleMap(*map_data, footprint);
+    cv::circle(costmap.obstacle_map, moved_footprint_center, radius_px, cv::Scalar(0), -1);
+    changed.push_back(moved_footprint);
+    costmap.processObstacleMap(changed);
+
+    const auto t1 = std::chrono::steady_clock::now();
+
+    astar_planner::Costmap expected(*map_data, robot_radius);
+    cv::circle(expected.obstacle_map, moved_footprint_center, radius_px, cv::Scalar(0), -1);
+    expected.processObstacleMap();
+
+    const auto t2 = std::chrono::steady_clock::now();
+
+    std::cout << "incremental: " << std::chrono::duration_cast<std::chrono::duration<double>>(t1 - t0).count()
+              << " full: " << std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count() << std::endl;
+
+    EXPECT_EQ(map_data->grid.version(), costmap.grid_version);
+
+    std::size_t mismatches = 0;
+    for (int y = 0; y < size_y; ++y)
+    {
+        for (int x = 0; x < size_x; ++x)
+        {
+            if (costmap.obstacle_map.at<uint8_t>(y, x) != expected.obstacle_map.at<uint8_t>(y, x) ||
+                costmap.distance_to_collision.at<float>(y, x) != expected.distance_to_collision.at<float>(y, x))
+                ++mismatches;
+        }
+    }
+    EXPECT_EQ(0, mismatches);
+}
+
+TEST_F(PlanningTest, test_dstar_lite)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(200, 400), cv::Point(900, 500), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(100, 600), cv::Point(800, 700), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(0, 0), cv::Point(140, 500), cv::Scalar(255), -1, cv::LINE_8);
+
+    const auto traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    astar_planner::Costmap costmap(*map_data, robot_radius);
+    costmap.processObstacleMap();
+    costmap.traversal_cost = traversal_cost;
+
+    const astar_planner::State2D start{200, 100};
+    const astar_planner::State2D goal{900, 900};
+
+    // the cost-to-go must match a fresh 2D search over the same costmap
+    auto check = [&](const astar_planner::DStarLite& dstar, const astar_planner::State2D& from) {
+        const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+        astar_planner::Explore2DCache explore_cache;
+        explore_cache.reset(costmap.width, costmap.height);
+        const astar_planner::ShortestPath2D expected =
+            astar_planner::shortestPath2D(from, goal, explore_cache, collision_checker);
+        ASSERT_TRUE(expected.success);
+        EXPECT_NEAR(expected.node->cost_so_far, dstar.costToGo(from), 1e-6 * expected.node->cost_so_far);
+
+        const std::vector<astar_planner::State2D> path = dstar.path(from);
+        ASSERT_FALSE(path.empty());
+        EXPECT_TRUE(path.front() == from);
+        EXPECT_TRUE(path.back() == goal);
+    };
+
+    astar_planner::DStarLite dstar;
+    {
+        const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+        dstar.reset(goal, collision_checker);
+        ASSERT_TRUE(dstar.computeShortestPath(start));
+        std::cout << "initial expansions: " << dstar.expansions() << std::endl;
+        check(dstar, start);
+    }
+
+    // narrow a corridor and move the start
+    const astar_planner::State2D moved_start{260, 120};
+    {
+        const cv::Rect region(500, 300, 61, 46);
+        cv_im(region).setTo(cv::Scalar(255));
+        cv_im(region).copyTo(costmap.obstacle_map(region));
+        const std::vector<cv::Rect> changed = costmap.processObstacleMap({region});
+
+        const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+        const std::size_t changed_cells = dstar.updateCellCosts(collision_checker, changed);
+        ASSERT_TRUE(dstar.computeShortestPath(moved_start));
+        std::cout << "changed cells: " << changed_cells << " repair expansions: " << dstar.expansions() << std::endl;
+        check(dstar, moved_start);
+    }
+
+    // and clear it again
+    {
+        const cv::Rect region(500, 300, 61, 46);
+        cv_im(region).setTo(cv::Scalar(0));
+        cv_im(region).copyTo(costmap.obstacle_map(region));
+        const std::vector<cv::Rect> changed = costmap.processObstacleMap({region});
+
+        const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+        const std::size_t changed_cells = dstar.updateCellCosts(collision_checker, changed);
+        ASSERT_TRUE(dstar.computeShortestPath(moved_start));
+        std::cout << "changed cells: " << changed_cells << " repair expansions: " << dstar.expansions() << std::endl;
+        check(dstar, moved_start);
+    }
+}
+
+TEST_F(PlanningTest, test_dstar_lite_freed_cells)
+{
+    // a wall with a gap near the start and goal and one far from them
+    cv::rectangle(cv_im, cv::Point(0, 400), cv::Point(1000, 500), cv::Scalar(255), -1, cv::LINE_8);
+    cv_im(cv::Rect(800, 400, 150, 101)).setTo(cv::Scalar(0));
+
+    // the near gap is closed when the search starts
+    const cv::Rect region(100, 400, 150, 101);
+
+    astar_planner::Costmap costmap(*map_data, robot_radius);
+    costmap.processObstacleMap();
+    costmap.traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const astar_planner::State2D start{150, 100};
+    const astar_planner::State2D goal{150, 900};
+
+    auto fresh = [&](const astar_planner::State2D& from) {
+        const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+        astar_planner::DStarLite dstar;
+        dstar.reset(goal, collision_checker);
+        EXPECT_TRUE(dstar.computeShortestPath(from));
+        return dstar.costToGo(from);
+    };
+
+    astar_planner::DStarLite dstar;
+    {
+        const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+        dstar.reset(goal, collision_checker);
+        ASSERT_TRUE(dstar.computeShortestPath(start));
+    }
+    const double blocked_cost = dstar.costToGo(start);
+    EXPECT_NEAR(fresh(start), blocked_cost, 1e-6 * blocked_cost);
+
+    // opening it again gives the route through it
+    cv_im(region).setTo(cv::Scalar(0));
+    cv_im(region).copyTo(costmap.obstacle_map(region));
+    const std::vector<cv::Rect> changed = costmap.processObstacleMap({region});
+    {
+        const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+        EXPECT_GT(dstar.updateCellCosts(collision_checker, changed), 0);
+        ASSERT_TRUE(dstar.computeShortestPath(start));
+    }
+    const double open_cost = dstar.costToGo(start);
+    std::cout << "blocked: " << blocked_cost << " open: " << open_cost << std::endl;
+    EXPECT_LT(open_cost, blocked_cost);
+    EXPECT_NEAR(fresh(start), open_cost, 1e-6 * open_cost);
+
+    const std::vector<astar_planner::State2D> path = dstar.path(start);
+    ASSERT_FALSE(path.empty());
+    EXPECT_TRUE(std::any_of(path.begin(), path.end(), [&](const astar_planner::State2D& s) {
+        return region.contains(cv::Point(s.x, s.y));
+    }));
+
+    // cells blocked by their own cost alone, the cells around them keep theirs
+    const cv::Rect gap(150, 400, 100, 101);
+    (*costmap.traversal_cost)(gap).setTo(cv::Scalar(std::numeric_limits<float>::infinity()));
+    {
+        const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+        dstar.reset(goal, collision_checker);
+        ASSERT_TRUE(dstar.computeShortestPath(start));
+    }
+    EXPECT_GT(dstar.costToGo(start), open_cost);
+
+    (*costmap.traversal_cost)(gap).setTo(cv::Scalar(1.0));
+    {
+        const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+        EXPECT_GT(dstar.updateCellCosts(collision_checker, {gap}), 0);
+        ASSERT_TRUE(dstar.computeShortestPath(start));
+    }
+    EXPECT_NEAR(open_cost, dstar.costToGo(start), 1e-6 * open_cost);
+}
+
+TEST_F(PlanningTest, test_batch_clearance)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(200, 400), cv::Point(900, 500), cv::Scalar(255), -1, cv::LINE_8);
+
+    astar_planner::Costmap costmap(*map_data, robot_radius);
+    costmap.processObstacleMap();
+    const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+
+    // states over the whole map and past its edges, some exactly on cell boundaries
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> position(-11.0, 11.0);
+    std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+    std::vector<astar_planner::State3D> states;
+    for (int i = 0; i < 10001; ++i)
+        states.push_back({position(gen), position(gen), heading(gen)});
+    for (int i = 0; i < 100; ++i)
+        states.push_back({(i - 50) * resolution / 2, (50 - i) * resolution / 2, 0});
+
+    astar_planner::ClearanceBatch batch;
+    for (const auto& state : states)
+        batch.add(state);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    collision_checker.clearance(batch);
+    const auto t1 = std::chrono::steady_clock::now();
+
+    ASSERT_EQ(states.size(), batch.clearance.size());
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+        if (batch.clearance[i] != collision_checker.clearance(states[i]))
+            ++mismatches;
+    }
+    const auto t2 = std::chrono::steady_clock::now();
+
+    std::cout << "batch: " << std::chrono::duration_cast<std::chrono::duration<double>>(t1 - t0).count()
+              << " single: " << std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1).count() << std::endl;
+
+    EXPECT_EQ(0, mismatches);
+}
+
+TEST_F(PlanningTest, test_cspace)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(200, 400), cv::Point(900, 500), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(0, 0), cv::Point(140, 500), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const auto t0 = std::chrono::steady_clock::now();
+    auto cspace = std::make_shared<astar_planner::CSpace>(angular_resolution, offsets);
+    cspace->build(*costmap);
+    const auto t1 = std::chrono::steady_clock::now();
+    std::cout << "cspace build: " << std::chrono::duration_cast<std::chrono::duration<double>>(t1 - t0).count()
+              << std::endl;
+
+    // a set bit must always agree with the footprint check
+    {
+        const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+        const astar_planner::CollisionChecker cspace_checker(*costmap, offsets, conservative_radius, cspace);
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> position(-10.0, 10.0);
+        std::uniform_int_distribution<int> heading(-16, 16);
+        std::size_t blocked = 0;
+        std::size_t in_collision = 0;
+        for (int i = 0; i < 100000; ++i)
+        {
+            const astar_planner::State3D state{position(gen), position(gen), heading(gen) * angular_resolution};
+            const bool valid = collision_checker.isValid(state);
+            if (cspace_checker.inCSpaceCollision(state))
+            {
+                ++blocked;
+                EXPECT_FALSE(valid);
+            }
+            if (!valid)
+                ++in_collision;
+            EXPECT_EQ(valid, cspace_checker.isValid(state));
+        }
+        std::cout << "in collision: " << in_collision << " blocked by cspace: " << blocked << std::endl;
+        EXPECT_GT(blocked, in_collision / 2);
+    }
+
+    // the same search with and without the layers
+    {
+        const Eigen::Isometry2d start = Eigen::Translation2d(-5.0, -8.0) * Eigen::Rotation2Dd(0);
+        const Eigen::Isometry2d goal = Eigen::Translation2d(5.0, 5.0) * Eigen::Rotation2Dd(M_PI / 2);
+        const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+        const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+        const astar_planner::PathResult expected = astar_planner::hybridAStar(
+            start, goal, max_iterations, collision_checker, linear_resolution, angular_resolution, goal_sample_settings,
+            backwards_mult, strafe_mult, rotation_mult);
+
+        const astar_planner::CollisionChecker cspace_checker(*costmap, offsets, conservative_radius, cspace);
+        const astar_planner::PathResult result = astar_planner::hybridAStar(
+            start, goal, max_iterations, cspace_checker, linear_resolution, angular_resolution, goal_sample_settings,
+            backwards_mult, strafe_mult, rotation_mult);
+
+        ASSERT_TRUE(expected.success);
+        ASSERT_TRUE(result.success);
+        ASSERT_EQ(expected.path.size(), result.path.size());
+        EXPECT_EQ(expected.path.front()->cost_so_far, result.path.front()->cost_so_far);
+        EXPECT_EQ(expected.iterations, result.iterations);
+    }
+
+    // updating the changed regions must give the same layers as building them again
+    {
+        cv::rectangle(costmap->obstacle_map, cv::Point(600, 600), cv::Point(700, 650), cv::Scalar(255), -1);
+        cv::rectangle(costmap->obstacle_map, cv::Point(200, 400), cv::Point(300, 500), cv::Scalar(0), -1);
+        const std::vector<cv::Rect> changed =
+            costmap->processObstacleMap({cv::Rect(600, 600, 101, 51), cv::Rect(200, 400, 101, 101)});
+
+        cspace->update(*costmap, changed);
+
+        astar_planner::CSpace expected(angular_resolution, offsets);
+        expected.build(*costmap);
+
+        std::size_t mismatches = 0;
+        for (int theta_index = -16; theta_index <= 16; ++theta_index)
+            for (int y = 0; y < size_y; ++y)
+                for (int x = 0; x < size_x; ++x)
+                    if (cspace->blocked(x, y, theta_index) != expected.blocked(x, y, theta_index))
+                        ++mismatches;
+
+        EXPECT_EQ(0, mismatches);
+    }
+}
+
+TEST_F(PlanningTest, test_parallel_search)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(200, 400), cv::Point(900, 500), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(0, 0), cv::Point(140, 500), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-5.0, -8.0) * Eigen::Rotation2Dd(0);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(5.0, 5.0) * Eigen::Rotation2Dd(M_PI / 2);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    auto plan = [&](const int threads) {
+        const auto thread_pool = threads > 1 ? std::make_shared<astar_planner::ThreadPool>(threads) : nullptr;
+        const auto t0 = std::chrono::steady_clock::now();
+        astar_planner::SearchOptions options;
+        options.thread_pool = thread_pool;
+        astar_planner::PathResult result = astar_planner::hybridAStar(
+            start, {goal}, max_iterations, collision_checker, linear_resolution, angular_resolution,
+            goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options);
+        std::cout << "threads: " << threads << " took: "
+                  << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
+                         .count()
+                  << " iterations: " << result.iterations << std::endl;
+        return result;
+    };
+
+    const astar_planner::PathResult expected = plan(1);
+    ASSERT_TRUE(expected.success);
+
+    // the number of threads must not change the search
+    for (const int threads : {2, 8})
+    {
+        const astar_planner::PathResult result = plan(threads);
+        ASSERT_TRUE(result.success);
+        EXPECT_EQ(expected.iterations, result.iterations);
+        EXPECT_EQ(expected.explore_3d.size(), result.explore_3d.size());
+        ASSERT_EQ(expected.path.size(), result.path.size());
+        for (std::size_t i = 0; i < expected.path.size(); ++i)
+        {
+            EXPECT_EQ(expected.path[i]->state.x, result.path[i]->state.x);
+            EXPECT_EQ(expected.path[i]->state.y, result.path[i]->state.y);
+            EXPECT_EQ(expected.path[i]->state.theta, result.path[i]->state.theta);
+            EXPECT_EQ(expected.path[i]->cost_so_far, result.path[i]->cost_so_far);
+        }
+    }
+}
+
+TEST_F(PlanningTest, test_analytic_expansion)
+{
+    cv::circle(cv_im, cv::Point(500, 470), static_cast<int>(0.3 / resolution), cv::Scalar(255), -1);
+    cv::rectangle(cv_im, cv::Point(200, 600), cv::Point(800, 650), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-3.0, -1.0) * Eigen::Rotation2Dd(0);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(4.0, 4.0) * Eigen::Rotation2Dd(M_PI / 4);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    auto plan = [&](const astar_planner::AnalyticExpansionSettings& analytic_expansion) {
+        const auto t0 = std::chrono::steady_clock::now();
+        astar_planner::SearchOptions options;
+        options.analytic_expansion = analytic_expansion;
+        astar_planner::PathResult result = astar_planner::hybridAStar(
+            start, {goal}, max_iterations, collision_checker, linear_resolution, angular_resolution,
+            goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options);
+        std::cout << "planner took: "
+                  << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
+                         .count()
+                  << " iterations: " << result.iterations << " analytic expansions: " << result.analytic_expansions
+                  << std::endl;
+        return result;
+    };
+
+    const astar_planner::PathResult expected = plan({});
+    ASSERT_TRUE(expected.success);
+    EXPECT_FALSE(expected.analytic_success);
+    EXPECT_EQ(0, expected.analytic_expansions);
+
+    const astar_planner::PathResult result = plan({50, 1.0, 1.1});
+    ASSERT_TRUE(result.success);
+    EXPECT_TRUE(result.analytic_success);
+    EXPECT_LT(result.iterations, expected.iterations);
+
+    // the path still runs from start to the goal through valid states
+    const astar_planner::State3D goal_state{4.0, 4.0, M_PI / 4};
+    EXPECT_EQ(goal_state.x, result.path.front()->state.x);
+    EXPECT_EQ(goal_state.y, result.path.front()->state.y);
+    EXPECT_NEAR(goal_state.theta, result.path.front()->state.theta, 1e-9);
+    EXPECT_EQ(nullptr, result.path.back()->parent);
+    for (std::size_t i = 0; i < result.path.size(); ++i)
+    {
+        EXPECT_TRUE(collision_checker.isValid(result.path[i]->state));
+        if (i + 1 < result.path.size())
+        {
+            EXPECT_EQ(result.path[i + 1], result.path[i]->parent);
+            EXPECT_GE(result.path[i]->cost_so_far, result.path[i + 1]->cost_so_far);
+            EXPECT_LT(astar_planner::linearDistance(result.path[i]->state, result.path[i + 1]->state), 0.5);
+        }
+    }
+
+    std::cout << "cost: " << result.path.front()->cost_so_far << " expected: " << expected.path.front()->cost_so_far
+              << std::endl;
+    EXPECT_LT(result.path.front()->cost_so_far, 1.1 * expected.path.front()->cost_so_far);
+}
+
+TEST_F(PlanningTest, test_anytime)
+{
+    cv::circle(cv_im, cv::Point(500, 470), static_cast<int>(0.3 / resolution), cv::Scalar(255), -1);
+    cv::rectangle(cv_im, cv::Point(200, 600), cv::Point(800, 650), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-3.0, -1.0) * Eigen::Rotation2Dd(0);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(4.0, 4.0) * Eigen::Rotation2Dd(M_PI / 2);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    const astar_planner::PathResult expected =
+        astar_planner::hybridAStar(start, goal, max_iterations, collision_checker, linear_resolution,
+                                   angular_resolution, goal_sample_settings, backwards_mult, strafe_mult,
+                                   rotation_mult);
+    ASSERT_TRUE(expected.success);
+    EXPECT_EQ(1, expected.searches);
+
+    auto plan = [&](const std::chrono::steady_clock::time_point& deadline, const std::size_t iterations,
+                    const std::size_t first_iterations) {
+        const auto t0 = std::chrono::steady_clock::now();
+        astar_planner::PathResult result = astar_planner::anytimeHybridAStar(
+            start, {goal}, deadline, {3.0, 0.5, first_iterations}, iterations, collision_checker, linear_resolution,
+            angular_resolution, goal_sample_settings, backwards_mult, strafe_mult, rotation_mult);
+        std::cout << "planner took: "
+                  << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
+                         .count()
+                  << " iterations: " << result.iterations << " searches: " << result.searches
+                  << " weight: " << result.weight << std::endl;
+        return result;
+    };
+
+    const auto later = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+
+    // the inflated first search finds a path long before the plain search does
+    const astar_planner::PathResult first = plan(later, expected.iterations / 4, expected.iterations / 4);
+    ASSERT_TRUE(first.success);
+    EXPECT_GT(first.weight, 1.0);
+
+    // given enough time the searches end with the plain heuristic
+    const astar_planner::PathResult result = plan(later, max_iterations, max_iterations);
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(5, result.searches);
+    EXPECT_EQ(1.0, result.weight);
+    EXPECT_LE(result.path.front()->cost_so_far, first.path.front()->cost_so_far);
+    EXPECT_LT(result.path.front()->cost_so_far, 1.05 * expected.path.front()->cost_so_far);
+
+    std::cout << "cost: " << result.path.front()->cost_so_far << " first: " << first.path.front()->cost_so_far
+              << " expected: " << expected.path.front()->cost_so_far << std::endl;
+
+    EXPECT_EQ(nullptr, result.path.back()->parent);
+    EXPECT_EQ(start.translation().x(), result.path.back()->state.x);
+    EXPECT_EQ(start.translation().y(), result.path.back()->state.y);
+    for (std::size_t i = 0; i < result.path.size(); ++i)
+    {
+        EXPECT_TRUE(collision_checker.isValid(result.path[i]->state));
+        if (i + 1 < result.path.size())
+        {
+            EXPECT_EQ(result.path[i + 1], result.path[i]->parent);
+            EXPECT_GE(result.path[i]->cost_so_far, result.path[i + 1]->cost_so_far);
+        }
+    }
+
+    // a deadline which passed before the first path ends the first search without one
+    const astar_planner::PathResult expired = plan(std::chrono::steady_clock::now(), max_iterations, max_iterations);
+    EXPECT_FALSE(expired.success);
+    EXPECT_TRUE(expired.out_of_time);
+    EXPECT_EQ(1, expired.searches);
+    EXPECT_LE(expired.iterations, 64u);
+
+    // the first search gets fewer iterations than the searches after it
+    const astar_planner::PathResult short_first = plan(later, max_iterations, 100);
+    EXPECT_FALSE(short_first.success);
+    EXPECT_FALSE(short_first.out_of_time);
+    EXPECT_EQ(1, short_first.searches);
+    EXPECT_LE(short_first.iterations, 101u);
+}
+
+TEST_F(PlanningTest, test_corridor)
+{
+    cv::rectangle(cv_im, cv::Point(0, 250), cv::Point(700, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(300, 500), cv::Point(1000, 550), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(0, 750), cv::Point(700, 800), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-8.0, -8.0) * Eigen::Rotation2Dd(0);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(-8.0, 8.0) * Eigen::Rotation2Dd(0);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    auto plan = [&](const astar_planner::CollisionChecker& checker) {
+        const auto t0 = std::chrono::steady_clock::now();
+        astar_planner::PathResult result =
+            astar_planner::hybridAStar(start, goal, max_iterations, checker, linear_resolution, angular_resolution,
+                                       goal_sample_settings, backwards_mult, strafe_mult, rotation_mult);
+        std::cout << "planner took: "
+                  << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
+                         .count()
+                  << " iterations: " << result.iterations << std::endl;
+        return result;
+    };
+
+    const astar_planner::PathResult expected = plan(collision_checker);
+    ASSERT_TRUE(expected.success);
+
+    const astar_planner::OccupancyPyramid pyramid(collision_checker, 5);
+    ASSERT_EQ(5, pyramid.levels());
+    for (int level = 1; level < pyramid.levels(); ++level)
+    {
+        const cv::Mat& fine = pyramid.blocked(level - 1);
+        const cv::Mat& coarse = pyramid.blocked(level);
+        ASSERT_EQ((fine.cols + 1) / 2, coarse.cols);
+        ASSERT_EQ((fine.rows + 1) / 2, coarse.rows);
+        for (int y = 0; y < fine.rows; ++y)
+        {
+            for (int x = 0; x < fine.cols; ++x)
+            {
+                if (fine.at<uint8_t>(y, x))
+                    ASSERT_TRUE(coarse.at<uint8_t>(y / 2, x / 2));
+            }
+        }
+    }
+
+    const Eigen::Array2i start_cell = costmap->getCellIndex(start.translation());
+    const Eigen::Array2i goal_cell = costmap->getCellIndex(goal.translation());
+    const astar_planner::Corridor corridor =
+        astar_planner::findCorridor(pyramid, {start_cell.x(), start_cell.y()}, {goal_cell.x(), goal_cell.y()}, 4,
+                                    static_cast<int>(0.5 / resolution));
+    ASSERT_TRUE(corridor.success);
+    EXPECT_EQ(4, corridor.level);
+    EXPECT_TRUE(corridor.mask.at<uint8_t>(start_cell.y(), start_cell.x()));
+    EXPECT_TRUE(corridor.mask.at<uint8_t>(goal_cell.y(), goal_cell.x()));
+    std::cout << "corridor iterations: " << corridor.iterations << " cells: " << corridor.path.size() << std::endl;
+
+    const astar_planner::Costmap restricted = astar_planner::restrictToCorridor(*costmap, corridor.mask);
+    const astar_planner::CollisionChecker corridor_checker(restricted, offsets, conservative_radius);
+
+    const astar_planner::PathResult result = plan(corridor_checker);
+    ASSERT_TRUE(result.success);
+    EXPECT_LT(result.iterations, expected.iterations);
+
+    // the path stays within the corridor and is valid on the whole map
+    for (const astar_planner::Node3D* node : result.path)
+    {
+        const Eigen::Array2i cell = costmap->getCellIndex({node->state.x, node->state.y});
+        EXPECT_TRUE(corridor.mask.at<uint8_t>(cell.y(), cell.x()));
+        EXPECT_TRUE(collision_checker.isValid(node->state));
+    }
+
+    std::cout << "cost: " << result.path.front()->cost_so_far << " expected: " << expected.path.front()->cost_so_far
+              << std::endl;
+    EXPECT_LT(result.path.front()->cost_so_far, 1.2 * expected.path.front()->cost_so_far);
+}
+
+TEST_F(PlanningTest, test_lazy_evaluation)
+{
+    cv::circle(cv_im, cv::Point(500, 470), static_cast<int>(0.3 / resolution), cv::Scalar(255), -1);
+    cv::rectangle(cv_im, cv::Point(200, 600), cv::Point(800, 650), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    // the lazily queued successors are ordered by the straight line over the cheapest cells
+    costmap->min_traversal_cost = 1.0;
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-3.0, -1.0) * Eigen::Rotation2Dd(0);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(4.0, 4.0) * Eigen::Rotation2Dd(M_PI / 2);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    auto plan = [&](const bool lazy_evaluation) {
+        const auto t0 = std::chrono::steady_clock::now();
+        astar_planner::SearchOptions options;
+        options.lazy_evaluation = lazy_evaluation;
+        astar_planner::PathResult result = astar_planner::hybridAStar(
+            start, {goal}, max_iterations, collision_checker, linear_resolution, angular_resolution,
+            goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options);
+        std::cout << "planner took: "
+                  << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
+                         .count()
+                  << " iterations: " << result.iterations << " collision checks: " << result.collision_checks
+                  << " saved: " << result.collision_checks_saved << std::endl;
+        return result;
+    };
+
+    const astar_planner::PathResult expected = plan(false);
+    ASSERT_TRUE(expected.success);
+    EXPECT_GT(expected.collision_checks, 0);
+    EXPECT_EQ(0, expected.collision_checks_saved);
+
+    const astar_planner::PathResult result = plan(true);
+    ASSERT_TRUE(result.success);
+    EXPECT_LT(result.collision_checks, expected.collision_checks);
+    EXPECT_GT(result.collision_checks_saved, 0);
+
+    // every state of the path was checked before it was expanded
+    EXPECT_EQ(nullptr, result.path.back()->parent);
+    for (std::size_t i = 0; i < result.path.size(); ++i)
+    {
+        EXPECT_FALSE(result.path[i]->lazy);
+        EXPECT_TRUE(collision_checker.isValid(result.path[i]->state));
+        if (i + 1 < result.path.size())
+        {
+            EXPECT_EQ(result.path[i + 1], result.path[i]->parent);
+            EXPECT_GE(result.path[i]->cost_so_far, result.path[i + 1]->cost_so_far);
+        }
+    }
+
+    std::cout << "cost: " << result.path.front()->cost_so_far << " expected: " << expected.path.front()->cost_so_far
+              << std::endl;
+    EXPECT_NEAR(result.path.front()->cost_so_far, expected.path.front()->cost_so_far, 1e-6);
+}
+
+TEST_F(PlanningTest, test_heuristic_table)
+{
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+    costmap->min_traversal_cost = 1.0;
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto table = std::make_shared<const astar_planner::HeuristicTable>(astar_planner::HeuristicTable::Settings{
+        linear_resolution, angular_resolution, backwards_mult, strafe_mult, rotation_mult, 2.0});
+    std::cout << "table took: "
+              << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
+                     .count()
+              << std::endl;
+
+    // the file holds the same table
+    const std::string path = "/tmp/astar_planner_heuristic_table.bin";
+    ASSERT_TRUE(table->save(path));
+    const auto loaded = astar_planner::HeuristicTable::load(path);
+    ASSERT_TRUE(loaded);
+    EXPECT_TRUE(loaded->matches(linear_resolution, angular_resolution, backwards_mult, strafe_mult, rotation_mult));
+    EXPECT_FALSE(
+        loaded->matches(linear_resolution, angular_resolution, 2 * backwards_mult, strafe_mult, rotation_mult));
+    EXPECT_EQ(table->halfCells(), loaded->halfCells());
+    EXPECT_EQ(table->headings(), loaded->headings());
+
+    const astar_planner::State3D goal_state{1.0, 0.5, M_PI / 2};
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> offset(-2.5, 2.5);
+    for (int i = 0; i < 100; ++i)
+    {
+        const astar_planner::State3D state{goal_state.x + offset(gen), goal_state.y + offset(gen), offset(gen)};
+        EXPECT_EQ(table->costToGo(state, goal_state), loaded->costToGo(state, goal_state));
+        EXPECT_GE(table->costToGo(state, goal_state), 0);
+    }
+    EXPECT_EQ(0, table->costToGo(goal_state, goal_state));
+    EXPECT_NEAR(3.0 - 2 * linear_resolution,
+                table->costToGo({goal_state.x + 3.0, goal_state.y, goal_state.theta}, goal_state), 1e-6);
+    EXPECT_FALSE(astar_planner::HeuristicTable::load("/tmp/astar_planner_no_heuristic_table.bin"));
+
+    // turning around and strafing are not seen by the 2D heuristic
+    const Eigen::Isometry2d start = Eigen::Translation2d(0.0, 0.0) * Eigen::Rotation2Dd(0);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(0.0, 1.0) * Eigen::Rotation2Dd(M_PI);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    auto plan = [&](const std::shared_ptr<const astar_planner::HeuristicTable>& heuristic_table) {
+        const auto t0 = std::chrono::steady_clock::now();
+        astar_planner::SearchOptions options;
+        options.heuristic_table = heuristic_table;
+        astar_planner::PathResult result = astar_planner::hybridAStar(
+            start, {goal}, max_iterations, collision_checker, linear_resolution, angular_resolution,
+            goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options);
+        std::cout << "planner took: "
+                  << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
+                         .count()
+                  << " iterations: " << result.iterations << std::endl;
+        return result;
+    };
+
+    const astar_planner::PathResult expected = plan(nullptr);
+    ASSERT_TRUE(expected.success);
+
+    const astar_planner::PathResult result = plan(loaded);
+    ASSERT_TRUE(result.success);
+    EXPECT_LT(result.iterations, expected.iterations);
+
+    std::cout << "cost: " << result.path.front()->cost_so_far << " expected: " << expected.path.front()->cost_so_far
+              << std::endl;
+    EXPECT_NEAR(result.path.front()->cost_so_far, expected.path.front()->cost_so_far, 1e-6);
+
+    // the table never exceeds the cost the search finds, for starts on the lattice in every frame of the goal
+    std::uniform_int_distribution<int> cell(-25, 25);
+    std::uniform_int_distribution<int> heading_bin(-15, 16);
+    for (int i = 0; i < 12; ++i)
+    {
+        const Eigen::Isometry2d sample_start =
+            Eigen::Translation2d(cell(gen) * linear_resolution, cell(gen) * linear_resolution) *
+            Eigen::Rotation2Dd(heading_bin(gen) * angular_resolution);
+        const Eigen::Isometry2d sample_goal = Eigen::Translation2d(0.5 + cell(gen) * 0.01, 0.5 + cell(gen) * 0.01) *
+                                              Eigen::Rotation2Dd(heading_bin(gen) * angular_resolution);
+        const astar_planner::PathResult sample_result = astar_planner::hybridAStar(
+            sample_start, sample_goal, max_iterations, collision_checker, linear_resolution, angular_resolution,
+            goal_sample_settings, backwards_mult, strafe_mult, rotation_mult);
+        ASSERT_TRUE(sample_result.success);
+
+        const astar_planner::State3D start_state{sample_start.translation().x(), sample_start.translation().y(),
+                                                 Eigen::Rotation2Dd(sample_start.linear()).smallestAngle()};
+        const astar_planner::State3D sample_goal_state{sample_goal.translation().x(), sample_goal.translation().y(),
+                                                       Eigen::Rotation2Dd(sample_goal.linear()).smallestAngle()};
+        EXPECT_LE(loaded->costToGo(start_state, sample_goal_state), sample_result.path.front()->cost_so_far + 1e-6);
+    }
+}
+
+TEST_F(PlanningTest, test_landmarks)
+{
+    cv::rectangle(cv_im, cv::Point(0, 250), cv::Point(700, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(300, 500), cv::Point(1000, 550), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(0, 750), cv::Point(700, 800), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+    // the first candidate is taken as it is, blocked candidates are skipped
+    const auto t0 = std::chrono::steady_clock::now();
+    const astar_planner::State2D first{500, 100};
+    const astar_planner::State2D blocked{500, 275};
+    const astar_planner::State2D second{900, 900};
+    const auto landmarks = std::make_shared<const astar_planner::Landmarks>(
+        collision_checker, std::vector<astar_planner::State2D>{first, blocked, second}, 8);
+    std::cout << "landmarks took: "
+              << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
+                     .count()
+              << std::endl;
+    ASSERT_EQ(8, landmarks->size());
+    EXPECT_TRUE(landmarks->cells()[0] == first);
+    EXPECT_TRUE(landmarks->cells()[1] == second);
+
+    const astar_planner::State2D start{100, 100};
+    const astar_planner::State2D goal{100, 900};
+
+    // never more than the cost of the 2D search
+    {
+        auto explore_cache = std::make_shared<astar_planner::Explore2DCache>();
+        astar_planner::updateExplore2DCache(*explore_cache, goal, collision_checker);
+        astar_planner::wavefront2D(goal, *explore_cache, collision_checker);
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> x(0, size_x - 1);
+        std::uniform_int_distribution<int> y(0, size_y - 1);
+        for (int i = 0; i < 1000; ++i)
+        {
+            const astar_planner::State2D cell{x(gen), y(gen)};
+            const astar_planner::Node2D* node = explore_cache->find(costmap->to2DGridIndex(cell));
+            if (!node || node->cost_so_far == std::numeric_limits<double>::max())
+                continue;
+            EXPECT_LE(landmarks->lowerBound(goal, landmarks->distances(cell)), node->cost_so_far + 1e-6);
+        }
+    }
+
+    const auto t1 = std::chrono::steady_clock::now();
+    astar_planner::Explore2DCache explore_cache;
+    explore_cache.reset(costmap->width, costmap->height);
+    const astar_planner::ShortestPath2D expected =
+        astar_planner::shortestPath2D(start, goal, explore_cache, collision_checker);
+    ASSERT_TRUE(expected.success);
+    std::cout << "took: "
+              << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t1)
+                     .count()
+              << " iterations: " << expected.iterations << std::endl;
+
+    const auto t2 = std::chrono::steady_clock::now();
+    explore_cache.reset(costmap->width, costmap->height);
+    explore_cache.landmarks = landmarks;
+    const astar_planner::ShortestPath2D result =
+        astar_planner::shortestPath2D(start, goal, explore_cache, collision_checker);
+    ASSERT_TRUE(result.success);
+    std::cout << "took: "
+              << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t2)
+                     .count()
+              << " iterations: " << result.iterations << std::endl;
+
+    EXPECT_LT(result.iterations, 3 * expected.iterations / 4);
+    EXPECT_NEAR(expected.node->cost_so_far, result.node->cost_so_far, 1e-3 * expected.node->cost_so_far);
+
+    // landmarks of the costs without obstacles, as the planner computes them, bound the costs whatever the obstacles
+    cv::rectangle(*costmap->traversal_cost, cv::Point(200, 300), cv::Point(600, 500), cv::Scalar(3.0), -1);
+    astar_planner::Costmap free_costmap(cv::Mat::zeros(size_y, size_x, CV_8U), resolution, costmap->origin_x,
+                                        costmap->origin_y, robot_radius);
+    free_costmap.processObstacleMap();
+    free_costmap.traversal_cost = costmap->traversal_cost;
+    const astar_planner::CollisionChecker free_checker(free_costmap, offsets, conservative_radius);
+    const astar_planner::Landmarks free_landmarks(free_checker, {first, second}, 8);
+    {
+        auto explore_cache = std::make_shared<astar_planner::Explore2DCache>();
+        astar_planner::updateExplore2DCache(*explore_cache, goal, collision_checker);
+        astar_planner::wavefront2D(goal, *explore_cache, collision_checker);
+
+        std::size_t checked = 0;
+        for (int y = 0; y < size_y; y += 7)
+        {
+            for (int x = 0; x < size_x; x += 7)
+            {
+                const astar_planner::Node2D* node = explore_cache->find(costmap->to2DGridIndex({x, y}));
+                if (!node || node->cost_so_far == std::numeric_limits<double>::max())
+                    continue;
+                EXPECT_LE(free_landmarks.lowerBound(goal, free_landmarks.distances({x, y})), node->cost_so_far + 1e-6);
+                ++checked;
+            }
+        }
+        EXPECT_GT(checked, 0);
+    }
+}
+
+TEST_F(PlanningTest, test_uniform_pruning)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(100, 600), cv::Point(800, 700), cv::Scalar(255), -1, cv::LINE_8);
+
+    const auto traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+    cv::rectangle(*traversal_cost, cv::Point(400, 800), cv::Point(600, 900), cv::Scalar(4.0), -1, cv::LINE_8);
+
+    auto make_costmap = [&]() {
+        auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+        costmap->processObstacleMap();
+        costmap->traversal_cost = traversal_cost;
+        return costmap;
+    };
+
+    const astar_planner::State2D goal{900, 100};
+    auto explore_cache = std::make_shared<astar_planner::Explore2DCache>();
+
+    // the costs of the resumed search with the uniform regions pruned are those of the wavefront
+    auto check_costs = [&](const astar_planner::CollisionChecker& collision_checker) {
+        astar_planner::Explore2DCache expected;
+        astar_planner::updateExplore2DCache(expected, goal, collision_checker);
+        astar_planner::wavefront2D(goal, expected, collision_checker);
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> x(0, size_x - 1);
+        std::uniform_int_distribution<int> y(0, size_y - 1);
+        std::size_t checked = 0;
+        std::size_t mismatches = 0;
+        for (int i = 0; i < 200; ++i)
+        {
+            const astar_planner::State2D cell{x(gen), y(gen)};
+            const astar_planner::Node2D* node = expected.find(collision_checker.costmap().to2DGridIndex(cell));
+            const astar_planner::ShortestPath2D result =
+                astar_planner::shortestPath2D(cell, goal, *explore_cache, collision_checker);
+            if (!result.success)
+                continue;
+
+            ++checked;
+            if (std::abs(result.node->cost_so_far - node->cost_so_far) > 1e-6 * std::max(1.0, node->cost_so_far))
+                ++mismatches;
+        }
+        EXPECT_GT(checked, 100);
+        EXPECT_EQ(0, mismatches);
+    };
+
+    {
+        auto costmap = make_costmap();
+        const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+        astar_planner::updateExplore2DCache(*explore_cache, goal, collision_checker);
+        check_costs(collision_checker);
+    }
+
+    // the parents of the nodes re-seeded after a change are expanded again before anything is skipped
+    cv::rectangle(cv_im, cv::Point(500, 400), cv::Point(560, 500), cv::Scalar(255), -1, cv::LINE_8);
+    {
+        auto costmap = make_costmap();
+        const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+        EXPECT_GT(astar_planner::updateExplore2DCache(*explore_cache, goal, collision_checker), 0);
+        check_costs(collision_checker);
+    }
+}
+
+TEST_F(PlanningTest, test_path_cost)
+{
+    cv::rectangle(cv_im, cv::Point(200, 560), cv::Point(800, 600), cv::Scalar(255), -1, cv::LINE_8);
+
+    const auto traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+    cv::rectangle(*traversal_cost, cv::Point(300, 400), cv::Point(400, 600), cv::Scalar(4.0), -1, cv::LINE_8);
+
+    // mark the tiles under a change to the grid as the layered map would
+    auto draw = [&](const cv::Rect& rect) {
+        cv_im(rect).setTo(cv::Scalar(255));
+        const int tile_size = gridmap::OccupancyGrid::TILE_SIZE;
+        std::vector<std::size_t> tiles;
+        for (int tile_y = rect.y / tile_size; tile_y <= (rect.y + rect.height - 1) / tile_size; ++tile_y)
+            for (int tile_x = rect.x / tile_size; tile_x <= (rect.x + rect.width - 1) / tile_size; ++tile_x)
+                tiles.push_back(static_cast<std::size_t>(tile_y * map_data->grid.tilesX() + tile_x));
+        map_data->grid.setTilesChanged(tiles);
+    };
+
+    navigation_interface::Path path;
+    for (int i = 0; i <= 400; ++i)
+        path.nodes.push_back(Eigen::Translation2d(-8.0 + i * 0.04, 0.3 * std::sin(i * 0.05)) *
+                             Eigen::Rotation2Dd(0.5 * std::sin(i * 0.03)));
+
+    astar_planner::Costmap costmap(*map_data, robot_radius);
+    costmap.processObstacleMap();
+    costmap.traversal_cost = traversal_cost;
+    const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+
+    // the same cost as pathCost on a fresh costmap, only the segments near a change to the map are costed again
+    auto check_cost = [&](astar_planner::PathCostCache& cache) {
+        astar_planner::Costmap expected(*map_data, robot_radius);
+        expected.processObstacleMap();
+        expected.traversal_cost = traversal_cost;
+        const astar_planner::CollisionChecker expected_checker(expected, offsets, conservative_radius);
+
+        const double cost =
+            cache.cost(path, collision_checker, *map_data, backwards_mult, strafe_mult, rotation_mult);
+        EXPECT_DOUBLE_EQ(astar_planner::pathCost(path, expected_checker, backwards_mult, strafe_mult, rotation_mult),
+                         cost);
+        return cost;
+    };
+
+    astar_planner::PathCostCache cache;
+    EXPECT_LT(check_cost(cache), std::numeric_limits<double>::max());
+    EXPECT_EQ(path.nodes.size() - 1, cache.costed());
+
+    check_cost(cache);
+    EXPECT_EQ(0, cache.costed());
+
+    // far from the path
+    draw(cv::Rect(800, 100, 50, 50));
+    costmap.processObstacleMap(costmap.updateObstacleMap(*map_data, cv::Rect()));
+    check_cost(cache);
+    EXPECT_EQ(0, cache.costed());
+
+    // near the middle of the path, within reach of the segments of the tiles around it
+    draw(cv::Rect(500, 450, 20, 10));
+    costmap.processObstacleMap(costmap.updateObstacleMap(*map_data, cv::Rect()));
+    EXPECT_LT(check_cost(cache), std::numeric_limits<double>::max());
+    EXPECT_GT(cache.costed(), 0);
+    EXPECT_LT(cache.costed(), path.nodes.size() / 2);
+
+    // on the path
+    draw(cv::Rect(600, 505, 20, 20));
+    costmap.processObstacleMap(costmap.updateObstacleMap(*map_data, cv::Rect()));
+    EXPECT_EQ(std::numeric_limits<double>::max(), check_cost(cache));
+}
+
+TEST_F(PlanningTest, test_path_cost_without_segments)
+{
+    // neither needs a plan or a map
+    const astar_planner::AStarPlanner planner;
+
+    navigation_interface::Path path;
+    EXPECT_EQ(0.0, planner.cost(path));
+    EXPECT_TRUE(planner.valid(path));
+
+    path.nodes.push_back(Eigen::Translation2d(1.0, 2.0) * Eigen::Rotation2Dd(0.5));
+    EXPECT_EQ(0.0, planner.cost(path));
+    EXPECT_TRUE(planner.valid(path));
+}
+
+TEST_F(PlanningTest, test_packed_cells)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(100, 600), cv::Point(800, 700), cv::Scalar(255), -1, cv::LINE_8);
+    cv::circle(cv_im, cv::Point(500, 470), static_cast<int>(0.3 / resolution), cv::Scalar(255), -1);
+
+    // avoid zones and a region of varying traversal cost
+    const auto traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+    cv::rectangle(*traversal_cost, cv::Point(400, 800), cv::Point(600, 900), cv::Scalar(4.0), -1, cv::LINE_8);
+    cv::Mat noise(400, 300, CV_32F);
+    cv::randu(noise, cv::Scalar(1.0), cv::Scalar(2.0));
+    noise.copyTo((*traversal_cost)(cv::Rect(600, 350, 300, 400)));
+
+    astar_planner::Costmap costmap(*map_data, robot_radius);
+    costmap.processObstacleMap();
+    costmap.traversal_cost = traversal_cost;
+
+    astar_planner::Costmap packed = costmap;
+    packed.buildCells();
+
+    auto check_cells = [&]() {
+        const astar_planner::PackedCells cells(packed);
+        std::size_t mismatches = 0;
+        for (int y = 0; y < size_y; ++y)
+        {
+            for (int x = 0; x < size_x; ++x)
+            {
+                const astar_planner::CostmapCell cell = cells(x, y);
+                if (cell.distance_to_collision != packed.distance_to_collision.at<float>(y, x) ||
+                    cell.traversal_cost != traversal_cost->at<float>(y, x))
+                    ++mismatches;
+            }
+        }
+        EXPECT_EQ(0, mismatches);
+    };
+    check_cells();
+
+    const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+    const astar_planner::CollisionChecker packed_checker(packed, offsets, conservative_radius);
+
+    // the same searches, only the layout of the cells differs
+    const astar_planner::State2D goal{900, 100};
+    const std::vector<astar_planner::State2D> starts = {{100, 900}, {950, 950}, {50, 400}, {700, 500}};
+    auto search_2d = [&](const astar_planner::CollisionChecker& checker) {
+        std::vector<double> costs;
+        astar_planner::Explore2DCache explore_cache;
+        astar_planner::updateExplore2DCache(explore_cache, goal, checker);
+        for (const astar_planner::State2D& start : starts)
+        {
+            const astar_planner::ShortestPath2D result =
+                astar_planner::shortestPath2D(start, goal, explore_cache, checker);
+            costs.push_back(result.success ? result.node->cost_so_far : -1.0);
+        }
+        return costs;
+    };
+    EXPECT_EQ(search_2d(collision_checker), search_2d(packed_checker));
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-3.0, -1.0) * Eigen::Rotation2Dd(0);
+    const Eigen::Isometry2d goal_pose = Eigen::Translation2d(2.0, -3.0) * Eigen::Rotation2Dd(M_PI / 2);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+    auto plan = [&](const astar_planner::CollisionChecker& checker) {
+        return astar_planner::hybridAStar(start, goal_pose, max_iterations, checker, linear_resolution,
+                                          angular_resolution, goal_sample_settings, backwards_mult, strafe_mult,
+                                          rotation_mult);
+    };
+
+    const astar_planner::PathResult expected = plan(collision_checker);
+    const astar_planner::PathResult result = plan(packed_checker);
+    ASSERT_TRUE(expected.success);
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(expected.iterations, result.iterations);
+    EXPECT_EQ(expected.path.front()->cost_so_far, result.path.front()->cost_so_far);
+
+    // the cells follow incremental updates of the distances
+    cv_im(cv::Rect(300, 400, 60, 60)).setTo(cv::Scalar(255));
+    const cv::Rect changed(300, 400, 60, 60);
+    cv::Mat(cv_im(changed)).copyTo(packed.obstacle_map(changed));
+    packed.processObstacleMap({changed});
+    check_cells();
+}
+
+TEST_F(PlanningTest, test_traversal_cost_map)
+{
+    hd_map::Map hd_map;
+    hd_map.info.name = "test map";
+    hd_map.info.modified.sec = 10;
+
+    hd_map::Zone zone;
+    zone.zone_type = hd_map::Zone::AVOID_ZONE;
+    for (const auto& corner : std::vector<std::pair<float, float>>{{-3, -3}, {0, -3}, {0, 0}, {-3, 0}})
+    {
+        geometry_msgs::Point32 point;
+        point.x = corner.first;
+        point.y = corner.second;
+        zone.polygon.points.push_back(point);
+    }
+    hd_map.zones.push_back(zone);
+
+    for (const auto& node : std::vector<std::pair<std::string, Eigen::Vector2d>>{
+             {"a", {2.0, 2.0}}, {"b", {6.0, 2.0}}, {"c", {6.0, 6.0}}})
+    {
+        hd_map::Node n;
+        n.id = node.first;
+        n.x = node.second.x();
+        n.y = node.second.y();
+        hd_map.nodes.push_back(n);
+    }
+    hd_map::Path path;
+    path.name = "path";
+    path.nodes = {"a", "b", "c"};
+    hd_map.paths.push_back(path);
+
+    const gridmap::MapDimensions dimensions = map_data->grid.dimensions();
+    auto map = std::make_shared<gridmap::MapData>(hd_map, dimensions);
+
+    const double avoid_zone_cost = 4.0;
+    const double path_cost = 0.2;
+    const std::shared_ptr<cv::Mat> traversal_cost =
+        astar_planner::traversalCostMap(*map, avoid_zone_cost, path_cost);
+
+    auto at = [&](const cv::Mat& costs, const double x, const double y) {
+        const Eigen::Array2i cell = dimensions.getCellIndex({x, y});
+        return costs.at<float>(cell.y(), cell.x());
+    };
+    EXPECT_NEAR(avoid_zone_cost, at(*traversal_cost, -1.5, -1.5), 1e-4);
+    EXPECT_NEAR(path_cost, at(*traversal_cost, 4.0, 2.0), 1e-4);
+    EXPECT_NEAR(path_cost, at(*traversal_cost, 6.0, 4.0), 1e-4);
+    EXPECT_EQ(1.f, at(*traversal_cost, -8.0, 8.0));
+
+    // smooth across the edge of the zone
+    const float inside = at(*traversal_cost, -0.04, -1.5);
+    const float outside = at(*traversal_cost, 0.04, -1.5);
+    EXPECT_GT(inside, outside);
+    EXPECT_LT(inside, avoid_zone_cost);
+    EXPECT_GT(outside, 1.0);
+
+    auto equal = [&](const cv::Mat& a, const cv::Mat& b) {
+        std::size_t mismatches = 0;
+        for (int y = 0; y < size_y; ++y)
+            for (int x = 0; x < size_x; ++x)
+                mismatches += a.at<float>(y, x) != b.at<float>(y, x);
+        return mismatches == 0;
+    };
+
+    const std::string cache_directory = testing::TempDir();
+    std::remove((cache_directory + "/test_map.traversal_cost").c_str());
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const std::shared_ptr<cv::Mat> written =
+        astar_planner::traversalCostMap(*map, avoid_zone_cost, path_cost, cache_directory);
+    const auto t1 = std::chrono::steady_clock::now();
+    EXPECT_TRUE(equal(*traversal_cost, *written));
+
+    // the file is used while the map has the same modification time, even though the zones moved
+    map->hd_map.zones.clear();
+    const std::shared_ptr<cv::Mat> loaded =
+        astar_planner::traversalCostMap(*map, avoid_zone_cost, path_cost, cache_directory);
+    const auto t2 = std::chrono::steady_clock::now();
+    EXPECT_TRUE(equal(*traversal_cost, *loaded));
+
+    std::cout << "built: " << std::chrono::duration<double>(t1 - t0).count()
+              << " loaded: " << std::chrono::duration<double>(t2 - t1).count() << std::endl;
+
+    map->hd_map.info.modified.sec = 11;
+    const std::shared_ptr<cv::Mat> rebuilt =
+        astar_planner::traversalCostMap(*map, avoid_zone_cost, path_cost, cache_directory);
+    EXPECT_EQ(1.f, at(*rebuilt, -1.5, -1.5));
+
+    // and for different costs
+    EXPECT_NEAR(0.5, at(*astar_planner::traversalCostMap(*map, avoid_zone_cost, 0.5, cache_directory), 4.0, 2.0),
+                1e-4);
+}
+
+TEST_F(PlanningTest, test_multiple_goals)
+{
+    cv::circle(cv_im, cv::Point(600, 500), static_cast<int>(0.3 / resolution), cv::Scalar(255), -1);
+    cv::rectangle(cv_im, cv::Point(200, 600), cv::Point(800, 650), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-3.0, -1.0) * Eigen::Rotation2Dd(0);
+    const std::vector<Eigen::Isometry2d> goals = {Eigen::Translation2d(4.0, 4.0) * Eigen::Rotation2Dd(M_PI / 2),
+                                                  Eigen::Translation2d(2.0, 0.0) * Eigen::Rotation2Dd(0),
+                                                  Eigen::Translation2d(-1.0, -4.0) * Eigen::Rotation2Dd(0)};
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    // one search per goal
+    std::size_t iterations = 0;
+    std::size_t cheapest = goals.size();
+    double cheapest_cost = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < goals.size(); ++i)
+    {
+        const astar_planner::PathResult result =
+            astar_planner::hybridAStar(start, goals[i], max_iterations, collision_checker, linear_resolution,
+                                       angular_resolution, goal_sample_settings, backwards_mult, strafe_mult,
+                                       rotation_mult);
+        iterations += result.iterations;
+        EXPECT_EQ(i == 1, result.goal_in_collision);
+        if (result.success && result.path.front()->cost_so_far < cheapest_cost)
+        {
+            cheapest = i;
+            cheapest_cost = result.path.front()->cost_so_far;
+        }
+    }
+    ASSERT_EQ(2, cheapest);
+
+    // a single search stops at the cheapest goal, leaving out the one in collision
+    const auto t0 = std::chrono::steady_clock::now();
+    const astar_planner::PathResult result =
+        astar_planner::hybridAStar(start, goals, max_iterations, collision_checker, linear_resolution,
+                                   angular_resolution, goal_sample_settings, backwards_mult, strafe_mult,
+                                   rotation_mult);
+    std::cout << "planner took: "
+              << std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
+                     .count()
+              << " iterations: " << result.iterations << " per goal: " << iterations << std::endl;
+
+    ASSERT_TRUE(result.success);
+    EXPECT_FALSE(result.goal_in_collision);
+    EXPECT_TRUE(result.goal.isApprox(goals[cheapest]));
+    EXPECT_LT(result.path.front()->cost_so_far, 1.05 * cheapest_cost);
+    EXPECT_LT(result.iterations, iterations);
+    EXPECT_EQ(start.translation().x(), result.path.back()->state.x);
+    EXPECT_EQ(start.translation().y(), result.path.back()->state.y);
+    for (const astar_planner::Node3D* node : result.path)
+        EXPECT_TRUE(collision_checker.isValid(node->state));
+
+    // a shared cache stays rooted at its own goal
+    auto explore_cache = std::make_shared<astar_planner::Explore2DCache>();
+    astar_planner::SearchOptions options;
+    options.explore_cache = explore_cache;
+    options.heuristic_mode = astar_planner::HeuristicMode::WAVEFRONT;
+    const astar_planner::PathResult cached =
+        astar_planner::hybridAStar(start, goals, max_iterations, collision_checker, linear_resolution,
+                                   angular_resolution, goal_sample_settings, backwards_mult, strafe_mult,
+                                   rotation_mult, options);
+    ASSERT_TRUE(cached.success);
+    EXPECT_NE(explore_cache, cached.explore_cache);
+    EXPECT_FALSE(explore_cache->started);
+    EXPECT_EQ(result.path.front()->cost_so_far, cached.path.front()->cost_so_far);
+
+    // and fails if every goal is in collision
+    const astar_planner::PathResult blocked =
+        astar_planner::hybridAStar(start, std::vector<Eigen::Isometry2d>{goals[1], goals[1]}, max_iterations,
+                                   collision_checker, linear_resolution, angular_resolution, goal_sample_settings,
+                                   backwards_mult, strafe_mult, rotation_mult);
+    EXPECT_FALSE(blocked.success);
+    EXPECT_TRUE(blocked.goal_in_collision);
+}
+
+TEST_F(PlanningTest, test_region_costmap)
+{
+    cv::rectangle(cv_im, cv::Point(400, 480), cv::Point(440, 720), cv::Scalar(255), -1, cv::LINE_8);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+    const auto t1 = std::chrono::steady_clock::now();
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+
+    // start and goal either side of the wall, the region leaves room to go around it
+    const Eigen::Isometry2d start = Eigen::Translation2d(-3.0, 2.0) * Eigen::Rotation2Dd(0);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(1.0, 2.0) * Eigen::Rotation2Dd(0);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    const int reach = costmap->reach(offsets);
+    EXPECT_EQ(reach, astar_planner::Costmap::reach(resolution, robot_radius, offsets));
+
+    auto regionCostmap = [&](const cv::Rect& region) {
+        const cv::Rect padded(region.x - reach, region.y - reach, region.width + 2 * reach, region.height + 2 * reach);
+        auto region_costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius, padded);
+        region_costmap->processObstacleMap();
+        region_costmap->traversal_cost = std::make_shared<cv::Mat>((*costmap->traversal_cost)(padded));
+        return region_costmap;
+    };
+
+    const cv::Rect region(200, 300, 500, 600);
+    const auto t2 = std::chrono::steady_clock::now();
+    const auto region_costmap = regionCostmap(region);
+    const auto t3 = std::chrono::steady_clock::now();
+    std::cout << "map: " << std::chrono::duration<double>(t1 - t0).count()
+              << " region: " << std::chrono::duration<double>(t3 - t2).count() << std::endl;
+
+    EXPECT_EQ(region.width + 2 * reach, region_costmap->width);
+    EXPECT_NEAR(costmap->origin_x + (region.x - reach) * resolution, region_costmap->origin_x, 1e-9);
+    EXPECT_TRUE((costmap->getCellIndex(goal.translation()) - Eigen::Array2i(region.x - reach, region.y - reach) ==
+                 region_costmap->getCellIndex(goal.translation()))
+                    .all());
+
+    // within the region the distances are those of the whole map
+    std::size_t mismatches = 0;
+    for (int y = region.y; y < region.y + region.height; ++y)
+        for (int x = region.x; x < region.x + region.width; ++x)
+            mismatches += costmap->distance_to_collision.at<float>(y, x) !=
+                          region_costmap->distance_to_collision.at<float>(y - region.y + reach, x - region.x + reach);
+    EXPECT_EQ(0, mismatches);
+
+    const astar_planner::PathResult expected =
+        astar_planner::hybridAStar(start, goal, max_iterations, collision_checker, linear_resolution,
+                                   angular_resolution, goal_sample_settings, backwards_mult, strafe_mult,
+                                   rotation_mult);
+    ASSERT_TRUE(expected.success);
+
+    const astar_planner::CollisionChecker region_checker(*region_costmap, offsets, conservative_radius);
+    const astar_planner::PathResult result =
+        astar_planner::hybridAStar(start, goal, max_iterations, region_checker, linear_resolution,
+                                   angular_resolution, goal_sample_settings, backwards_mult, strafe_mult,
+                                   rotation_mult);
+    ASSERT_TRUE(result.success);
+    EXPECT_TRUE(astar_planner::searchedWithin(result, *region_costmap,
+                                              cv::Rect(reach, reach, region.width, region.height)));
+    EXPECT_NEAR(expected.path.front()->cost_so_far, result.path.front()->cost_so_far,
+                0.01 * expected.path.front()->cost_so_far);
+    for (const astar_planner::Node3D* node : result.path)
+        EXPECT_TRUE(collision_checker.isValid(node->state));
+
+    // a complete 2D search reaches the cells around the region too, its heuristic may be lower on the whole map
+    astar_planner::SearchOptions wavefront;
+    wavefront.heuristic_mode = astar_planner::HeuristicMode::WAVEFRONT;
+    const astar_planner::PathResult complete =
+        astar_planner::hybridAStar(start, {goal}, max_iterations, region_checker, linear_resolution,
+                                   angular_resolution, goal_sample_settings, backwards_mult, strafe_mult,
+                                   rotation_mult, wavefront);
+    ASSERT_TRUE(complete.success);
+    EXPECT_FALSE(astar_planner::searchedWithin(complete, *region_costmap,
+                                               cv::Rect(reach, reach, region.width, region.height)));
+
+    // a region cut by the wall forces the search to its edge
+    const cv::Rect narrow(300, 540, 300, 120);
+    const auto narrow_costmap = regionCostmap(narrow);
+    const astar_planner::CollisionChecker narrow_checker(*narrow_costmap, offsets, conservative_radius);
+    const astar_planner::PathResult cut =
+        astar_planner::hybridAStar(start, goal, max_iterations, narrow_checker, linear_resolution,
+                                   angular_resolution, goal_sample_settings, backwards_mult, strafe_mult,
+                                   rotation_mult);
+    const cv::Rect narrow_within(reach, reach, narrow.width, narrow.height);
+    EXPECT_FALSE(cut.success && astar_planner::searchedWithin(cut, *narrow_costmap, narrow_within));
+}
+
+TEST_F(PlanningTest, test_concurrent_searches)
+{
+    cv::circle(cv_im, cv::Point(500, 470), static_cast<int>(0.3 / resolution), cv::Scalar(255), -1);
+    cv::rectangle(cv_im, cv::Point(200, 600), cv::Point(800, 650), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    auto cspace = std::make_shared<astar_planner::CSpace>(angular_resolution, offsets);
+    cspace->build(*costmap);
+    const auto primitives = std::make_shared<const astar_planner::MotionPrimitives>(
+        linear_resolution, angular_resolution, costmap->resolution, offsets);
+
+    // one checker and one set of primitives shared by all searches
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius, cspace);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    std::vector<std::pair<Eigen::Isometry2d, Eigen::Isometry2d>> requests;
+    for (const double x : {-6.0, -3.0, 0.0, 3.0})
+        for (const double y : {-4.0, 5.0})
+            requests.emplace_back(Eigen::Translation2d(-3.0, -1.0) * Eigen::Rotation2Dd(0),
+                                  Eigen::Translation2d(x, y) * Eigen::Rotation2Dd(M_PI / 2));
+
+    auto search = [&](const std::size_t i) {
+        astar_planner::SearchOptions options;
+        options.explore_cache = std::make_shared<astar_planner::Explore2DCache>();
+        options.motion_primitives = primitives;
+        return astar_planner::hybridAStar(requests[i].first, {requests[i].second}, max_iterations,
+                                          collision_checker, linear_resolution, angular_resolution,
+                                          goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options);
+    };
+
+    std::vector<double> expected(requests.size());
+    std::vector<std::size_t> expected_iterations(requests.size());
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+        const astar_planner::PathResult result = search(i);
+        ASSERT_TRUE(result.success);
+        expected[i] = result.path.front()->cost_so_far;
+        expected_iterations[i] = result.iterations;
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<double> costs(requests.size(), 0.0);
+    std::vector<std::size_t> iterations(requests.size(), 0);
+    astar_planner::parallelFor(static_cast<int>(requests.size()), [&](const int i) {
+        const astar_planner::PathResult result = search(static_cast<std::size_t>(i));
+        if (result.success)
+            costs[i] = result.path.front()->cost_so_far;
+        iterations[i] = result.iterations;
+    });
+    const auto t2 = std::chrono::steady_clock::now();
+
+    std::cout << "serial: " << std::chrono::duration<double>(t1 - t0).count()
+              << " parallel: " << std::chrono::duration<double>(t2 - t1).count() << std::endl;
+
+    // the searches only read what they share, so they find the same paths side by side
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+        EXPECT_EQ(expected[i], costs[i]);
+        EXPECT_EQ(expected_iterations[i], iterations[i]);
+    }
+}
+
+TEST_F(PlanningTest, test_plan_record)
+{
+    cv::rectangle(cv_im, cv::Point(400, 480), cv::Point(440, 720), cv::Scalar(255), -1, cv::LINE_8);
+
+    auto costmap = std::make_shared<astar_planner::Costmap>(*map_data, robot_radius);
+    costmap->processObstacleMap();
+    costmap->traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    astar_planner::PlanRecord record;
+    record.settings = {};
+    record.settings.linear_resolution = linear_resolution;
+    record.settings.angular_resolution = angular_resolution;
+    record.settings.robot_radius = robot_radius;
+    record.settings.conservative_robot_radius = conservative_radius;
+    record.settings.backwards_mult = backwards_mult;
+    record.settings.strafe_mult = strafe_mult;
+    record.settings.rotation_mult = rotation_mult;
+    record.settings.analytic_expansion_cost_tolerance = astar_planner::AnalyticExpansionSettings().cost_tolerance;
+    record.settings.max_iterations = max_iterations;
+    record.settings.heuristic_mode = static_cast<int32_t>(astar_planner::HeuristicMode::LAZY);
+    record.settings.threads = 1;
+    record.offsets = offsets;
+    record.start = Eigen::Translation2d(-3.0, 2.0) * Eigen::Rotation2Dd(0);
+    record.goals = {Eigen::Translation2d(1.0, 2.0) * Eigen::Rotation2Dd(M_PI / 2)};
+
+    const astar_planner::CollisionChecker collision_checker(*costmap, offsets, conservative_radius);
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+    astar_planner::SearchOptions options;
+    options.explore_cache = std::make_shared<astar_planner::Explore2DCache>();
+    const astar_planner::PathResult expected = astar_planner::hybridAStar(
+        record.start, record.goals, max_iterations, collision_checker, linear_resolution, angular_resolution,
+        goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options);
+    ASSERT_TRUE(expected.success);
+
+    // only the cells the search read are kept
+    const cv::Rect region = astar_planner::searchedRegion(expected, *costmap, offsets);
+    EXPECT_GT(region.area(), 0);
+    EXPECT_LT(region.area(), costmap->width * costmap->height);
+    record.setRegion(*costmap, region);
+    record.duration = 0.5;
+    record.iterations = expected.iterations;
+    record.success = expected.success;
+
+    const std::string path = testing::TempDir() + "test_plan_record.astar_plan";
+    ASSERT_TRUE(record.save(path));
+    const auto loaded = astar_planner::PlanRecord::load(path);
+    ASSERT_TRUE(loaded);
+
+    EXPECT_EQ(0, std::memcmp(&record.settings, &loaded->settings, sizeof(record.settings)));
+    EXPECT_EQ(record.offsets, loaded->offsets);
+    EXPECT_TRUE(loaded->start.isApprox(record.start));
+    ASSERT_EQ(1, loaded->goals.size());
+    EXPECT_TRUE(loaded->goals.front().isApprox(record.goals.front()));
+    EXPECT_EQ(record.origin_x, loaded->origin_x);
+    EXPECT_EQ(record.origin_y, loaded->origin_y);
+    ASSERT_EQ(record.obstacle_map.size(), loaded->obstacle_map.size());
+    std::size_t mismatches = 0;
+    for (int y = 0; y < region.height; ++y)
+        for (int x = 0; x < region.width; ++x)
+            mismatches += record.obstacle_map.at<uint8_t>(y, x) != loaded->obstacle_map.at<uint8_t>(y, x) ||
+                          record.traversal_cost.at<float>(y, x) != loaded->traversal_cost.at<float>(y, x);
+    EXPECT_EQ(0, mismatches);
+    EXPECT_EQ(record.iterations, loaded->iterations);
+
+    // the region alone leads the search to the same path
+    const auto replay_costmap = loaded->costmap();
+    EXPECT_EQ(region.width, replay_costmap->width);
+    const astar_planner::PathResult result = loaded->replay(*replay_costmap);
+    ASSERT_TRUE(result.success);
+    EXPECT_NEAR(expected.path.front()->cost_so_far, result.path.front()->cost_so_far, 1e-9);
+    EXPECT_EQ(expected.iterations, result.iterations);
+
+    // anything else is not a record
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "not a plan record";
+    }
+    EXPECT_FALSE(astar_planner::PlanRecord::load(path));
+    EXPECT_FALSE(astar_planner::PlanRecord::load(testing::TempDir() + "missing.astar_plan"));
+}
+
+TEST_F(PlanningTest, test_tracked_changes)
+{
+    cv::rectangle(cv_im, cv::Point(200, 200), cv::Point(2000, 300), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(200, 400), cv::Point(900, 500), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(100, 600), cv::Point(800, 700), cv::Scalar(255), -1, cv::LINE_8);
+    cv::rectangle(cv_im, cv::Point(0, 0), cv::Point(140, 500), cv::Scalar(255), -1, cv::LINE_8);
+
+    const auto traversal_cost = std::make_shared<cv::Mat>(size_y, size_x, CV_32F, cv::Scalar(1.0));
+
+    const Eigen::Isometry2d start = Eigen::Translation2d(-5.5, -8) * Eigen::Rotation2Dd(M_PI);
+    const Eigen::Isometry2d goal = Eigen::Translation2d(8, 8) * Eigen::Rotation2Dd(M_PI);
+
+    const navigation_interface::PathPlanner::GoalSampleSettings goal_sample_settings = {0, 0, 0, 0};
+
+    // mark the tiles under a change to the grid as the layered map would
+    auto draw = [&](const cv::Rect& rect, const uint8_t value) {
+        cv_im(rect).setTo(cv::Scalar(value));
+        const int tile_size = gridmap::OccupancyGrid::TILE_SIZE;
+        std::vector<std::size_t> tiles;
+        for (int tile_y = rect.y / tile_size; tile_y <= (rect.y + rect.height - 1) / tile_size; ++tile_y)
+            for (int tile_x = rect.x / tile_size; tile_x <= (rect.x + rect.width - 1) / tile_size; ++tile_x)
+                tiles.push_back(static_cast<std::size_t>(tile_y * map_data->grid.tilesX() + tile_x));
+        map_data->grid.setTilesChanged(tiles);
+    };
+
+    for (const auto mode : {astar_planner::HeuristicMode::LAZY, astar_planner::HeuristicMode::WAVEFRONT})
+    {
+        // the costmap is kept and only the changed regions are reported to the cache
+        astar_planner::Costmap costmap(*map_data, robot_radius);
+        costmap.processObstacleMap();
+        costmap.traversal_cost = traversal_cost;
+
+        auto explore_cache = std::make_shared<astar_planner::Explore2DCache>();
+        explore_cache->track_changes = true;
+
+        const Eigen::Array2i start_cell = costmap.getCellIndex(start.translation());
+        const Eigen::Array2i goal_cell = costmap.getCellIndex(goal.translation());
+        const astar_planner::State2D start_2d{start_cell.x(), start_cell.y()};
+        const astar_planner::State2D goal_2d{goal_cell.x(), goal_cell.y()};
+
+        // plans with the cache and compares its cost-to-go of the start with that of a fresh 2D search
+        auto plan = [&]() {
+            const astar_planner::CollisionChecker collision_checker(costmap, offsets, conservative_radius);
+            astar_planner::SearchOptions options;
+            options.explore_cache = explore_cache;
+            options.heuristic_mode = mode;
+            const astar_planner::PathResult astar_result = astar_planner::hybridAStar(
+                start, {goal}, max_iterations, collision_checker, linear_resolution, angular_resolution,
+                goal_sample_settings, backwards_mult, strafe_mult, rotation_mult, options);
+            EXPECT_TRUE(astar_result.success);
+            EXPECT_TRUE(explore_cache->changed_regions.empty());
+
+            astar_planner::Explore2DCache fresh;
+            astar_planner::updateExplore2DCache(fresh, goal_2d, collision_checker);
+            const astar_planner::ShortestPath2D expected =
+                astar_planner::shortestPath2D(start_2d, goal_2d, fresh, collision_checker);
+            const astar_planner::ShortestPath2D cached =
+                astar_planner::shortestPath2D(start_2d, goal_2d, *explore_cache, collision_checker);
+            ASSERT_TRUE(expected.success);
+            ASSERT_TRUE(cached.success);
+            EXPECT_NEAR(expected.node->cost_so_far, cached.node->cost_so_far,
+                        1e-6 * std::max(1.0, expected.node->cost_so_far));
+        };
+
+        auto update = [&]() {
+            const std::vector<cv::Rect> changed = costmap.updateObstacleMap(*map_data, cv::Rect());
+            const std::vector<cv::Rect> processed = costmap.processObstacleMap(changed);
+            explore_cache->changed_regions.insert(explore_cache->changed_regions.end(), processed.begin(),
+                                                  processed.end());
+        };
+
+        plan();
+
+        // narrow the corridor the route goes through
+        draw(cv::Rect(500, 300, 60, 45), 255);
+        update();
+        plan();
+
+        // and clear it again
+        draw(cv::Rect(500, 300, 60, 45), 0);
+        update();
+        plan();
+    }
+}
+
 int main(int argc, char** argv)
 {
     testing::InitGoogleTest(&argc, argv);
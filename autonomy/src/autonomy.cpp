@@ -516,7 +516,12 @@ void Autonomy::pathPlannerThread(const Eigen::Isometry2d& goal,
         const auto now = ros::SteadyTime::now();
         {
             const auto t0 = std::chrono::steady_clock::now();
-            result = path_planner_->plan(robot_pose, goal, goal_sample_settings);
+
+            // the planner may use up to a cycle after the map update to improve its path, the map update does not
+            // count against it
+            const auto deadline = t0 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                           std::chrono::duration<double>(rate.expectedCycleTime().toSec()));
+            result = path_planner_->plan(robot_pose, goal, goal_sample_settings, deadline);
 
             const double plan_duration =
                 std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - t0)
@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
 #include <mutex>
@@ -80,6 +81,12 @@ struct AABB
 template <class CellType> class Grid2D
 {
   public:
+    // The grid is split into square tiles which remember the version at which their cells last changed
+    // so users can find the parts of the grid which changed since they last read it
+    // The setters of the derived grids give the tile of a cell they change a new version. Writes through cells(),
+    // cell() and copyTo are not tracked, their writers call setTilesChanged
+    static const int TILE_SIZE = 64;
+
     explicit Grid2D(const MapDimensions& map_dims);
 
     Grid2D(const Grid2D& grid, const AABB& bb);
@@ -133,11 +140,62 @@ template <class CellType> class Grid2D
         return std::unique_lock<std::recursive_mutex>(mutex_);
     }
 
+    int tilesX() const
+    {
+        return (map_dimensions_.size().x() + TILE_SIZE - 1) / TILE_SIZE;
+    }
+
+    int tilesY() const
+    {
+        return (map_dimensions_.size().y() + TILE_SIZE - 1) / TILE_SIZE;
+    }
+
+    // cells covered by a tile, clipped to the grid
+    AABB tileBounds(const int tile_x, const int tile_y) const
+    {
+        const Eigen::Array2i start(tile_x * TILE_SIZE, tile_y * TILE_SIZE);
+        return {start, (start + TILE_SIZE).min(map_dimensions_.size()) - start};
+    }
+
+    // latest version of any tile
+    uint64_t version() const
+    {
+        return version_;
+    }
+
+    uint64_t tileVersion(const int tile_x, const int tile_y) const
+    {
+        return tile_versions_[static_cast<std::size_t>(tile_y * tilesX() + tile_x)];
+    }
+
+    // versions of all tiles, tile_y * tilesX() + tile_x
+    const std::vector<uint64_t>& tileVersions() const
+    {
+        return tile_versions_;
+    }
+
+    // Gives the tiles (tile_y * tilesX() + tile_x) a new version
+    void setTilesChanged(const std::vector<std::size_t>& tiles);
+
+    // Gives the tiles overlapping bb a new version
+    void setTilesChanged(const AABB& bb);
+
   protected:
+    void setCellChanged(const std::size_t cell_index)
+    {
+        const int size_x = map_dimensions_.size().x();
+        const int x = static_cast<int>(cell_index) % size_x;
+        const int y = static_cast<int>(cell_index) / size_x;
+        tile_versions_[static_cast<std::size_t>((y / TILE_SIZE) * tilesX() + x / TILE_SIZE)] = ++version_;
+    }
+
     MapDimensions map_dimensions_;
 
     mutable std::recursive_mutex mutex_;
     std::vector<CellType> cells_;
+
+    uint64_t version_;
+    std::vector<uint64_t> tile_versions_;
 };
 }  // namespace gridmap
 
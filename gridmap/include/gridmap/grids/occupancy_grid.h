@@ -41,42 +41,42 @@ class OccupancyGrid : public Grid2D<uint8_t>
 
     void setFree(const std::size_t cell_index)
     {
-        cells_[cell_index] = FREE;
+        set(cell_index, FREE);
     }
 
     void setFree(const Eigen::Array2i& cell_index)
     {
-        cells_[static_cast<std::size_t>(index(cell_index))] = FREE;
+        set(static_cast<std::size_t>(index(cell_index)), FREE);
     }
 
     void setUnknown(const std::size_t cell_index)
     {
-        cells_[cell_index] = UNKNOWN;
+        set(cell_index, UNKNOWN);
     }
 
     void setUnknown(const Eigen::Array2i& cell_index)
     {
-        cells_[static_cast<std::size_t>(index(cell_index))] = UNKNOWN;
+        set(static_cast<std::size_t>(index(cell_index)), UNKNOWN);
     }
 
     void setConflict(const std::size_t cell_index)
     {
-        cells_[cell_index] = CONFLICT;
+        set(cell_index, CONFLICT);
     }
 
     void setConflict(const Eigen::Array2i& cell_index)
     {
-        cells_[static_cast<std::size_t>(index(cell_index))] = CONFLICT;
+        set(static_cast<std::size_t>(index(cell_index)), CONFLICT);
     }
 
     void setOccupied(const std::size_t cell_index)
     {
-        cells_[cell_index] = OCCUPIED;
+        set(cell_index, OCCUPIED);
     }
 
     void setOccupied(const Eigen::Array2i& cell_index)
     {
-        cells_[static_cast<std::size_t>(index(cell_index))] = OCCUPIED;
+        set(static_cast<std::size_t>(index(cell_index)), OCCUPIED);
     }
 
     void merge(const OccupancyGrid& map);
@@ -86,6 +86,16 @@ class OccupancyGrid : public Grid2D<uint8_t>
     nav_msgs::OccupancyGrid toMsg() const;
 
     nav_msgs::OccupancyGrid toMsg(const AABB& bb) const;
+
+  private:
+    void set(const std::size_t cell_index, const uint8_t value)
+    {
+        if (cells_[cell_index] != value)
+        {
+            cells_[cell_index] = value;
+            setCellChanged(cell_index);
+        }
+    }
 };
 }  // namespace gridmap
 
@@ -45,10 +45,24 @@ class ProbabilityGrid : public Grid2D<double>
 
     virtual ~ProbabilityGrid() = default;
 
+    inline void update(const std::size_t cell_index, const double log_odds)
+    {
+        setLogOdds(cell_index,
+                   std::max(clamping_thres_min_log_, std::min(clamping_thres_max_log_, cells_[cell_index] + log_odds)));
+    }
+
     inline void update(const Eigen::Array2i& cell_index, const double log_odds)
     {
-        const auto it = static_cast<std::size_t>(index(cell_index));
-        cells_[it] = std::max(clamping_thres_min_log_, std::min(clamping_thres_max_log_, cells_[it] + log_odds));
+        update(static_cast<std::size_t>(index(cell_index)), log_odds);
+    }
+
+    // The tile of the cell only gets a new version if the cell becomes occupied or free
+    inline void setLogOdds(const std::size_t cell_index, const double log_odds)
+    {
+        const bool was_occupied = occupied(cell_index);
+        cells_[cell_index] = log_odds;
+        if (occupied(cell_index) != was_occupied)
+            setCellChanged(cell_index);
     }
 
     inline bool occupied(const std::size_t& cell_index) const
@@ -63,17 +77,17 @@ class ProbabilityGrid : public Grid2D<double>
 
     void setMinThres(const Eigen::Array2i& cell_index)
     {
-        cells_[static_cast<std::size_t>(index(cell_index))] = clamping_thres_min_log_;
+        setLogOdds(static_cast<std::size_t>(index(cell_index)), clamping_thres_min_log_);
     }
 
     void setMaxThres(const Eigen::Array2i& cell_index)
     {
-        cells_[static_cast<std::size_t>(index(cell_index))] = clamping_thres_min_log_;
+        setLogOdds(static_cast<std::size_t>(index(cell_index)), clamping_thres_min_log_);
     }
 
     void setOccThres(const Eigen::Array2i& cell_index)
     {
-        cells_[static_cast<std::size_t>(index(cell_index))] = occ_prob_thres_log_;
+        setLogOdds(static_cast<std::size_t>(index(cell_index)), occ_prob_thres_log_);
     }
 
     double ocupancyThres() const
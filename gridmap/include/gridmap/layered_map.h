@@ -6,6 +6,7 @@
 #include <gridmap/map_data.h>
 #include <hd_map/Map.h>
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -33,8 +34,21 @@ class LayeredMap
     }
 
   private:
+    // The tile versions of the base map layer followed by those of the other layers, taken before they draw
+    // A layer which does not track its changes or failed to draw leaves its versions empty
+    typedef std::vector<std::vector<uint64_t>> LayerTileVersions;
+
+    // Tile versions of all layers, empty for those which do not track their changes
+    LayerTileVersions tileVersions() const;
+
+    // Gives the tiles overlapping bb a new version if the tiles of a layer changed since they were last drawn
+    void updateTileVersions(const AABB& bb, const LayerTileVersions& versions);
+
     std::shared_ptr<MapData> map_data_;
 
+    // tile versions of the layers the tiles of the grid were last drawn from, empty if unknown
+    LayerTileVersions drawn_tile_versions_;
+
     // static map layer
     std::shared_ptr<BaseMapLayer> base_map_layer_;
 
@@ -35,6 +35,8 @@ class BaseMapLayer : public Layer
         return bool(map_);
     }
 
+    virtual bool tileVersions(std::vector<uint64_t>& versions) const override;
+
   private:
     int lethal_threshold_;
     std::shared_ptr<OccupancyGrid> map_;
@@ -10,7 +10,9 @@
 #include <tf2_ros/buffer.h>
 #include <yaml-cpp/yaml.h>
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace gridmap
 {
@@ -33,6 +35,14 @@ class Layer
     virtual bool clear() = 0;
     virtual bool clearRadius(const Eigen::Vector2i& cell_index, const int cell_radius) = 0;
 
+    // Versions of the tiles (Grid2D::TILE_SIZE) of the cells the layer draws from, which change whenever what the
+    // layer draws within the tile does
+    // Layers which do not track their changes return false, everything they draw is then taken as changed
+    virtual bool tileVersions(std::vector<uint64_t>&) const
+    {
+        return false;
+    }
+
     void setMap(const hd_map::Map& hd_map, const nav_msgs::OccupancyGrid& map_data)
     {
         ROS_INFO_STREAM("Updating map: " << name());
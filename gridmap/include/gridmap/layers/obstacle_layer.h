@@ -32,6 +32,9 @@ class ObstacleLayer : public Layer
     virtual bool clear() override;
     virtual bool clearRadius(const Eigen::Vector2i& cell_index, const int cell_radius) override;
 
+    // the tiles in which cells of the probability grid became occupied or free
+    virtual bool tileVersions(std::vector<uint64_t>& versions) const override;
+
   private:
     bool isDataOk() const;
 
@@ -3,6 +3,7 @@
 
 #include <Eigen/Geometry>
 
+#include <gridmap/grids/probability_grid.h>
 #include <ros/ros.h>
 
 #include <algorithm>
@@ -14,23 +15,17 @@ namespace gridmap
 class AddLogCost
 {
   public:
-    AddLogCost(double* map_data, const double log_cost, const double clamping_thres_min_log,
-               const double clamping_thres_max_log)
-        : map_data_(map_data), log_cost_(log_cost), clamping_thres_min_log_(clamping_thres_min_log),
-          clamping_thres_max_log_(clamping_thres_max_log)
+    AddLogCost(ProbabilityGrid& map_data, const double log_cost) : map_data_(map_data), log_cost_(log_cost)
     {
     }
     inline void operator()(unsigned int offset, const int)
     {
-        map_data_[offset] =
-            std::max(clamping_thres_min_log_, std::min(clamping_thres_max_log_, map_data_[offset] + log_cost_));
+        map_data_.update(static_cast<std::size_t>(offset), log_cost_);
     }
 
   private:
-    double* map_data_;
+    ProbabilityGrid& map_data_;
     double log_cost_;
-    double clamping_thres_min_log_;
-    double clamping_thres_max_log_;
 };
 
 inline int sign(int x)
@@ -3,8 +3,12 @@
 namespace gridmap
 {
 
+template <class CellType> const int Grid2D<CellType>::TILE_SIZE;
+
 template <class CellType>
-Grid2D<CellType>::Grid2D(const MapDimensions& map_dims) : map_dimensions_(map_dims), cells_(map_dims.cells(), 0)
+Grid2D<CellType>::Grid2D(const MapDimensions& map_dims)
+    : map_dimensions_(map_dims), cells_(map_dims.cells(), 0), version_(0),
+      tile_versions_(static_cast<std::size_t>(tilesX() * tilesY()), 0)
 {
 }
 
@@ -13,7 +17,8 @@ Grid2D<CellType>::Grid2D(const Grid2D& grid, const AABB& bb)
     : map_dimensions_(grid.dimensions().resolution(),
                       {grid.dimensions().origin().x() + bb.roi_start.x() * grid.dimensions().resolution(),
                        grid.dimensions().origin().y() + bb.roi_start.y() * grid.dimensions().resolution()},
-                      bb.roi_size)
+                      bb.roi_size),
+      version_(0), tile_versions_(static_cast<std::size_t>(tilesX() * tilesY()), 0)
 {
     ROS_ASSERT(((bb.roi_start + bb.roi_size) <= grid.dimensions().size()).all());
 
@@ -60,6 +65,36 @@ template <class CellType> void Grid2D<CellType>::copyTo(Grid2D<CellType>& grid,
     }
 }
 
+template <class CellType> void Grid2D<CellType>::setTilesChanged(const std::vector<std::size_t>& tiles)
+{
+    if (tiles.empty())
+        return;
+
+    ++version_;
+    for (const std::size_t tile : tiles)
+    {
+        ROS_ASSERT(tile < tile_versions_.size());
+        tile_versions_[tile] = version_;
+    }
+}
+
+template <class CellType> void Grid2D<CellType>::setTilesChanged(const AABB& bb)
+{
+    if ((bb.roi_size <= 0).any())
+        return;
+
+    const int tile_x_min = bb.roi_start.x() / TILE_SIZE;
+    const int tile_y_min = bb.roi_start.y() / TILE_SIZE;
+    const int tile_x_max = (bb.roi_start.x() + bb.roi_size.x() - 1) / TILE_SIZE;
+    const int tile_y_max = (bb.roi_start.y() + bb.roi_size.y() - 1) / TILE_SIZE;
+
+    std::vector<std::size_t> tiles;
+    for (int tile_y = tile_y_min; tile_y <= tile_y_max; ++tile_y)
+        for (int tile_x = tile_x_min; tile_x <= tile_x_max; ++tile_x)
+            tiles.push_back(static_cast<std::size_t>(tile_y * tilesX() + tile_x));
+    setTilesChanged(tiles);
+}
+
 template class Grid2D<uint8_t>;
 template class Grid2D<double>;
 }  // namespace gridmap
@@ -1,6 +1,8 @@
 #include <gridmap/layered_map.h>
 #include <ros/assert.h>
 
+#include <limits>
+
 namespace gridmap
 {
 
@@ -14,12 +16,25 @@ bool LayeredMap::update()
 {
     ROS_ASSERT(map_data_);
 
+    LayerTileVersions versions = tileVersions();
+
     // copy from base map
-    bool success = base_map_layer_->draw(map_data_->grid);
+    auto& grid = map_data_->grid;
+    bool success = base_map_layer_->draw(grid);
+    if (!success)
+        versions[0].clear();
 
     // update from layers
-    auto& grid = map_data_->grid;
-    success &= std::all_of(layers_.begin(), layers_.end(), [&grid](const auto& layer) { return layer->update(grid); });
+    for (std::size_t i = 0; i < layers_.size(); ++i)
+    {
+        if (!layers_[i]->update(grid))
+        {
+            success = false;
+            versions[i + 1].clear();
+        }
+    }
+
+    updateTileVersions({{0, 0}, grid.dimensions().size()}, versions);
 
     return success;
 }
@@ -29,17 +44,101 @@ bool LayeredMap::update(const AABB& bb)
     ROS_ASSERT(map_data_);
     ROS_ASSERT(((bb.roi_start + bb.roi_size) <= map_data_->grid.dimensions().size()).all());
 
+    LayerTileVersions versions = tileVersions();
+
     // copy from base map
-    bool success = base_map_layer_->draw(map_data_->grid, bb);
+    auto& grid = map_data_->grid;
+    bool success = base_map_layer_->draw(grid, bb);
+    if (!success)
+        versions[0].clear();
 
     // update from layers
-    auto& grid = map_data_->grid;
-    success &= std::all_of(layers_.begin(), layers_.end(),
-                           [&grid, &bb](const auto& layer) { return layer->update(grid, bb); });
+    for (std::size_t i = 0; i < layers_.size(); ++i)
+    {
+        if (!layers_[i]->update(grid, bb))
+        {
+            success = false;
+            versions[i + 1].clear();
+        }
+    }
+
+    updateTileVersions(bb, versions);
 
     return success;
 }
 
+LayeredMap::LayerTileVersions LayeredMap::tileVersions() const
+{
+    // taken before drawing, so a layer changing while it is drawn is seen again by the next update
+    LayerTileVersions versions(layers_.size() + 1);
+    if (!base_map_layer_->tileVersions(versions[0]))
+        versions[0].clear();
+    for (std::size_t i = 0; i < layers_.size(); ++i)
+    {
+        if (!layers_[i]->tileVersions(versions[i + 1]))
+            versions[i + 1].clear();
+    }
+    return versions;
+}
+
+void LayeredMap::updateTileVersions(const AABB& bb, const LayerTileVersions& versions)
+{
+    auto& grid = map_data_->grid;
+
+    // cppcheck-suppress unreadVariable
+    const auto lock = grid.getLock();
+
+    const std::size_t tiles = static_cast<std::size_t>(grid.tilesX() * grid.tilesY());
+    drawn_tile_versions_.resize(versions.size());
+
+    const int tile_x_min = bb.roi_start.x() / OccupancyGrid::TILE_SIZE;
+    const int tile_y_min = bb.roi_start.y() / OccupancyGrid::TILE_SIZE;
+    const int tile_x_max = (bb.roi_start.x() + bb.roi_size.x() - 1) / OccupancyGrid::TILE_SIZE;
+    const int tile_y_max = (bb.roi_start.y() + bb.roi_size.y() - 1) / OccupancyGrid::TILE_SIZE;
+
+    std::vector<std::size_t> changed;
+    for (int tile_y = tile_y_min; tile_y <= tile_y_max; ++tile_y)
+    {
+        for (int tile_x = tile_x_min; tile_x <= tile_x_max; ++tile_x)
+        {
+            const std::size_t tile = static_cast<std::size_t>(tile_y * grid.tilesX() + tile_x);
+
+            // the cells of a tile partly outside of bb were not all drawn, so it stays changed for the next update
+            const AABB bounds = grid.tileBounds(tile_x, tile_y);
+            const bool inside = (bounds.roi_start >= bb.roi_start).all() &&
+                                (bounds.roi_start + bounds.roi_size <= bb.roi_start + bb.roi_size).all();
+
+            bool tile_changed = false;
+            for (std::size_t i = 0; i < versions.size(); ++i)
+            {
+                std::vector<uint64_t>& drawn = drawn_tile_versions_[i];
+                if (versions[i].size() != tiles || drawn.size() != tiles || drawn[tile] != versions[i][tile])
+                    tile_changed = true;
+
+                if (!inside)
+                    continue;
+
+                // a layer without versions is compared again once it has them
+                if (versions[i].size() != tiles)
+                {
+                    drawn.clear();
+                }
+                else
+                {
+                    if (drawn.size() != tiles)
+                        drawn.assign(tiles, std::numeric_limits<uint64_t>::max());
+                    drawn[tile] = versions[i][tile];
+                }
+            }
+
+            if (tile_changed)
+                changed.push_back(tile);
+        }
+    }
+
+    grid.setTilesChanged(changed);
+}
+
 void LayeredMap::clear()
 {
     ROS_ASSERT(map_data_);
@@ -71,6 +170,7 @@ void LayeredMap::setMap(const hd_map::Map& hd_map, const nav_msgs::OccupancyGrid
         layer->setMap(hd_map, map_data);
     }
     map_data_ = std::make_shared<MapData>(hd_map, base_map_layer_->dimensions());
+    drawn_tile_versions_.clear();
     update();
 }
 }  // namespace gridmap
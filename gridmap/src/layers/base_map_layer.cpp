@@ -51,6 +51,17 @@ bool BaseMapLayer::update(OccupancyGrid& grid, const AABB& bb) const
     return true;
 }
 
+bool BaseMapLayer::tileVersions(std::vector<uint64_t>& versions) const
+{
+    std::lock_guard<std::timed_mutex> g(map_mutex_);
+    if (!map_)
+        return false;
+    // cppcheck-suppress unreadVariable
+    const auto lock = map_->getLock();
+    versions = map_->tileVersions();
+    return true;
+}
+
 void BaseMapLayer::onInitialize(const YAML::Node& parameters)
 {
     lethal_threshold_ = parameters["lethal_threshold"].as<int>(50);
@@ -62,8 +62,7 @@ bool LaserData::processData(const sensor_msgs::LaserScan::ConstPtr& msg, const E
 
     {
         auto _lock = map_data_->getLock();
-        AddLogCost marker(map_data_->cells().data(), miss_probability_log_, map_data_->clampingThresMinLog(),
-                          map_data_->clampingThresMaxLog());
+        AddLogCost marker(*map_data_, miss_probability_log_);
         for (size_t i = 0; i < msg->ranges.size(); i++)
         {
             double range = static_cast<double>(msg->ranges[i]);
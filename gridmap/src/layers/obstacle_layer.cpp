@@ -257,6 +257,7 @@ bool ObstacleLayer::clear()
     // cppcheck-suppress unreadVariable
     auto lock = probability_grid_->getLock();
     std::fill(probability_grid_->cells().begin(), probability_grid_->cells().end(), 0.0);
+    probability_grid_->setTilesChanged(AABB{{0, 0}, probability_grid_->dimensions().size()});
 
     return true;
 }
@@ -275,6 +276,24 @@ bool ObstacleLayer::clearRadius(const Eigen::Vector2i& cell_index, const int cel
     cv::circle(cv_im, cv::Point(cell_index.x(), cell_index.y()), cell_radius,
                cv::Scalar(probability_grid_->clampingThresMinLog()), -1);
 
+    const Eigen::Array2i circle_min = (Eigen::Array2i(cell_index.x(), cell_index.y()) - cell_radius).max(0);
+    const Eigen::Array2i circle_max =
+        (Eigen::Array2i(cell_index.x(), cell_index.y()) + cell_radius + 1).min(probability_grid_->dimensions().size());
+    probability_grid_->setTilesChanged(AABB{circle_min, circle_max - circle_min});
+
+    return true;
+}
+
+bool ObstacleLayer::tileVersions(std::vector<uint64_t>& versions) const
+{
+    std::lock_guard<std::timed_mutex> g(map_mutex_);
+
+    if (!probability_grid_)
+        return false;
+
+    // cppcheck-suppress unreadVariable
+    const auto lock = probability_grid_->getLock();
+    versions = probability_grid_->tileVersions();
     return true;
 }
 
@@ -436,7 +455,7 @@ void ObstacleLayer::timeDecayThread(const double frequency, const double alpha_d
             for (int index = index_start; index < index_end; ++index)
             {
                 if (std::abs(pg->cell(index)) > 0.1)
-                    pg->cell(index) -= pg->cell(index) * alpha_decay;
+                    pg->setLogOdds(index, pg->cell(index) - pg->cell(index) * alpha_decay);
             }
         }
     };
@@ -453,7 +472,7 @@ void ObstacleLayer::timeDecayThread(const double frequency, const double alpha_d
             const int index_start = pg->dimensions().size().x() * y + top_left_x;
             const int index_end = index_start + size_x;
             for (int index = index_start; index < index_end; ++index)
-                pg->cell(index) = 0;
+                pg->setLogOdds(index, 0);
         }
     };
 
@@ -5,7 +5,9 @@
 #include <navigation_interface/types/path.h>
 #include <yaml-cpp/yaml.h>
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 namespace navigation_interface
 {
@@ -41,6 +43,34 @@ class PathPlanner
     virtual Result plan(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal,
                         const GoalSampleSettings& sample) = 0;
 
+    // Plans with a wall-clock budget, planners which can improve their path use the time left until deadline
+    virtual Result plan(const Eigen::Isometry2d& start, const Eigen::Isometry2d& goal, const GoalSampleSettings& sample,
+                        const std::chrono::steady_clock::time_point&)
+    {
+        return plan(start, goal, sample);
+    }
+
+    // Plans to whichever of goals is cheapest to reach, e.g. candidate poses within a goal region
+    // Planners which cannot search for several goals at once plan to each of them in turn
+    virtual Result plan(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                        const GoalSampleSettings& sample)
+    {
+        Result best{Outcome::FAILED, 0, {}};
+        for (const Eigen::Isometry2d& goal : goals)
+        {
+            Result result = plan(start, goal, sample);
+            if (result.outcome != Outcome::FAILED && (best.outcome == Outcome::FAILED || result.cost < best.cost))
+                best = std::move(result);
+        }
+        return best;
+    }
+
+    virtual Result plan(const Eigen::Isometry2d& start, const std::vector<Eigen::Isometry2d>& goals,
+                        const GoalSampleSettings& sample, const std::chrono::steady_clock::time_point&)
+    {
+        return plan(start, goals, sample);
+    }
+
     virtual bool valid(const Path& path) const = 0;
     virtual double cost(const Path& path) const = 0;
 